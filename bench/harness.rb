@@ -0,0 +1,129 @@
+# Copyright (C) 2013 MongoDB, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+require 'json'
+require 'mongo'
+
+module Bench
+
+  # Runs benchmarks and collects their results as one JSON document per
+  # line, so results can be compared across driver versions.
+  #
+  # Each benchmark is warmed up, then timed over several iterations and
+  # reported with its median time, operations per second and, for
+  # benchmarks of a payload, throughput.
+  #
+  # @example
+  #   harness = Harness.new($stdout)
+  #   harness.measure('wire', 'query/small', :ops => 1000) { query.serialize }
+  class Harness
+
+    # The default number of timed iterations of a benchmark.
+    DEFAULT_ITERATIONS = 10
+
+    # The default number of untimed iterations run first.
+    DEFAULT_WARMUP = 2
+
+    # Initializes a new harness.
+    #
+    # @param output [IO] Where the results are written.
+    # @param opts [Hash] The options of the run.
+    #
+    # @option opts [Integer] :iterations The number of timed iterations.
+    # @option opts [Integer] :warmup The number of untimed iterations.
+    # @option opts [Regexp] :filter Only run the benchmarks whose full name
+    #   matches.
+    #
+    # @return [Harness] The harness instance.
+    def initialize(output, opts = {})
+      @output     = output
+      @iterations = opts[:iterations] || DEFAULT_ITERATIONS
+      @warmup     = opts[:warmup] || DEFAULT_WARMUP
+      @filter     = opts[:filter]
+      @results    = []
+    end
+
+    # @return [Array<Hash>] The results of the benchmarks run so far.
+    attr_reader :results
+
+    # Runs and reports a benchmark. The block makes +ops+ operations per
+    # call.
+    #
+    # @param suite [String] The suite of the benchmark.
+    # @param name [String] The name of the benchmark.
+    # @param opts [Hash] The options of the benchmark.
+    #
+    # @option opts [Integer] :ops (1) The operations per iteration.
+    # @option opts [Integer] :bytes The bytes processed per iteration.
+    # @option opts [Integer] :iterations Overrides the timed iterations.
+    #
+    # @return [Hash, nil] The result, or nil if the benchmark was filtered.
+    def measure(suite, name, opts = {})
+      return if @filter && "#{suite}/#{name}" !~ @filter
+      @warmup.times { yield }
+      times = Array.new(opts[:iterations] || @iterations) { time { yield } }
+      report(suite, name, times, opts)
+    end
+
+    private
+
+    # Times one call of the block.
+    #
+    # @return [Float] The elapsed time in seconds.
+    def time
+      start = Mongo::Pool::Socket::Base.monotonic_time
+      yield
+      Mongo::Pool::Socket::Base.monotonic_time - start
+    end
+
+    # Builds, writes and keeps the result of a benchmark.
+    #
+    # @param suite [String] The suite of the benchmark.
+    # @param name [String] The name of the benchmark.
+    # @param times [Array<Float>] The time of each iteration.
+    # @param opts [Hash] The options of the benchmark.
+    #
+    # @return [Hash] The result.
+    def report(suite, name, times, opts)
+      median = times.sort[times.size / 2]
+      ops = opts[:ops] || 1
+      result = environment.merge(
+        'suite' => suite,
+        'name' => name,
+        'iterations' => times.size,
+        'median_ms' => (median * 1000).round(3),
+        'min_ms' => (times.min * 1000).round(3),
+        'ops_per_sec' => (ops / median).round(1)
+      )
+      if opts[:bytes]
+        result['mb_per_sec'] = (opts[:bytes] / median / 1_048_576).round(2)
+      end
+      @output.puts(result.to_json)
+      @output.flush
+      @results << result
+      result
+    end
+
+    # Get the details of the environment the benchmarks run in.
+    #
+    # @return [Hash] The driver and ruby versions and the serializers.
+    def environment
+      @environment ||= {
+        'driver' => Mongo::VERSION,
+        'ruby' => "#{RUBY_ENGINE} #{RUBY_VERSION}",
+        'native' => $LOADED_FEATURES.any? { |f| f =~ %r{mongo/native\.} }
+      }
+    end
+  end
+end
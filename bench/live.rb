@@ -0,0 +1,175 @@
+# Copyright (C) 2013 MongoDB, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+module Bench
+
+  # End to end benchmarks against a live server: find one latency, a scan
+  # of a large collection, bulk insert throughput and concurrent reads.
+  #
+  # The benchmarks use the +bench+ database, whose collections they drop
+  # and fill as needed.
+  class Live
+
+    # The address of the server when none is provided.
+    DEFAULT_ADDRESS = '127.0.0.1:27017'
+
+    # The number of documents in the scanned collection when not provided.
+    DEFAULT_SCAN_SIZE = 1_000_000
+
+    # The number of documents bulk inserted per iteration.
+    INSERT_SIZE = 100_000
+
+    # The number of queries per iteration of the latency benchmarks.
+    QUERIES = 1000
+
+    # The number of threads of the concurrent benchmark when not provided.
+    DEFAULT_THREADS = 8
+
+    # Initializes the live benchmarks.
+    #
+    # @param harness [Harness] The harness to run them with.
+    # @param opts [Hash] The options of the run.
+    #
+    # @option opts [String] :address The address of the server.
+    # @option opts [Integer] :scan_size The documents to scan.
+    # @option opts [Integer] :threads The threads of the concurrent
+    #   benchmark.
+    #
+    # @return [Live] The benchmarks.
+    def initialize(harness, opts = {})
+      @harness   = harness
+      @address   = opts[:address] || DEFAULT_ADDRESS
+      @scan_size = opts[:scan_size] || DEFAULT_SCAN_SIZE
+      @threads   = opts[:threads] || DEFAULT_THREADS
+    end
+
+    # Runs every live benchmark, unless the server cannot be reached.
+    #
+    # @return [true, false] Whether the benchmarks were run.
+    def run
+      @client = Mongo::Client.new([@address], :database => 'bench',
+                                              :server_selection_timeout => 2000)
+      @client.select_node
+      find_one
+      concurrent
+      bulk_insert
+      scan
+      true
+    rescue Mongo::Client::NoNode
+      warn("No server at #{@address}, skipping the live benchmarks.")
+      false
+    end
+
+    private
+
+    # Benchmarks the latency of queries for a single document.
+    def find_one
+      collection = seed('find_one', 1)
+      @harness.measure('live', 'find_one', :ops => QUERIES) do
+        QUERIES.times { first(collection) }
+      end
+    end
+
+    # Benchmarks queries for a single document from many threads at once.
+    def concurrent
+      collection = seed('find_one', 1)
+      @harness.measure('live', "find_one/#{@threads}_threads",
+                       :ops => QUERIES * @threads) do
+        Array.new(@threads) do
+          Thread.new { QUERIES.times { first(collection) } }
+        end.each(&:join)
+      end
+    end
+
+    # Benchmarks inserting documents in bulk into an empty collection.
+    def bulk_insert
+      collection = @client['bulk_insert']
+      @harness.measure('live', 'bulk_insert', :ops => INSERT_SIZE,
+                                              :iterations => 5) do
+        drop(collection.name)
+        collection.bulk_insert(documents(INSERT_SIZE))
+      end
+    end
+
+    # Benchmarks iterating over every document of a large collection, as
+    # hashes and as BSON bytes.
+    def scan
+      collection = seed('scan', @scan_size)
+      { 'scan' => {}, 'scan/raw' => { :raw => true } }.each do |name, opts|
+        @harness.measure('live', name, :ops => @scan_size,
+                                       :iterations => 3) do
+          Mongo::Scope.new(collection, {}, opts).each {}
+        end
+      end
+    end
+
+    # Get the first document of a collection.
+    #
+    # @param collection [Mongo::Collection] The collection.
+    #
+    # @return [Hash] The document.
+    def first(collection)
+      Mongo::Scope.new(collection, {}, :limit => -1).to_a.first
+    end
+
+    # Get a collection with the provided number of documents, inserting
+    # them if the collection does not hold as many already.
+    #
+    # @param name [String] The name of the collection.
+    # @param size [Integer] The number of documents.
+    #
+    # @return [Mongo::Collection] The collection.
+    def seed(name, size)
+      collection = @client[name]
+      unless command(:count => name)['n'].to_i == size
+        drop(name)
+        collection.bulk_insert(documents(size))
+      end
+      collection
+    end
+
+    # Get a stream of documents to insert.
+    #
+    # @param size [Integer] The number of documents.
+    #
+    # @return [Enumerator] The documents.
+    def documents(size)
+      Enumerator.new do |yielder|
+        size.times do |i|
+          yielder << { '_id' => i, 'name' => 'Emily', 'tags' => %w(a b c) }
+        end
+      end
+    end
+
+    # Drop a collection of the bench database, if it exists.
+    #
+    # @param name [String] The name of the collection.
+    def drop(name)
+      command(:drop => name)
+    end
+
+    # Run a command on the bench database.
+    #
+    # @param selector [Hash] The command.
+    #
+    # @return [Hash] The reply of the command.
+    def command(selector)
+      query = Mongo::Protocol::Query.new('bench', '$cmd', selector,
+                                         :limit => -1)
+      @client.with_node do |connection|
+        connection.send_and_receive(1, query)[0][:docs].to_a.first
+      end
+    end
+  end
+end
@@ -0,0 +1,150 @@
+# Copyright (C) 2013 MongoDB, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+require 'stringio'
+
+module Bench
+
+  # Microbenchmarks of the wire protocol: serializing each message type
+  # and decoding replies from an in-memory buffer, for small, large and
+  # many document payloads. No server is needed.
+  class Wire
+
+    # The payloads each message is benchmarked with, as the documents of
+    # the message and the number of operations per iteration.
+    PAYLOADS = {
+      'small' => [[{ 'name' => 'Emily', 'age' => 30 }], 10_000],
+      'large' => [[{ 'pad' => 'x' * 1_048_576 }], 100],
+      'many' => [Array.new(1000) { |i| { '_id' => i, 'name' => 'Tyler' } }, 20]
+    }.freeze
+
+    # Initializes the wire benchmarks.
+    #
+    # @param harness [Harness] The harness to run them with.
+    #
+    # @return [Wire] The benchmarks.
+    def initialize(harness)
+      @harness = harness
+      @buffer  = Mongo::Protocol::WriteBuffer.new
+    end
+
+    # Runs every wire benchmark. Messages of a single document are only
+    # benchmarked with the small and large payloads.
+    def run
+      PAYLOADS.each do |size, (documents, ops)|
+        serialize("insert/#{size}", ops) { insert(documents) }
+        deserialize("reply/#{size}", documents, ops)
+        next unless documents.size == 1
+        serialize("query/#{size}", ops) { query(documents.first) }
+        serialize("update/#{size}", ops) { update(documents.first) }
+        serialize("delete/#{size}", ops) { delete(documents.first) }
+      end
+      serialize('get_more', 10_000) { get_more }
+      serialize('kill_cursors/many', 1000) { kill_cursors }
+    end
+
+    private
+
+    # Benchmarks serializing a message into a reused write buffer, as a
+    # connection does.
+    #
+    # @param name [String] The name of the benchmark.
+    # @param ops [Integer] The messages serialized per iteration.
+    # @yieldreturn [Mongo::Protocol::Message] A new message.
+    def serialize(name, ops)
+      message = yield
+      @buffer.reset
+      message.serialize(@buffer)
+      bytes = @buffer.segments.map(&:bytesize).reduce(0, :+) * ops
+      @harness.measure('wire', "serialize/#{name}", :ops => ops,
+                                                    :bytes => bytes) do
+        ops.times do
+          @buffer.reset
+          yield.serialize(@buffer)
+        end
+      end
+    end
+
+    # Benchmarks decoding a reply from memory, eagerly, lazily with every
+    # document accessed, and as raw BSON.
+    #
+    # @param name [String] The name of the benchmark.
+    # @param documents [Array<Hash>] The documents of the reply.
+    # @param ops [Integer] The replies decoded per iteration.
+    def deserialize(name, documents, ops)
+      bytes = reply(documents)
+      { 'eager' => {}, 'lazy' => { :lazy => true },
+        'raw' => { :raw => true } }.each do |mode, opts|
+        @harness.measure('wire', "deserialize/#{name}/#{mode}",
+                         :ops => ops, :bytes => bytes.bytesize * ops) do
+          ops.times do
+            Mongo::Protocol::Reply.deserialize(StringIO.new(bytes), opts)
+              .documents.each {}
+          end
+        end
+      end
+    end
+
+    # Builds the bytes of a reply with the provided documents.
+    #
+    # @param documents [Array<Hash>] The documents of the reply.
+    #
+    # @return [String] The reply, header included.
+    def reply(documents)
+      data = [0, 0, 0, documents.size].pack('l<q<l<l<')
+      data << documents.map(&:to_bson).join
+      [data.bytesize + 16, 0, 0, 1].pack('l<l<l<l<') << data
+    end
+
+    # @param documents [Array<Hash>] The documents to insert.
+    #
+    # @return [Mongo::Protocol::Insert] A new insert message.
+    def insert(documents)
+      Mongo::Protocol::Insert.new('bench', 'wire', documents)
+    end
+
+    # @param selector [Hash] The query selector.
+    #
+    # @return [Mongo::Protocol::Query] A new query message.
+    def query(selector)
+      Mongo::Protocol::Query.new('bench', 'wire', selector, :limit => -1)
+    end
+
+    # @param document [Hash] The fields to set.
+    #
+    # @return [Mongo::Protocol::Update] A new update message.
+    def update(document)
+      Mongo::Protocol::Update.new('bench', 'wire', { '_id' => 1 },
+                                  '$set' => document)
+    end
+
+    # @param selector [Hash] The delete selector.
+    #
+    # @return [Mongo::Protocol::Delete] A new delete message.
+    def delete(selector)
+      Mongo::Protocol::Delete.new('bench', 'wire', selector)
+    end
+
+    # @return [Mongo::Protocol::GetMore] A new get more message.
+    def get_more
+      Mongo::Protocol::GetMore.new('bench', 'wire', 100, 1 << 40)
+    end
+
+    # @return [Mongo::Protocol::KillCursors] A new kill cursors message
+    #   for a thousand cursors.
+    def kill_cursors
+      Mongo::Protocol::KillCursors.new(Array.new(1000) { |i| i + 1 })
+    end
+  end
+end
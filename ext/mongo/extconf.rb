@@ -0,0 +1,5 @@
+require 'mkmf'
+
+$CFLAGS << ' -Wall -g -std=c99'
+
+create_makefile('mongo/native')
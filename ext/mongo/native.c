@@ -0,0 +1,274 @@
+/*
+ * Copyright (C) 2013 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Native implementations of the wire protocol serialization strategies in
+ * Mongo::Protocol::Serializers. Loading this extension replaces the pure
+ * Ruby methods, which pack and unpack through temporary arrays and strings,
+ * with versions that encode straight into the message buffer and decode
+ * without intermediate objects.
+ */
+
+#include <stdint.h>
+#include <ruby.h>
+
+static ID id_read;
+static ID id_masks;
+static ID id_packed;
+static ID id_sets;
+static ID id_all;
+static ID id_bytes;
+static VALUE flags_class;
+
+/*
+ * Write a little endian 32 bit integer into the provided bytes.
+ */
+static void put_int32(char *bytes, int32_t value)
+{
+  uint32_t v = (uint32_t) value;
+  bytes[0] = (char) (v & 0xFF);
+  bytes[1] = (char) ((v >> 8) & 0xFF);
+  bytes[2] = (char) ((v >> 16) & 0xFF);
+  bytes[3] = (char) ((v >> 24) & 0xFF);
+}
+
+/*
+ * Write a little endian 64 bit integer into the provided bytes.
+ */
+static void put_int64(char *bytes, int64_t value)
+{
+  put_int32(bytes, (int32_t) (value & 0xFFFFFFFF));
+  put_int32(bytes + 4, (int32_t) ((uint64_t) value >> 32));
+}
+
+/*
+ * Read a little endian 32 bit integer from the provided bytes.
+ */
+static int32_t get_int32(const char *bytes)
+{
+  const unsigned char *b = (const unsigned char *) bytes;
+  return (int32_t) ((uint32_t) b[0] |
+                    ((uint32_t) b[1] << 8) |
+                    ((uint32_t) b[2] << 16) |
+                    ((uint32_t) b[3] << 24));
+}
+
+/*
+ * Read a little endian 64 bit integer from the provided bytes.
+ */
+static int64_t get_int64(const char *bytes)
+{
+  uint64_t low = (uint32_t) get_int32(bytes);
+  uint64_t high = (uint32_t) get_int32(bytes + 4);
+  return (int64_t) (low | (high << 32));
+}
+
+/*
+ * Read exactly length bytes from the io, raising an EOFError when the stream
+ * ends early.
+ */
+static const char *read_bytes(VALUE io, long length, VALUE *holder)
+{
+  VALUE bytes = rb_funcall(io, id_read, 1, LONG2FIX(length));
+  if (NIL_P(bytes) || RSTRING_LEN(bytes) != length) {
+    rb_raise(rb_eEOFError, "end of stream reading %ld bytes", length);
+  }
+  *holder = bytes;
+  return RSTRING_PTR(bytes);
+}
+
+/*
+ * Header.serialize(buffer, [length, request_id, response_to, op_code])
+ */
+static VALUE header_serialize(VALUE self, VALUE buffer, VALUE value)
+{
+  char bytes[16];
+  int i;
+  Check_Type(value, T_ARRAY);
+  if (RARRAY_LEN(value) != 4) {
+    rb_raise(rb_eArgError, "a header consists of 4 integers");
+  }
+  for (i = 0; i < 4; i++) {
+    put_int32(bytes + i * 4, (int32_t) NUM2LL(rb_ary_entry(value, i)));
+  }
+  return rb_str_cat(buffer, bytes, 16);
+}
+
+/*
+ * Header.deserialize(io)
+ */
+static VALUE header_deserialize(VALUE self, VALUE io)
+{
+  VALUE holder;
+  const char *bytes = read_bytes(io, 16, &holder);
+  VALUE header = rb_ary_new2(4);
+  int i;
+  for (i = 0; i < 4; i++) {
+    rb_ary_push(header, INT2NUM(get_int32(bytes + i * 4)));
+  }
+  RB_GC_GUARD(holder);
+  return header;
+}
+
+/*
+ * CString.serialize(buffer, value)
+ */
+static VALUE cstring_serialize(VALUE self, VALUE buffer, VALUE value)
+{
+  StringValue(value);
+  rb_str_cat(buffer, RSTRING_PTR(value), RSTRING_LEN(value));
+  return rb_str_cat(buffer, "", 1);
+}
+
+/*
+ * Zero.serialize(buffer, value)
+ */
+static VALUE zero_serialize(VALUE self, VALUE buffer, VALUE value)
+{
+  return rb_str_cat(buffer, "\0\0\0\0", 4);
+}
+
+/*
+ * Int32.serialize(buffer, value)
+ */
+static VALUE int32_serialize(VALUE self, VALUE buffer, VALUE value)
+{
+  char bytes[4];
+  put_int32(bytes, (int32_t) NUM2LL(value));
+  return rb_str_cat(buffer, bytes, 4);
+}
+
+/*
+ * Int32.serialize_at(buffer, offset, value)
+ */
+static VALUE int32_serialize_at(VALUE self, VALUE buffer, VALUE offset,
+                                VALUE value)
+{
+  long position = NUM2LONG(offset);
+  rb_str_modify(buffer);
+  if (position < 0 || position + 4 > RSTRING_LEN(buffer)) {
+    rb_raise(rb_eIndexError, "offset %ld out of buffer bounds", position);
+  }
+  put_int32(RSTRING_PTR(buffer) + position, (int32_t) NUM2LL(value));
+  return buffer;
+}
+
+/*
+ * Int32.deserialize(io)
+ */
+static VALUE int32_deserialize(VALUE self, VALUE io)
+{
+  VALUE holder;
+  VALUE value = INT2NUM(get_int32(read_bytes(io, 4, &holder)));
+  RB_GC_GUARD(holder);
+  return value;
+}
+
+/*
+ * Int64.serialize(buffer, value)
+ */
+static VALUE int64_serialize(VALUE self, VALUE buffer, VALUE value)
+{
+  char bytes[8];
+  put_int64(bytes, (int64_t) NUM2LL(value));
+  return rb_str_cat(buffer, bytes, 8);
+}
+
+/*
+ * Int64.deserialize(io)
+ */
+static VALUE int64_deserialize(VALUE self, VALUE io)
+{
+  VALUE holder;
+  VALUE value = LL2NUM(get_int64(read_bytes(io, 8, &holder)));
+  RB_GC_GUARD(holder);
+  return value;
+}
+
+/*
+ * BitVector#serialize(buffer, value)
+ *
+ * Flags and the common flag lists carry their packed bytes already, any
+ * other list is combined into the bits of one of the vector's flags.
+ */
+static VALUE bit_vector_serialize(VALUE self, VALUE buffer, VALUE value)
+{
+  VALUE masks;
+  VALUE packed;
+  int32_t bits = 0;
+  long i;
+  if (rb_obj_is_kind_of(value, flags_class)) {
+    return rb_str_append(buffer, rb_ivar_get(value, id_bytes));
+  }
+  Check_Type(value, T_ARRAY);
+  packed = rb_hash_lookup2(rb_ivar_get(self, id_packed), value, Qnil);
+  if (!NIL_P(packed)) {
+    return rb_str_append(buffer, packed);
+  }
+  masks = rb_ivar_get(self, id_masks);
+  for (i = 0; i < RARRAY_LEN(value); i++) {
+    bits |= (int32_t) NUM2LL(rb_hash_fetch(masks, rb_ary_entry(value, i)));
+  }
+  value = rb_ary_entry(rb_ivar_get(self, id_sets), bits);
+  return rb_str_append(buffer, rb_ivar_get(value, id_bytes));
+}
+
+/*
+ * BitVector#deserialize(io)
+ *
+ * Looks up the frozen flags of the vector, without allocating.
+ */
+static VALUE bit_vector_deserialize(VALUE self, VALUE io)
+{
+  VALUE holder;
+  int32_t bits = get_int32(read_bytes(io, 4, &holder));
+  bits &= (int32_t) NUM2LL(rb_ivar_get(self, id_all));
+  RB_GC_GUARD(holder);
+  return rb_ary_entry(rb_ivar_get(self, id_sets), bits);
+}
+
+void Init_native(void)
+{
+  VALUE header = rb_path2class("Mongo::Protocol::Serializers::Header");
+  VALUE cstring = rb_path2class("Mongo::Protocol::Serializers::CString");
+  VALUE zero = rb_path2class("Mongo::Protocol::Serializers::Zero");
+  VALUE int32 = rb_path2class("Mongo::Protocol::Serializers::Int32");
+  VALUE int64 = rb_path2class("Mongo::Protocol::Serializers::Int64");
+  VALUE bit_vector =
+    rb_path2class("Mongo::Protocol::Serializers::BitVector");
+
+  id_read = rb_intern("read");
+  id_masks = rb_intern("@masks");
+  id_packed = rb_intern("@packed");
+  id_sets = rb_intern("@sets");
+  id_all = rb_intern("@all");
+  id_bytes = rb_intern("@bytes");
+  flags_class =
+    rb_path2class("Mongo::Protocol::Serializers::BitVector::Flags");
+  rb_global_variable(&flags_class);
+
+  rb_define_singleton_method(header, "serialize", header_serialize, 2);
+  rb_define_singleton_method(header, "deserialize", header_deserialize, 1);
+  rb_define_singleton_method(cstring, "serialize", cstring_serialize, 2);
+  rb_define_singleton_method(zero, "serialize", zero_serialize, 2);
+  rb_define_singleton_method(int32, "serialize", int32_serialize, 2);
+  rb_define_singleton_method(int32, "serialize_at", int32_serialize_at, 3);
+  rb_define_singleton_method(int32, "deserialize", int32_deserialize, 1);
+  rb_define_singleton_method(int64, "serialize", int64_serialize, 2);
+  rb_define_singleton_method(int64, "deserialize", int64_deserialize, 1);
+  rb_define_method(bit_vector, "serialize", bit_vector_serialize, 2);
+  rb_define_method(bit_vector, "deserialize", bit_vector_deserialize, 1);
+}
@@ -1,5 +1,6 @@
 require 'bson'
 require 'mongo/errors'
+require 'mongo/monitoring'
 require 'mongo/client'
 require 'mongo/cluster'
 require 'mongo/collection'
@@ -7,7 +8,10 @@ require 'mongo/database'
 require 'mongo/node'
 require 'mongo/pool'
 require 'mongo/protocol'
+require 'mongo/read_preference'
+require 'mongo/result_cache'
 require 'mongo/scope'
 require 'mongo/uri'
 require 'mongo/version'
+require 'mongo/write_pipeline'
 require 'mongo/cursor'
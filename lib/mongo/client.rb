@@ -23,10 +23,20 @@ module Mongo
   # @since 2.0.0
   class Client
 
+    # The options that only apply to the client and not to its cluster, so
+    # a client derived with +#with+ that changes nothing else can share the
+    # cluster.
+    #
+    # @since 2.0.0
+    CLIENT_OPTIONS = [:database, :read, :write].freeze
+
     # @return [ Mongo::Cluster ] The cluster of nodes for the client.
     attr_reader :cluster
     # @return [ Hash ] The configuration options.
     attr_reader :options
+    # @return [ Mongo::ResultCache, nil ] The cache of query results, if
+    #   one is configured.
+    attr_reader :result_cache
 
     # Determine if this client is equivalent to another object.
     #
@@ -78,16 +88,62 @@ module Mongo
     # @example Instantiate a client for a replica set.
     #   Mongo::Client.new([ '127.0.0.1:27017', '127.0.0.1:27021' ])
     #
+    # @example Instantiate a client connected before it returns.
+    #   Mongo::Client.new([ '127.0.0.1:27017' ], :bootstrap => true)
+    #
     # @param [ Array<String> ] addresses The array of server addresses in the
     #   form of host:port.
     # @param [ Hash ] options The options to be used by the client.
     #
+    # @option options [ true, false ] :bootstrap Whether to bootstrap the
+    #   cluster before returning, and again after a fork.
+    # @option options [ Integer ] :result_cache_size The size in bytes of
+    #   the cache for the results of scopes that ask to be cached. No
+    #   results are cached without it.
+    #
     # @since 2.0.0
     def initialize(addresses, options = {})
-      @cluster = Cluster.new(addresses)
-      @options = options
-      db = options[:database]
-      use(db) if db
+      @cluster = Cluster.new(addresses, options)
+      if options[:result_cache_size]
+        @result_cache = ResultCache.new(options[:result_cache_size])
+      end
+      configure(options)
+      bootstrap if options[:bootstrap]
+    end
+
+    # Connect to the cluster now rather than on the first operation: the
+    # nodes are resolved and checked in parallel, and the +:min_pool_size+
+    # connections of each node are opened, so the first operations run as
+    # fast as the ones that follow.
+    #
+    # @example Bootstrap the client.
+    #   client.bootstrap
+    #
+    # @return [ Mongo::Client ] The client.
+    #
+    # @since 2.0.0
+    def bootstrap
+      cluster.bootstrap
+      self
+    end
+
+    # Reset the client in a process forked from the one that used it, such
+    # as a worker of a preforking server, before it is used. The
+    # connections inherited from the parent process are forgotten without
+    # being closed, and the client is bootstrapped again when it was
+    # created with the +:bootstrap+ option. Clients sharing the cluster of
+    # this one are reset as well.
+    #
+    # @example Reset the client in a worker.
+    #   fork { client.after_fork }
+    #
+    # @return [ Mongo::Client ] The client.
+    #
+    # @since 2.0.0
+    def after_fork
+      cluster.after_fork
+      bootstrap if options[:bootstrap]
+      self
     end
 
     # Get an inspection of the client as a string.
@@ -121,6 +177,10 @@ module Mongo
     # options of this client. Useful for one-offs to change specific options
     # without altering the original client.
     #
+    # When only client options change, such as the read preference or write
+    # concern, the new client shares the cluster of this one, with its
+    # connection pools and monitor. Otherwise it gets a cluster of its own.
+    #
     # @example Get a client with changed options.
     #   client.with(:read => :primary_preferred)
     #
@@ -130,7 +190,79 @@ module Mongo
     #
     # @since 2.0.0
     def with(new_options = {})
-      Client.new(cluster.addresses.dup, options.merge(new_options))
+      merged = options.merge(new_options)
+      if (new_options.keys - CLIENT_OPTIONS).empty?
+        dup.send(:configure, merged)
+      else
+        Client.new(cluster.addresses.dup, merged)
+      end
+    end
+
+    # Check out a connection to a node that can serve the provided read
+    # preference, yield it, and check it back into the node's pool when the
+    # block finishes.
+    #
+    # @example Execute a query on a node.
+    #   client.with_node(read) do |connection|
+    #     connection.write(query)
+    #   end
+    #
+    # @param [ Object ] read The read preference for the operation.
+    # @param [ Hash ] options The connection options, as for
+    #   +Node#with_connection+.
+    #
+    # @raise [ Mongo::Client::NoNode ] If the cluster has no operable nodes.
+    #
+    # @return [ Object ] The result of the block.
+    #
+    # @since 2.0.0
+    def with_node(read = nil, options = {}, &block)
+      select_node(read).with_connection(options, &block)
+    end
+
+    # Select a node that can serve the provided read preference.
+    #
+    # @api private
+    #
+    # @example Select a node.
+    #   client.select_node(read)
+    #
+    # @param [ Mongo::ReadPreference, Hash, Symbol, nil ] read The read
+    #   preference for the operation. Nil selects the primary, as writes
+    #   need.
+    #
+    # @raise [ Mongo::Client::NoNode ] If no operable node is eligible.
+    #
+    # @return [ Mongo::Node ] The selected node.
+    #
+    # @since 2.0.0
+    def select_node(read = nil)
+      cluster.select_node(ReadPreference.get(read)) || raise(NoNode.new)
+    end
+
+    # Get the read preference for this client. If no option was provided,
+    # reads go to the primary.
+    #
+    # @example Get the client read preference.
+    #   client.read_preference
+    #
+    # @return [ Mongo::ReadPreference ] The read preference.
+    #
+    # @since 2.0.0
+    def read_preference
+      @read_preference ||= ReadPreference.get(options[:read])
+    end
+
+    # Whether the client is connected to a sharded cluster.
+    #
+    # @example Is the client connected to mongos?
+    #   client.mongos?
+    #
+    # @return [ true, false ] If the nodes are mongos nodes.
+    #
+    # @since 2.0.0
+    def mongos?
+      cluster.mongos?
     end
 
     # Get the write concern for this client. If no option was provided, then a
@@ -169,6 +301,28 @@ module Mongo
       end
     end
 
+    # Exception that is raised when no node in the cluster is available to
+    # execute an operation on.
+    #
+    # @since 2.0.0
+    class NoNode < DriverError
+
+      # The message does not need to be dynamic, so is held in a constant.
+      #
+      # @since 2.0.0
+      MESSAGE = 'No operable node is available in the cluster.'
+
+      # Instantiate the new exception.
+      #
+      # @example Instantiate the exception.
+      #   NoNode.new
+      #
+      # @since 2.0.0
+      def initialize
+        super(MESSAGE)
+      end
+    end
+
     class << self
 
       # Gets a new client given the provided uri connection string.
@@ -176,14 +330,18 @@ module Mongo
       # @example Get a client from the connection string.
       #   Mongo::Client.connect("mongodb://127.0.0.1:27017/testdb?w=3")
       #
+      # @example Get a client connected before it returns.
+      #   Mongo::Client.connect(uri, :bootstrap => true)
+      #
       # @param [ String ] connection_string The connection string.
+      # @param [ Hash ] options Options merged over the uri options.
       #
       # @see http://docs.mongodb.org/manual/reference/connection-string/
       #
       # @since 2.0.0
-      def connect(connection_string)
+      def connect(connection_string, options = {})
         uri = URI.new(connection_string)
-        client = new(uri.nodes, uri.options)
+        client = new(uri.nodes, uri.options.merge(options))
         database = uri.database
         client.use(database) if database
         client
@@ -207,5 +365,26 @@ module Mongo
     def database
       @database || raise(NoDatabase.new)
     end
+
+    # Set the options of the client, dropping the read preference and write
+    # concern worked out from the previous ones. The database in use is
+    # kept unless the options name another one.
+    #
+    # @api private
+    #
+    # @param [ Hash ] options The options to be used by the client.
+    #
+    # @return [ Mongo::Client ] The client.
+    #
+    # @since 2.0.0
+    def configure(options)
+      @options = options
+      @read_preference = nil
+      @write_concern = nil
+      db = options[:database] || (@database && @database.name)
+      @database = nil
+      use(db) if db
+      self
+    end
   end
 end
@@ -12,18 +12,33 @@
 # See the License for the specific language governing permissions and
 # limitations under the License.
 
+require 'mongo/cluster/topology'
+require 'mongo/cluster/monitor'
+
 module Mongo
 
   # Represents a group of nodes on the server side, either as a single node, a
   # replica set, or a single or multiple mongos.
   #
+  # The state of the nodes is kept up to date by a monitor in the
+  # background, which also discovers the replica set members that were not
+  # among the seed addresses.
+  #
   # @since 2.0.0
   class Cluster
 
+    # The default time in milliseconds to wait for an eligible node before
+    # giving up on selecting one.
+    #
+    # @since 2.0.0
+    DEFAULT_SERVER_SELECTION_TIMEOUT = 30_000
+
     # @return [ Array<String> ] The provided seed addresses.
     attr_reader :addresses
     # @return [ Hash ] The options hash.
     attr_reader :options
+    # @return [ Mongo::Cluster::Monitor ] The monitor of the cluster.
+    attr_reader :monitor
 
     # Determine if this cluster of nodes is equal to another object. Checks the
     # nodes currently in the cluster, not what was configured.
@@ -41,10 +56,13 @@ module Mongo
       addresses == other.addresses
     end
 
-    # Add a node to the cluster with the provided address. Useful in
+    # Add a node to the cluster with the provided address. Used in
     # auto-discovery of new nodes when an existing node executes an ismaster
     # and potentially non-configured nodes were included.
     #
+    # The list of nodes is replaced rather than changed in place, so it can
+    # be read while the monitor adds to it.
+    #
     # @example Add the node for the address to the cluster.
     #   cluster.add('127.0.0.1:27018')
     #
@@ -55,9 +73,9 @@ module Mongo
     # @since 2.0.0
     def add(address)
       unless addresses.include?(address)
-        node = Node.new(self, address, options)
+        node = Node.new(self, address, @node_options)
         addresses.push(address)
-        @nodes.push(node)
+        @nodes += [node]
         node
       end
     end
@@ -74,7 +92,11 @@ module Mongo
     def initialize(addresses, options = {})
       @addresses = addresses
       @options = options
-      @nodes = addresses.map { |address| Node.new(self, address, options) }
+      @node_options = share_ssl_context(options)
+      @nodes = addresses.map do |address|
+        Node.new(self, address, @node_options)
+      end
+      @monitor = Monitor.new(self, options)
     end
 
     # Get a list of node candidates from the cluster that can have operations
@@ -89,5 +111,229 @@ module Mongo
     def nodes
       @nodes.select { |node| node.operable? }
     end
+
+    # Get the topology last published by the monitor.
+    #
+    # @example Get the topology.
+    #   cluster.topology
+    #
+    # @return [ Mongo::Cluster::Topology ] The topology snapshot.
+    #
+    # @since 2.0.0
+    def topology
+      monitor.topology
+    end
+
+    # Select a node for an operation with the provided read preference from
+    # the topology, starting the monitor on first use. When no node is
+    # eligible, waits for the monitor to rescan the cluster until the server
+    # selection timeout has passed.
+    #
+    # @example Select a node to read from.
+    #   cluster.select_node(Mongo::ReadPreference.new(:nearest))
+    #
+    # @param [ Mongo::ReadPreference ] read The read preference.
+    #
+    # @return [ Mongo::Node, nil ] The selected node, if any is eligible.
+    #
+    # @since 2.0.0
+    def select_node(read)
+      member = until_selected do |members|
+        read.select_node(members, local_threshold)
+      end
+      member.node if member
+    end
+
+    # Select every node an operation with the provided read preference may
+    # be sent to, waiting for one to be eligible like +select_node+.
+    #
+    # @example Select the secondaries to spread reads over.
+    #   cluster.select_nodes(Mongo::ReadPreference.new(:secondary))
+    #
+    # @param [ Mongo::ReadPreference ] read The read preference.
+    #
+    # @return [ Array<Mongo::Node> ] The eligible nodes, if any.
+    #
+    # @since 2.0.0
+    def select_nodes(read)
+      selected = until_selected do |members|
+        eligible = read.select_nodes(members, local_threshold)
+        eligible unless eligible.empty?
+      end
+      selected ? selected.map(&:node) : []
+    end
+
+    # Whether the cluster is made of mongos nodes.
+    #
+    # @example Is the cluster sharded?
+    #   cluster.mongos?
+    #
+    # @return [ true, false ] If an operable node is a mongos.
+    #
+    # @since 2.0.0
+    def mongos?
+      topology.mongos?
+    end
+
+    # Refresh every node of the cluster, adding and then refreshing the
+    # hosts and passives they report until no new node is found. The nodes
+    # of each round are refreshed in parallel, so a scan takes as long as
+    # the slowest node rather than all of them together.
+    #
+    # @api private
+    #
+    # @example Scan the cluster.
+    #   cluster.scan!
+    #
+    # @return [ Array<Mongo::Node> ] The operable nodes.
+    #
+    # @since 2.0.0
+    def scan!
+      scanned = []
+      until (pending = @nodes - scanned).empty?
+        refreshed = in_parallel(pending) { |node| node.refresh! }
+        pending.zip(refreshed) { |node, operable| discover(node) if operable }
+        scanned.concat(pending)
+      end
+      nodes
+    end
+
+    # Connect to the cluster before the first operation needs it: wait for
+    # the first scan of the monitor, which resolves and connects to every
+    # node in parallel, then open the +:min_pool_size+ connections of each
+    # node that could be reached.
+    #
+    # @example Bootstrap the cluster.
+    #   cluster.bootstrap
+    #
+    # @return [ Mongo::Cluster ] The cluster.
+    #
+    # @since 2.0.0
+    def bootstrap
+      monitor.wait_for_topology(server_selection_timeout)
+      in_parallel(nodes) { |node| node.warm }
+      self
+    end
+
+    # Reset the cluster in a process forked from the one that used it. The
+    # connections and queued cursors of the nodes, and the kept SSL
+    # sessions, belong to the parent process and are forgotten, and the
+    # monitor, whose thread did not survive the fork, starts again on first
+    # use.
+    #
+    # @example Reset the cluster in a forked process.
+    #   cluster.after_fork
+    #
+    # @return [ Mongo::Cluster ] The cluster.
+    #
+    # @since 2.0.0
+    def after_fork
+      @nodes.each(&:after_fork)
+      context = @node_options[:ssl_context]
+      context.clear if context
+      self
+    end
+
+    # Take a node that failed an operation out of the topology until the
+    # monitor has rescanned the cluster.
+    #
+    # @example Invalidate a node.
+    #   cluster.invalidate(node)
+    #
+    # @param [ Mongo::Node ] node The node that failed.
+    #
+    # @since 2.0.0
+    def invalidate(node)
+      monitor.invalidate(node)
+    end
+
+    # Get the latency window for node selection.
+    #
+    # @return [ Numeric ] The time in milliseconds a node may be slower than
+    #   the fastest eligible node and still be selected.
+    #
+    # @since 2.0.0
+    def local_threshold
+      options[:local_threshold] || ReadPreference::DEFAULT_LOCAL_THRESHOLD
+    end
+
+    # Get the time to wait for an eligible node.
+    #
+    # @return [ Float ] The server selection timeout in seconds.
+    #
+    # @since 2.0.0
+    def server_selection_timeout
+      (options[:server_selection_timeout] ||
+        DEFAULT_SERVER_SELECTION_TIMEOUT) / 1000.0
+    end
+
+    private
+
+    # Yield the members of the topology, starting the monitor on first use,
+    # until the block selects something. While nothing is selected, waits
+    # for the monitor to rescan the cluster until the server selection
+    # timeout has passed.
+    #
+    # @api private
+    #
+    # @yieldparam [ Array<Mongo::Cluster::Topology::Member> ] members The
+    #   snapshots of the operable nodes.
+    # @yieldreturn [ Object, nil ] The selection, or nil if none.
+    #
+    # @return [ Object, nil ] The selection, if any was made in time.
+    #
+    # @since 2.0.0
+    def until_selected
+      deadline = Pool::Socket::Base.monotonic_time + server_selection_timeout
+      current = monitor.start.topology
+      loop do
+        selected = yield(current.members)
+        remaining = deadline - Pool::Socket::Base.monotonic_time
+        return selected if selected || remaining <= 0
+        current = monitor.wait_for_scan(current.generation, remaining)
+      end
+    end
+
+    # Yield each node on a thread of its own, unless there is only one.
+    #
+    # @api private
+    #
+    # @param [ Array<Mongo::Node> ] nodes The nodes.
+    #
+    # @return [ Array<Object> ] The result of the block for each node.
+    #
+    # @since 2.0.0
+    def in_parallel(nodes, &block)
+      return nodes.map(&block) if nodes.size < 2
+      nodes.map { |node| Thread.new(node, &block) }.map(&:value)
+    end
+
+    # Get the options for the nodes, with one SSL context for all of them
+    # when SSL options are provided, so that certificates are loaded once
+    # and TLS sessions can be resumed by any new connection.
+    #
+    # @api private
+    #
+    # @param [ Hash ] options The cluster options.
+    #
+    # @return [ Hash ] The node options.
+    #
+    # @since 2.0.0
+    def share_ssl_context(options)
+      context = Pool::Socket::SSLContext.get(options)
+      context ? options.merge(:ssl_context => context) : options
+    end
+
+    # Add the hosts and passives reported by a node to the cluster.
+    #
+    # @api private
+    #
+    # @param [ Mongo::Node ] node The refreshed node.
+    #
+    # @since 2.0.0
+    def discover(node)
+      hosts = node.description.values_at('hosts', 'passives')
+      hosts.flatten.compact.each { |address| add(address) }
+    end
   end
 end
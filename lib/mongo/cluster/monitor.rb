@@ -0,0 +1,237 @@
+# Copyright (C) 2013 MongoDB, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+module Mongo
+  class Cluster
+
+    # Keeps the topology of a cluster up to date from a background thread.
+    #
+    # Every heartbeat the monitor scans the cluster, which refreshes each
+    # node with an ismaster command and discovers the hosts they report,
+    # then publishes the result as an immutable topology. Operations only
+    # ever read the published topology.
+    #
+    # When an operation finds no eligible node, for instance during a
+    # failover, it asks for a rescan and waits for it, so the nodes are
+    # probed once by the monitor rather than once by every waiting thread.
+    #
+    # @since 2.0.0
+    class Monitor
+
+      # The default time in milliseconds between scans.
+      #
+      # @since 2.0.0
+      DEFAULT_HEARTBEAT_FREQUENCY = 10_000
+
+      # The least time in milliseconds between scans, even when a rescan is
+      # asked for, so that an unreachable cluster is not probed in a loop.
+      #
+      # @since 2.0.0
+      MIN_HEARTBEAT_FREQUENCY = 500
+
+      # @return [ Mongo::Cluster::Topology ] The last published topology.
+      attr_reader :topology
+
+      # Instantiate the new monitor. The background thread is not started
+      # until the cluster is first used.
+      #
+      # @example Instantiate the monitor.
+      #   Mongo::Cluster::Monitor.new(cluster, :heartbeat_frequency => 5000)
+      #
+      # @param [ Mongo::Cluster ] cluster The cluster to monitor.
+      # @param [ Hash ] options The cluster options.
+      #
+      # @since 2.0.0
+      def initialize(cluster, options = {})
+        @cluster = cluster
+        @options = options
+        @topology = Topology.new
+        @requested = false
+        @thread = nil
+        @mutex = Mutex.new
+        @wakeup = ConditionVariable.new
+        @scanned = ConditionVariable.new
+      end
+
+      # Start the background thread unless it is running already.
+      #
+      # @example Start the monitor.
+      #   monitor.start
+      #
+      # @return [ Mongo::Cluster::Monitor ] The monitor.
+      #
+      # @since 2.0.0
+      def start
+        return self if running?
+        @mutex.synchronize do
+          @thread = Thread.new { run } unless running?
+        end
+        self
+      end
+
+      # Stop the background thread.
+      #
+      # @example Stop the monitor.
+      #   monitor.stop
+      #
+      # @since 2.0.0
+      def stop
+        thread = @mutex.synchronize { @thread.tap { @thread = nil } }
+        thread.kill.join if thread
+      end
+
+      # @return [ true, false ] If the background thread is running.
+      #
+      # @since 2.0.0
+      def running?
+        !!(@thread && @thread.alive?)
+      end
+
+      # Scan the cluster and publish the topology found, waking up the
+      # operations waiting for it.
+      #
+      # @example Scan the cluster.
+      #   monitor.scan!
+      #
+      # @return [ Mongo::Cluster::Topology ] The new topology.
+      #
+      # @since 2.0.0
+      def scan!
+        topology = Topology.new(@cluster.scan!, @topology.generation + 1)
+        @mutex.synchronize do
+          @topology = topology
+          @scanned.broadcast
+        end
+        topology
+      end
+
+      # Ask for a scan to start as soon as possible.
+      #
+      # @example Ask for a rescan.
+      #   monitor.request_scan
+      #
+      # @since 2.0.0
+      def request_scan
+        @mutex.synchronize { wake_up }
+      end
+
+      # Ask for a scan and wait for a topology newer than the provided
+      # generation to be published.
+      #
+      # @example Wait for a newer topology.
+      #   monitor.wait_for_scan(topology.generation, 5)
+      #
+      # @param [ Integer ] generation The generation already seen.
+      # @param [ Numeric ] timeout The time in seconds to wait at most.
+      #
+      # @return [ Mongo::Cluster::Topology ] The last published topology.
+      #
+      # @since 2.0.0
+      def wait_for_scan(generation, timeout)
+        @mutex.synchronize do
+          if @topology.generation <= generation
+            wake_up
+            @scanned.wait(@mutex, timeout)
+          end
+          @topology
+        end
+      end
+
+      # Start the background thread and wait for its first scan to be
+      # published, unless one was already.
+      #
+      # @example Wait for the first topology.
+      #   monitor.wait_for_topology(30)
+      #
+      # @param [ Numeric ] timeout The time in seconds to wait at most.
+      #
+      # @return [ Mongo::Cluster::Topology ] The last published topology.
+      #
+      # @since 2.0.0
+      def wait_for_topology(timeout)
+        start
+        @mutex.synchronize do
+          @scanned.wait(@mutex, timeout) if @topology.generation == 0
+          @topology
+        end
+      end
+
+      # Publish a topology without a node that failed an operation, until
+      # the rescan this asks for finds out its state again.
+      #
+      # @example Invalidate a node.
+      #   monitor.invalidate(node)
+      #
+      # @param [ Mongo::Node ] node The node that failed.
+      #
+      # @since 2.0.0
+      def invalidate(node)
+        @mutex.synchronize do
+          @topology = @topology.without(node)
+          wake_up
+        end
+      end
+
+      private
+
+      # Scan the cluster every heartbeat, or sooner when a scan is asked
+      # for, but never more often than the minimum heartbeat frequency. A
+      # scan that fails is reported and tried again at the next heartbeat,
+      # so the monitor outlives it.
+      #
+      # @api private
+      #
+      # @since 2.0.0
+      def run
+        loop do
+          begin
+            scan!
+          rescue StandardError => e
+            warn("MONGODB | Cluster scan failed: #{e.class}: #{e.message}")
+          end
+          sleep(MIN_HEARTBEAT_FREQUENCY / 1000.0)
+          @mutex.synchronize do
+            @wakeup.wait(@mutex, idle_time) unless @requested
+            @requested = false
+          end
+        end
+      end
+
+      # Wake up the background thread for a scan. Must be called while
+      # holding the lock.
+      #
+      # @api private
+      #
+      # @since 2.0.0
+      def wake_up
+        @requested = true
+        @wakeup.signal
+      end
+
+      # Get the time in seconds to wait after the minimum heartbeat before
+      # the next scan, unless one is asked for.
+      #
+      # @api private
+      #
+      # @return [ Float ] The idle time.
+      #
+      # @since 2.0.0
+      def idle_time
+        frequency = @options[:heartbeat_frequency] ||
+          DEFAULT_HEARTBEAT_FREQUENCY
+        [frequency - MIN_HEARTBEAT_FREQUENCY, 0].max / 1000.0
+      end
+    end
+  end
+end
@@ -0,0 +1,124 @@
+# Copyright (C) 2013 MongoDB, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+require 'mongo/node/state'
+
+module Mongo
+  class Cluster
+
+    # An immutable snapshot of the state of the cluster, as found by the
+    # last scan of its monitor. Operations select nodes from the snapshot
+    # without locking and without any network call.
+    #
+    # The state of each node is copied into a frozen member of the
+    # topology, so a selection is never made from the state the next scan
+    # is meanwhile updating.
+    #
+    # @since 2.0.0
+    class Topology
+
+      # A frozen copy of the state of a node when the topology was found.
+      #
+      # @since 2.0.0
+      class Member
+        include Node::State
+
+        # @return [ Mongo::Node ] The node.
+        attr_reader :node
+        # @return [ Hash ] The reply to the last ismaster command of the
+        #   node.
+        attr_reader :description
+        # @return [ Float, nil ] The smoothed round trip time in seconds of
+        #   the node.
+        attr_reader :round_trip_time
+
+        # Instantiate the new member.
+        #
+        # @example Take a snapshot of a node.
+        #   Mongo::Cluster::Topology::Member.new(node)
+        #
+        # @param [ Mongo::Node ] node The node.
+        #
+        # @since 2.0.0
+        def initialize(node)
+          @node = node
+          @description = node.description.dup.freeze
+          @round_trip_time = node.round_trip_time
+          freeze
+        end
+      end
+
+      # @return [ Array<Mongo::Cluster::Topology::Member> ] The snapshots of
+      #   the operable nodes.
+      attr_reader :members
+      # @return [ Array<Mongo::Node> ] The operable nodes.
+      attr_reader :nodes
+      # @return [ Mongo::Node, nil ] The primary, standalone or mongos node.
+      attr_reader :primary
+      # @return [ Integer ] The number of the scan that found the topology.
+      attr_reader :generation
+
+      # Instantiate the new topology, taking a snapshot of each node.
+      #
+      # @example Instantiate the topology.
+      #   Mongo::Cluster::Topology.new(nodes, 1)
+      #
+      # @param [ Array<Mongo::Node, Mongo::Cluster::Topology::Member> ] nodes
+      #   The operable nodes, or the members of another topology to keep.
+      # @param [ Integer ] generation The number of the scan.
+      #
+      # @since 2.0.0
+      def initialize(nodes = [], generation = 0)
+        @members = nodes.map do |node|
+          node.is_a?(Member) ? node : Member.new(node)
+        end.freeze
+        @nodes = @members.map(&:node).freeze
+        @generation = generation
+        primary = @members.find(&:primary?)
+        @primary = primary && primary.node
+        @mongos = @members.any?(&:mongos?)
+        freeze
+      end
+
+      # Whether the cluster is made of mongos nodes.
+      #
+      # @example Is the cluster sharded?
+      #   topology.mongos?
+      #
+      # @return [ true, false ] If an operable node is a mongos.
+      #
+      # @since 2.0.0
+      def mongos?
+        @mongos
+      end
+
+      # Get a copy of the topology without a node, for instance one that
+      # failed an operation and is awaiting a rescan. The other members are
+      # kept as they were.
+      #
+      # @example Get the topology without a node.
+      #   topology.without(node)
+      #
+      # @param [ Mongo::Node ] node The node to leave out.
+      #
+      # @return [ Mongo::Cluster::Topology ] The new topology.
+      #
+      # @since 2.0.0
+      def without(node)
+        kept = members.reject { |member| member.node.equal?(node) }
+        Topology.new(kept, generation)
+      end
+    end
+  end
+end
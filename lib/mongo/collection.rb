@@ -24,6 +24,8 @@ module Mongo
     attr_reader :database
     # @return [ String ] The name of the collection.
     attr_reader :name
+    # @return [ String ] The frozen namespace of the collection.
+    attr_reader :full_namespace
 
     # Check if a collection is equal to another object. Will check the name and
     # the database for equality.
@@ -41,11 +43,106 @@ module Mongo
       name == other.name && database == other.database
     end
 
+    # Get the read preference of the collection, which is the read
+    # preference of its client.
+    #
+    # @example Get the read preference.
+    #   collection.read
+    #
+    # @return [ Mongo::ReadPreference ] The read preference.
+    #
+    # @since 2.0.0
+    def read
+      client.read_preference
+    end
+
+    # Insert documents into the collection, split into as many Insert
+    # messages as needed to keep each one within the limits of the node.
+    # Documents are encoded as they are reached, so any enumerable, lazy or
+    # not, can be inserted with only one message of documents in memory.
+    #
+    # With an acknowledged write concern, the last error is checked after
+    # each message, with the get last error command sent in the same write
+    # as the message. Without +:continue_on_error+ the insertion stops at the
+    # first message that failed, otherwise all messages are sent and every
+    # error is reported once they have been.
+    #
+    # @example Insert a stream of documents.
+    #   collection.bulk_insert(users.each_line.lazy.map { |l| parse(l) })
+    #
+    # @param [ Enumerable<Hash, String> ] documents The documents to insert,
+    #   as hashes or BSON bytes.
+    # @param [ Hash ] options The insertion options.
+    #
+    # @option options [ true, false ] :continue_on_error Whether the server
+    #   keeps inserting the documents after one failed to be inserted.
+    #
+    # @raise [ Mongo::Collection::WriteError ] If a document could not be
+    #   inserted.
+    #
+    # @return [ Integer ] The number of documents sent to the server.
+    #
+    # @since 2.0.0
+    def bulk_insert(documents, options = {})
+      node = client.select_node
+      errors = []
+      count = node.with_connection do |connection|
+        insert_batches(node, documents, options) do |insert|
+          error = write_checked(connection, insert)
+          errors.push(error) if error
+          break if error && !options[:continue_on_error]
+        end
+      end
+      raise WriteError.new(errors) unless errors.empty?
+      count
+    ensure
+      invalidate_results
+    end
+
+    # Queue writes on the collection and send them all at once, together
+    # with the get last error command of each one when the write concern is
+    # acknowledged, so the writes cost a single round trip.
+    #
+    # @example Pipeline writes.
+    #   collection.pipeline do |writes|
+    #     writes.insert([{ :name => 'Emily' }])
+    #     writes.update({ :name => 'Tyler' }, { '$set' => { :age => 30 } })
+    #     writes.delete({ :name => 'Durran' })
+    #   end
+    #
+    # @yieldparam [ Mongo::WritePipeline ] writes The pipeline to queue
+    #   writes on.
+    #
+    # @return [ Array<Hash, nil> ] The last error document of each write,
+    #   nil for every write under an unacknowledged write concern.
+    #
+    # @since 2.0.0
+    def pipeline
+      writes = WritePipeline.new(self)
+      yield(writes)
+      writes.execute
+    ensure
+      invalidate_results
+    end
+
+    # Get the client the collection's database belongs to.
+    #
+    # @example Get the client.
+    #   collection.client
+    #
+    # @return [ Mongo::Client ] The client.
+    #
+    # @since 2.0.0
+    def client
+      database.client
+    end
+
     # @todo: durran: implement.
     def initialize(database, name)
       raise InvalidName.new unless name
       @database = database
       @name = name.to_s
+      @full_namespace = database.namespace(@name)
     end
 
     # Exception that is raised when trying to create a collection with no name.
@@ -69,5 +166,93 @@ module Mongo
         super(MESSAGE)
       end
     end
+
+    # Exception that is raised when the server reports an error for a write.
+    #
+    # @since 2.0.0
+    class WriteError < OperationError
+
+      # @return [ Array<Hash> ] The last error documents of the failed writes.
+      attr_reader :errors
+
+      # Instantiate the new exception.
+      #
+      # @example Instantiate the exception.
+      #   Mongo::Collection::WriteError.new([{ 'err' => 'E11000' }])
+      #
+      # @param [ Array<Hash> ] errors The last error documents.
+      #
+      # @since 2.0.0
+      def initialize(errors)
+        @errors = errors
+        super(errors.last['err'])
+      end
+    end
+
+    private
+
+    # Drop the results of the collection from the result cache of the
+    # client, once a write may have changed them.
+    #
+    # @api private
+    #
+    # @since 2.0.0
+    def invalidate_results
+      result_cache = client.result_cache
+      result_cache.invalidate(full_namespace) if result_cache
+    end
+
+    # Split the documents into Insert messages within the node's limits and
+    # yield each of them.
+    #
+    # @api private
+    #
+    # @param [ Mongo::Node ] node The node to insert on.
+    # @param [ Enumerable<Hash, String> ] documents The documents to insert.
+    # @param [ Hash ] options The insertion options.
+    #
+    # @return [ Integer ] The number of documents yielded in the messages.
+    #
+    # @since 2.0.0
+    def insert_batches(node, documents, options)
+      flags = options[:continue_on_error] ? [:continue_on_error] : []
+      limits = {
+        :max_bson_object_size => node.max_bson_object_size,
+        :max_message_size => node.max_message_size,
+        :flags => flags
+      }
+      count = 0
+      Protocol::Insert.batches(full_namespace, nil, documents, limits) do |i|
+        count += i.documents.size
+        yield(i)
+      end
+      count
+    end
+
+    # Send a write and, if the write concern is acknowledged, its get last
+    # error command in a single write to the socket, then get the last
+    # error of the write.
+    #
+    # @api private
+    #
+    # @param [ Mongo::Pool::Connection ] connection The connection to write
+    #   to.
+    # @param [ Mongo::Protocol::Message ] message The write message.
+    #
+    # @return [ Hash, nil ] The last error document if the write failed.
+    #
+    # @since 2.0.0
+    def write_checked(connection, message)
+      get_last_error = client.write_concern.encoded_get_last_error
+      unless get_last_error
+        connection.write(message)
+        return nil
+      end
+      query = database.last_error_query(get_last_error)
+      connection.write([message, query])
+      reply = connection.receive_replies([query.request_id]).first
+      document = reply.documents[0]
+      document if document && document['err']
+    end
   end
 end
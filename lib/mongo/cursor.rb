@@ -12,6 +12,8 @@
 # See the License for the specific language governing permissions and
 # limitations under the License.
 
+require 'stringio'
+
 module Mongo
 
   # Client-side representation of an iterator over a query result set on
@@ -33,14 +35,25 @@ module Mongo
     # Creates a +Cursor+ object.
     #
     # @param scope [Scope] The +Scope+ defining the query.
-    def initialize(scope)
+    # @param node [Node, nil] The node to send the query to, instead of a
+    #   node selected by the read preference of the scope.
+    def initialize(scope, node = nil)
       @scope      = scope
+      @pinned     = node
       @cursor_id  = nil
       @collection = @scope.collection
       @client     = @collection.client
       @node       = nil
-      @cache      = []
+      @batch      = EMPTY_BATCH
+      @index      = 0
       @returned   = 0
+      @in_flight  = 0
+      @connection = nil
+      @await      = false
+      @idle       = 0
+      @failures   = 0
+      @last_doc   = nil
+      @open       = nil
     end
 
     # Get a human-readable string representation of +Cursor+.
@@ -50,17 +63,48 @@ module Mongo
       "<Mongo::Cursor:0x#{object_id} @scope=#{@scope.inspect}>"
     end
 
+    # Close the cursor on the server.
+    #
+    # If there is neither a node set or if the cursor is already closed,
+    # return nil. Otherwise, queue the cursor to be killed by its node,
+    # which does not wait on the server.
+    def close
+      return nil if @node.nil? || closed?
+      release_connection
+      kill_cursors unless closed?
+    end
+
     # Iterate through documents returned from the query.
     #
+    # A tailable cursor keeps waiting for new documents once the existing
+    # ones have been returned, until the block breaks out of the iteration.
+    #
     # @yieldparam doc [Hash] Each matching document.
     def each
-      yield fetch_doc until done?
+      yield fetch_doc while more?
+    ensure
+      release_connection
     end
 
     private
 
     MAX_QUERY_TRIES = 3
 
+    # The batch held once all docs of a batch have been fetched, so the
+    # consumed batch can be garbage collected.
+    EMPTY_BATCH = [].freeze
+
+    # The initial and maximum time in seconds a tailable cursor waits before
+    # asking for more documents after an empty batch, when the server does
+    # not block for data itself.
+    MIN_TAIL_WAIT = 0.1
+    MAX_TAIL_WAIT = 2
+
+    # The number of times in a row a tailable cursor is resumed after its
+    # connection failed before the error is raised, unless the +Scope+ sets
+    # +:tail_retries+.
+    DEFAULT_TAIL_RETRIES = 5
+
     SPECIAL_FIELDS = [
       [:$query,          :selector],
       [:$readPreference, :read_pref],
@@ -72,42 +116,45 @@ module Mongo
       [:$showDiskLoc,    :show_disk_loc]
     ]
 
-    # Whether we have iterated through all documents in the cache and retrieved
-    # all results from the server.
+    # Whether there is another document to fetch. Batches are requested
+    # from the server until one holds documents or all results have been
+    # retrieved, so empty batches are never yielded from.
     #
-    # @return [true, false] If there are neither docs left in the cache
-    #   or on the server for this query.
-    def done?
-      @cache.empty? && exhausted?
+    # @return [true, false] If there is a doc left in the batch.
+    def more?
+      request_docs while batch_consumed? && !exhausted?
+      !batch_consumed?
     end
 
-    # Get the next doc in the result set.
+    # Whether every doc in the current batch has been fetched.
     #
-    # If the cache is empty, request more docs from the server.
+    # @return [true, false] If the current batch has been consumed.
+    def batch_consumed?
+      @index >= @batch.size
+    end
+
+    # Get the next doc in the current batch. The batch is released as soon
+    # as its last doc is fetched.
     #
     # Check if the doc is an error doc before returning.
     #
     # @return [Hash] The next doc in the result set.
     def fetch_doc
-      request_docs if @cache.empty?
-      doc = @cache.shift
+      doc = @batch[@index]
+      @index += 1
+      @last_doc = doc if tailable?
+      @batch = EMPTY_BATCH if batch_consumed?
+      prefetch if prefetch?
       doc unless error?(doc)
     end
 
-    # Close the cursor on the server.
-    #
-    # If there is neither a node set or if the cursor is already closed,
-    # return nil. Otherwise, send a kill cursor command.
-    def close
-      return nil if @node.nil? || closed?
-      kill_cursors
-    end
-
     # Request documents from the server.
     #
     # Close the cursor on the server if all docs have been retreived.
     def request_docs
-      if !query_run?
+      if tailable?
+        request_tail
+      elsif !query_run?
         send_initial_query
       else
         send_get_more
@@ -117,64 +164,316 @@ module Mongo
 
     # Send a message to a node and collect the results.
     #
-    # @todo: Brandon: verify connecton interface
-    def send_and_receive(connection, message)
-      results, @node = connection.send_and_receive(MAX_QUERY_TRIES, message)
-      @cursor_id     = results[:cursor_id]
+    # The documents of each batch are only decoded as they are fetched. A
+    # new batch is only requested once the current one has been consumed,
+    # so it replaces the current batch.
+    #
+    # @param connection [Connection] The connection to send the message on.
+    # @param message [Message] The message to send.
+    # @param tries [Integer] The number of attempts to make.
+    def send_and_receive(connection, message, tries = MAX_QUERY_TRIES)
+      process(connection.send_and_receive(tries, message, :raw => raw))
+    end
+
+    # Collect the results of a reply.
+    #
+    # @param response [Array<Hash, Node>] The results and the node.
+    def process(response)
+      results, @node = response
+      self.cursor_id = results[:cursor_id]
       @returned      += results[:nreturned]
-      @cache         += results[:docs]
+      @batch         = results[:docs]
+      @index         = 0
+      @await         = flag?(results[:flags], :await_capable)
+      @idle          = @batch.size > 0 ? 0 : @idle + 1
+      @failures      = 0
     end
 
     # Build the query selector and initial +Query+ message.
     #
     # @return [Query] The +Query+ message.
     def initial_query_message
-      selector = has_special_fields? ? special_selector : selector
-      Mongo::Protocol::Query.new(db_name, coll_name, selector, query_opts)
+      query = has_special_fields? ? special_selector : selector
+      Mongo::Protocol::Query.new(namespace, nil, query, query_opts)
     end
 
     # Send the initial query message to a node.
     #
     # @todo: Brandon: verify client interface
     def send_initial_query
-      @client.with_node(read) do |connection|
+      return send_exhaust_query if exhaust?
+      with_initial_node do |connection|
         send_and_receive(connection, initial_query_message)
       end
     end
 
+    # Yield a connection to the node the cursor was created for, or else to
+    # a node selected by read preference.
+    #
+    # @return [Object] The result of the block.
+    def with_initial_node(&block)
+      if @pinned
+        @pinned.with_connection(connection_options, &block)
+      else
+        @client.with_node(read, connection_options, &block)
+      end
+    end
+
     # Build the +GetMore+ message using the cursor id and number of documents
     # to return.
     #
     # @return [GetMore] The +GetMore+ message
     def get_more_message
-      Mongo::Protocol::GetMore.new(db_name, coll_name, to_return, @cursor_id)
+      Mongo::Protocol::GetMore.new(namespace, nil, to_return, @cursor_id)
     end
 
     # Send a +GetMore+ message to a node to get another batch of results.
     #
+    # A +GetMore+ is only attempted once, since resending it after the
+    # server has processed it would skip a batch. If a +GetMore+ has been
+    # prefetched, its reply is read instead.
+    #
     # @todo: define exceptions
     def send_get_more
+      return receive_exhaust if exhaust?
+      return receive_prefetched if @in_flight > 0
       raise Exception, 'No node set' unless @node
-      @node.with_connection do |connection|
-        send_and_receive(connection, get_more_message)
+      @node.with_connection(connection_options) do |connection|
+        send_and_receive(connection, get_more_message, 1)
       end
     end
 
-    # Build a +KillCursors+ message using this cursor's id.
+    # The options for the connection a query or +GetMore+ is sent on. A
+    # shared connection may be used unless the cursor is tailable, since
+    # the server can hold back the reply of a tailable +GetMore+ while it
+    # waits for data.
+    #
+    # @return [Hash] The connection options.
+    def connection_options
+      { :shared => !tailable? }
+    end
+
+    # The number of +GetMore+ messages to keep in flight ahead of the
+    # documents being fetched.
     #
-    # @return [KillCursors] The +KillCursors+ message.
-    def kill_cursors_message
-      Mongo::Protocol::KillCursors.new([@cursor_id])
+    # @return [Integer] The prefetch setting on the +Scope+ or 0.
+    def prefetch_count
+      @scope.prefetch || 0
     end
 
-    # Send a +KillCursors+ message to the server and set the cursor id to 0.
+    # Whether more +GetMore+ messages should be sent ahead. Prefetching
+    # starts once half of the current batch has been fetched. Limited
+    # queries are not prefetched, since the size of the in flight batches
+    # is not known when computing the number left to return. Neither are
+    # exhaust cursors, which never send a +GetMore+, nor tailable cursors,
+    # whose +GetMore+ messages may wait on the server for new data.
     #
-    # @todo: Brandon: verify node interface
+    # @return [true, false] Whether to prefetch.
+    def prefetch?
+      @in_flight < prefetch_count && !limited? && !exhaust? && !tailable? &&
+        query_run? && !closed? && @index * 2 >= @batch.size
+    end
+
+    # Send +GetMore+ messages ahead on a connection held by the cursor, so
+    # the next batches are already buffered when they are needed.
+    def prefetch
+      @connection ||= @node.pool.checkout
+      while @in_flight < prefetch_count
+        @connection.send_message(get_more_message)
+        @in_flight += 1
+      end
+    end
+
+    # Read the reply to the oldest prefetched +GetMore+ message.
+    def receive_prefetched
+      @in_flight -= 1
+      process(@connection.receive(:raw => raw))
+      release_connection if closed?
+    end
+
+    # Whether the query streams all of its batches back without +GetMore+
+    # messages.
+    #
+    # @return [true, false, nil] The exhaust setting on the +Scope+.
+    def exhaust?
+      @scope.exhaust
+    end
+
+    # Send the initial query with the exhaust flag on a connection held by
+    # the cursor, since the server streams every batch back on it.
+    def send_exhaust_query
+      @node = @pinned || @client.select_node(read)
+      @connection = @node.pool.checkout
+      process(@connection.send_and_receive(1, initial_query_message,
+                                           :raw => raw))
+      finish_stream if closed?
+    end
+
+    # Read the next batch streamed back for an exhaust query.
+    def receive_exhaust
+      process(@connection.receive(:raw => raw))
+      finish_stream if closed?
+    end
+
+    # Return the connection of a fully read exhaust stream to the pool.
+    def finish_stream
+      @node.pool.checkin(@connection)
+      @connection = nil
+    end
+
+    # Release the connection held by the cursor, if any.
+    #
+    # The replies to any prefetched +GetMore+ messages still in flight are
+    # read and discarded before the connection is returned to the node's
+    # pool. An exhaust stream that was not read to the end cannot be
+    # drained cheaply, so its connection is discarded, as is a connection
+    # that fails while draining.
+    #
+    # Discarding prefetched batches leaves a gap in the results, so a
+    # cursor still open on the server once they are drained is queued to
+    # be killed rather than iterated further.
+    def release_connection
+      return unless @connection
+      drained = @in_flight > 0
+      if exhaust?
+        @node.pool.discard(@connection)
+      else
+        @in_flight.times { drain_reply }
+        @node.pool.checkin(@connection)
+      end
+    rescue Mongo::SocketError
+      @node.pool.discard(@connection)
+    ensure
+      @in_flight = 0
+      @connection = nil
+      kill_cursors if drained && !closed?
+    end
+
+    # Read and discard the reply to a prefetched +GetMore+ message, keeping
+    # the cursor id it reports so a cursor the server has closed since is
+    # not killed again.
+    def drain_reply
+      reply = @connection.read_reply(:raw => true)
+      self.cursor_id = reply.cursor_id if reply
+    end
+
+    # Whether the cursor stays open on a capped collection once the last
+    # document has been returned.
+    #
+    # @return [true, false, nil] The tailable setting on the +Scope+.
+    def tailable?
+      @scope.tailable
+    end
+
+    # Request the next batch of a tailable cursor.
+    #
+    # After an empty batch, the cursor waits before asking again unless the
+    # server signalled +:await_capable+, in which case the +GetMore+ blocks
+    # on the server until data arrives. When the cursor was lost because it
+    # died on the server or its connection failed, the query is run again
+    # from the last document seen.
+    #
+    # A cursor whose connection failed, or timed out, may still be open on
+    # the server, so it is killed before the query is run again. The error
+    # is raised once the connection failed more than +tail_retries+ times in
+    # a row.
+    #
+    # @raise [Mongo::SocketError] If the retries are exhausted.
+    def request_tail
+      wait_for_data if @idle > 0 && (closed? || !@await)
+      return resume_tail if !query_run? || closed?
+      send_get_more
+    rescue Mongo::SocketError
+      @failures += 1
+      raise if @failures > tail_retries
+      if query_run? && !closed?
+        kill_cursors
+      else
+        self.cursor_id = 0
+      end
+      @idle += 1
+    end
+
+    # The number of times in a row a failed tailable cursor is resumed.
+    #
+    # @return [Integer] The number of retries.
+    def tail_retries
+      @scope.tail_retries || DEFAULT_TAIL_RETRIES
+    end
+
+    # Sleep before asking for more documents, backing off exponentially
+    # while the server keeps returning empty batches.
+    def wait_for_data
+      sleep([MIN_TAIL_WAIT * 2**(@idle - 1), MAX_TAIL_WAIT].min)
+    end
+
+    # Run the query again, only matching documents after the last one seen.
+    def resume_tail
+      @node = nil
+      send_initial_query
+    end
+
+    # The field a tailable cursor resumes from, +ts+ when tailing the oplog
+    # and +_id+ otherwise.
+    #
+    # @return [String] The name of the field.
+    def tail_field
+      oplog_replay? ? 'ts' : '_id'
+    end
+
+    # The position of the last document seen by a tailable cursor. Raw
+    # documents are decoded to read it.
+    #
+    # @return [Object, nil] The value of the tail field or nil.
+    def tail_position
+      doc = @last_doc
+      doc = Mongo::Protocol::Serializers::Document.deserialize(
+        StringIO.new(doc)) if doc.is_a?(String)
+      doc[tail_field] if doc
+    end
+
+    # Whether the server may skip to the +ts+ in the selector of an oplog
+    # query.
+    #
+    # @return [true, false, nil] The oplog replay setting on the +Scope+.
+    def oplog_replay?
+      @scope.oplog_replay
+    end
+
+    # Queue the cursor to be killed by its node and set the cursor id to 0.
     def kill_cursors
-      @node.with_connection do |connection|
-        connection.send_message(kill_cursors_message)
+      @node.kill_cursor(@cursor_id)
+      self.cursor_id = 0
+    end
+
+    # Set the id of the cursor on the server.
+    #
+    # Once the server has opened the cursor, its node and id are also kept
+    # where a finalizer finds them, so that a cursor that is garbage
+    # collected while still open on the server gets killed.
+    #
+    # @param cursor_id [Integer] The id of the cursor, 0 once closed.
+    def cursor_id=(cursor_id)
+      @cursor_id = cursor_id
+      if @open
+        @open[0], @open[1] = @node, cursor_id
+      elsif cursor_id != 0
+        @open = [@node, cursor_id]
+        ObjectSpace.define_finalizer(self, Cursor.finalizer(@open))
+      end
+    end
+
+    # Get the finalizer of a cursor. It must not refer to the cursor, or
+    # the cursor would never be garbage collected.
+    #
+    # @param open [Array<Node, Integer>] The node and id of the cursor.
+    #
+    # @return [Proc] The finalizer.
+    def self.finalizer(open)
+      proc do
+        node, cursor_id = open
+        node.kill_cursor(cursor_id) if node && cursor_id != 0
       end
-      @cursor_id = 0
     end
 
     # Determine whether this query has special fields.
@@ -184,11 +483,11 @@ module Mongo
       !!(opts || sort || hint || comment || read_pref)
     end
 
-    # Get the read preference for this query.
+    # Get the read preference to send to a mongos with this query.
     #
     # @return [Hash, nil] The read preference or nil.
     def read_pref
-      @client.mongos? ? read.mongos : read
+      read.mongos if @client.mongos?
     end
 
     # Build a special query selector.
@@ -227,7 +526,21 @@ module Mongo
     # @return [Array] List of flags to be set on the query message.
     # @todo: add no_cursor_timeout option
     def flags
+      flags = []
       flags << :slave_ok if need_slave_ok?
+      flags << :exhaust if exhaust?
+      flags.concat(tail_flags) if tailable?
+      flags
+    end
+
+    # The flags set on a tailable query.
+    #
+    # @return [Array] List of tailing flags.
+    def tail_flags
+      flags = [:tailable_cursor]
+      flags << :await_data if @scope.await_data
+      flags << :oplog_replay if oplog_replay?
+      flags
     end
 
     # Check whether the document returned is an error document.
@@ -247,12 +560,14 @@ module Mongo
       limit - @returned
     end
 
-    # The number of documents to return in each batch from the server.
+    # The number of documents to return in each batch from the server, 0
+    # leaving the batch size to the server.
     #
     # @return [Integer] The number of documents to return in each batch from
     #   the server.
     def batch_size
-      @scope.batch_size && @scope.batch_size > 0 ? @scope.batch_size : limit
+      size = @scope.batch_size
+      size && size > 0 ? size : limit || 0
     end
 
     # Whether a limit should be specified.
@@ -285,23 +600,26 @@ module Mongo
 
     # The read preference to use for this query.
     #
-    # @return [Hash] The read preference to use for this query.
+    # @return [ReadPreference] The read preference to use for this query.
     def read
-      @scope.read
+      @read ||= ReadPreference.get(@scope.read)
     end
 
-    # The name of the database.
+    # The frozen namespace of the collection, shared by every message.
     #
-    # @return [String] The name of the database.
-    def db_name
-      @collection.database.name
+    # @return [String] The namespace of the collection.
+    def namespace
+      @collection.full_namespace
     end
 
-    # The name of the collection.
+    # Whether a flag of a reply is set. The flags are queried in place, as
+    # the frozen flags of the reply or an array of flags.
     #
-    # @return [String] The name of the collection.
-    def coll_name
-      @collection.name
+    # @param flags [Flags, Array<Symbol>, nil] The flags of the reply.
+    # @param flag [Symbol] The flag.
+    # @return [true, false] If the flag is set.
+    def flag?(flags, flag)
+      !flags.nil? && flags.include?(flag)
     end
 
     # Whether the initial query message has already been sent.
@@ -317,7 +635,8 @@ module Mongo
     # @return [true, false] Whether all results have been retrieved from
     #   the server.
     def exhausted?
-      limited? ? (@returned >= limit) : closed?
+      return @returned >= limit if limited?
+      closed? && !tailable?
     end
 
     # Whether the slave ok bit needs to be set on the wire protocol message.
@@ -334,11 +653,21 @@ module Mongo
       read.primary?
     end
 
-    # The selector used for the query.
+    # The selector used for the query. A resumed tailable query only
+    # matches documents after the last one seen, and still matches the
+    # condition of the selector on the tail field if it has one.
     #
     # @return [Hash] The selector for the query.
     def selector
-      @scope.selector
+      position = tail_position if tailable?
+      return @scope.selector unless position
+      after = { tail_field => { :$gt => position } }
+      if @scope.selector.key?(tail_field) ||
+          @scope.selector.key?(tail_field.to_sym)
+        { :$and => [@scope.selector, after] }
+      else
+        @scope.selector.merge(after)
+      end
     end
 
     # The max scan option set on the +Scope+.
@@ -384,6 +713,13 @@ module Mongo
       @scope.comment
     end
 
+    # Whether documents are returned as BSON bytes rather than decoded.
+    #
+    # @return [true, false, nil] The raw setting on +Scope+ or nil.
+    def raw
+      @scope.raw
+    end
+
     # The limit setting on the +Scope+.
     #
     # @return [Integer, nil] Either the limit setting on +Scope+ or nil.
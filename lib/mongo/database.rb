@@ -34,6 +34,8 @@ module Mongo
     attr_reader :client
     # @return [ String ] The name of the collection.
     attr_reader :name
+    # @return [ String ] The frozen namespace of the database's commands.
+    attr_reader :command_namespace
 
     # Check equality of the database object against another. Will simply check
     # if the names are the same.
@@ -106,14 +108,50 @@ module Mongo
     # @return [ Hash ] The result of the command execution.
     def command(operation)
       cmd = Protocol::Query.new(
-        name,
-        COMMAND,
+        command_namespace,
+        nil,
         operation,
         :limit => -1, :read => client.read_preference
       )
       cluster.execute(cmd)
     end
 
+    # Build the query for the last error of the preceding write on a
+    # connection. Given the pre-encoded command of a write concern, only the
+    # header of the query is built for each write.
+    #
+    # @api private
+    #
+    # @example Build the get last error query.
+    #   database.last_error_query(client.write_concern.encoded_get_last_error)
+    #
+    # @param [ Hash, String ] get_last_error The get last error command, or
+    #   its BSON bytes.
+    #
+    # @return [ Mongo::Protocol::Query ] The query message.
+    #
+    # @since 2.0.0
+    def last_error_query(get_last_error)
+      Protocol::Query.new(command_namespace, nil, get_last_error, :limit => -1)
+    end
+
+    # Build the frozen binary namespace of a collection in the database, to
+    # be reused by every message sent to it.
+    #
+    # @api private
+    #
+    # @example Get the namespace of a collection.
+    #   database.namespace('users')
+    #
+    # @param [ String ] collection_name The name of the collection.
+    #
+    # @return [ String ] The frozen namespace.
+    #
+    # @since 2.0.0
+    def namespace(collection_name)
+      "#{name}.#{collection_name}".force_encoding('BINARY').freeze
+    end
+
     # Instantiate a new database object.
     #
     # @example Instantiate the database.
@@ -129,6 +167,7 @@ module Mongo
       raise InvalidName.new unless name
       @client = client
       @name = name.to_s
+      @command_namespace = namespace(COMMAND)
     end
 
     # Exception that is raised when trying to create a database with no name.
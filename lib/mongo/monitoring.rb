@@ -0,0 +1,149 @@
+# Copyright (C) 2013 MongoDB, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+module Mongo
+
+  # Publishes events about the operations sent to the server and about the
+  # connection pools to the registered subscribers.
+  #
+  # A subscriber implements any of the event methods and is only sent the
+  # events it implements:
+  #
+  # * +started+, +succeeded+ and +failed+ with an +OperationEvent+, for
+  #   each message written and the reply read to it, if any.
+  # * +checked_out+, +checked_in+, +connection_created+ and
+  #   +connection_closed+ with a +PoolEvent+.
+  #
+  # While nothing is subscribed no event is built and nothing is timed, so
+  # the cost of the hooks is a single check per operation.
+  #
+  # @example Log the time operations spend waiting for the pool.
+  #   class PoolWaitLogger
+  #     def succeeded(event)
+  #       puts "#{event.namespace}: #{event.pool_wait}s in the pool"
+  #     end
+  #   end
+  #   Mongo::Monitoring.subscribe(PoolWaitLogger.new)
+  #
+  # @since 2.0.0
+  module Monitoring
+
+    # An operation on a connection. Times are in seconds, and the duration
+    # is split into the time spent waiting for a pooled connection, writing
+    # the message, and waiting for the server and reading its reply.
+    #
+    # @since 2.0.0
+    OperationEvent = Struct.new(
+      :request_id, :namespace, :op_code, :address, :bytes_written,
+      :bytes_read, :pool_wait, :write_time, :read_time, :error
+    ) do
+
+      # Get the total time of the operation.
+      #
+      # @return [ Float ] The duration in seconds.
+      #
+      # @since 2.0.0
+      def duration
+        pool_wait.to_f + write_time.to_f + read_time.to_f
+      end
+    end
+
+    # A change to a connection pool. The wait is the time in seconds a
+    # checkout waited for a connection, and the size the number of
+    # connections the pool owns after the change.
+    #
+    # @since 2.0.0
+    PoolEvent = Struct.new(:address, :wait, :size)
+
+    @subscribers = [].freeze
+    @mutex = Mutex.new
+
+    class << self
+
+      # @return [ Array<Object> ] The registered subscribers.
+      attr_reader :subscribers
+
+      # Register a subscriber to the events.
+      #
+      # @example Subscribe to the events.
+      #   Mongo::Monitoring.subscribe(subscriber)
+      #
+      # @param [ Object ] subscriber The subscriber.
+      #
+      # @return [ Object ] The subscriber.
+      #
+      # @since 2.0.0
+      def subscribe(subscriber)
+        @mutex.synchronize do
+          @subscribers = (@subscribers + [subscriber]).freeze
+        end
+        subscriber
+      end
+
+      # Remove a subscriber.
+      #
+      # @example Unsubscribe from the events.
+      #   Mongo::Monitoring.unsubscribe(subscriber)
+      #
+      # @param [ Object ] subscriber The subscriber.
+      #
+      # @since 2.0.0
+      def unsubscribe(subscriber)
+        @mutex.synchronize do
+          @subscribers = (@subscribers - [subscriber]).freeze
+        end
+      end
+
+      # Whether any subscriber is registered, which is checked before any
+      # event is built.
+      #
+      # @return [ true, false ] If events are published.
+      #
+      # @since 2.0.0
+      def enabled?
+        !@subscribers.empty?
+      end
+
+      # Send an event to the subscribers that implement it. An error raised
+      # by a subscriber does not fail the operation.
+      #
+      # @example Publish an event.
+      #   Mongo::Monitoring.publish(:started, event)
+      #
+      # @param [ Symbol ] name The name of the event.
+      # @param [ Struct ] event The event.
+      #
+      # @since 2.0.0
+      def publish(name, event)
+        @subscribers.each do |subscriber|
+          next unless subscriber.respond_to?(name)
+          begin
+            subscriber.send(name, event)
+          rescue StandardError => e
+            warn("MONGODB | #{name} subscriber failed: #{e.message}")
+          end
+        end
+      end
+
+      # Get the current time of the clock events are timed with.
+      #
+      # @return [ Float ] The time in seconds.
+      #
+      # @since 2.0.0
+      def now
+        Pool::Socket::Base.monotonic_time
+      end
+    end
+  end
+end
@@ -12,26 +12,331 @@
 # See the License for the specific language governing permissions and
 # limitations under the License.
 
+require 'mongo/node/cursor_reaper'
+require 'mongo/node/state'
+
 module Mongo
 
   class Node
+    include State
+
+    # The default port for a node when none is provided in the address.
+    #
+    # @since 2.0.0
+    DEFAULT_PORT = 27017
+
+    # The default maximum size in bytes of a document accepted by the node.
+    #
+    # @since 2.0.0
+    DEFAULT_MAX_BSON_OBJECT_SIZE = 16 * 1024 * 1024
+
+    # The default maximum size in bytes of a message accepted by the node.
+    #
+    # @since 2.0.0
+    DEFAULT_MAX_MESSAGE_SIZE = 48000000
+
+    # The weight of the latest round trip time in the smoothed round trip
+    # time of the node.
+    #
+    # @since 2.0.0
+    ROUND_TRIP_TIME_WEIGHT = 0.2
+
+    # The ismaster command.
+    #
+    # @since 2.0.0
+    ISMASTER = { :ismaster => 1 }.freeze
 
     attr_reader :address, :cluster, :options
 
+    # @return [ String ] The host name, IP address or unix socket path.
+    attr_reader :host
+    # @return [ Integer, nil ] The port number, nil for unix sockets.
+    attr_reader :port
+    # @return [ Mongo::Pool::ConnectionPool ] The pool of connections.
+    attr_reader :pool
+    # @return [ Mongo::Node::CursorReaper ] The reaper of its cursors.
+    attr_reader :reaper
+    # @return [ Hash ] The reply to the last successful ismaster command.
+    attr_reader :description
+    # @return [ Float, nil ] The smoothed round trip time in seconds of the
+    #   ismaster command, nil until the node has been refreshed.
+    attr_reader :round_trip_time
+
     def ==(other)
       address == other.address
     end
 
-    # @todo This should be synchronized. I envison this checks if the node is
-    # alive and a primary or secondary. (no arbiters)
+    # Whether operations can be executed on the node. A node is operable
+    # until a refresh of its state fails, and again once one succeeds.
+    #
+    # @return [ true, false ] If the node is operable.
+    #
+    # @since 2.0.0
     def operable?
-      true
+      @operable
+    end
+
+    # Get the maximum size of a document accepted by the node, as reported
+    # by its last ismaster reply unless set in the options.
+    #
+    # @return [ Integer ] The maximum size in bytes of a document.
+    #
+    # @since 2.0.0
+    def max_bson_object_size
+      options[:max_bson_object_size] ||
+        description['maxBsonObjectSize'] || DEFAULT_MAX_BSON_OBJECT_SIZE
+    end
+
+    # Get the maximum size of a message accepted by the node, as reported by
+    # its last ismaster reply unless set in the options.
+    #
+    # @return [ Integer ] The maximum size in bytes of a message.
+    #
+    # @since 2.0.0
+    def max_message_size
+      options[:max_message_size] ||
+        description['maxMessageSizeBytes'] || DEFAULT_MAX_MESSAGE_SIZE
+    end
+
+    # Refresh the state of the node with an ismaster command, sent on a
+    # connection of its own so it does not wait on the pool, and fold its
+    # round trip time into the smoothed round trip time of the node.
+    #
+    # @example Refresh the node.
+    #   node.refresh!
+    #
+    # @return [ true, false ] If the node is operable.
+    #
+    # @since 2.0.0
+    def refresh!
+      @refresh_lock.synchronize do
+        description, time = ismaster
+        update_round_trip_time(time) if time
+        @description = description if description
+        @operable = !description.nil?
+      end
     end
 
     def initialize(cluster, address, options = {})
       @cluster = cluster
       @address = address
       @options = options
+      @host, @port = parse_address(address)
+      @description = {}
+      @operable = true
+      @refresh_lock = Mutex.new
+      @pool = Pool::ConnectionPool.new(options) { create_connection }
+      @multiplexers = create_multiplexers
+      @next_multiplexer = 0
+      @reaper = CursorReaper.new(self)
+    end
+
+    # Open the +:min_pool_size+ connections of the pool, so that the first
+    # operations on the node do not wait for connections to be made. A node
+    # that cannot be connected to is left as it is.
+    #
+    # @example Warm up the pool of the node.
+    #   node.warm
+    #
+    # @return [ Mongo::Node ] The node.
+    #
+    # @since 2.0.0
+    def warm
+      pool.warm
+      self
+    rescue Mongo::SocketError, ::SocketError, SystemCallError, IOError,
+           OpenSSL::SSL::SSLError
+      self
+    end
+
+    # Forget the connections of the node in a forked process, along with
+    # the cursors queued to be killed, which belong to the parent process.
+    # The connections are not closed, as the parent process shares their
+    # sockets, and new ones are made on first use.
+    #
+    # @example Reset the node in a forked process.
+    #   node.after_fork
+    #
+    # @return [ Mongo::Node ] The node.
+    #
+    # @since 2.0.0
+    def after_fork
+      @monitor = nil
+      pool.after_fork
+      @multiplexers = create_multiplexers
+      @reaper = CursorReaper.new(self)
+      self
+    end
+
+    # Check out a connection to this node from its pool, yield it, and check
+    # it back in when the block is done.
+    #
+    # When the node was created with the +:multiplex+ option, which gives
+    # the number of connections shared between all threads, a shared
+    # connection can be asked for instead. The shared connections are
+    # handed out in turn and only support +send_and_receive+, which makes
+    # them fit for queries and get mores but not for writes, whose get last
+    # error needs the connection to itself.
+    #
+    # @example Send a message over a pooled connection.
+    #   node.with_connection do |connection|
+    #     connection.write(message)
+    #   end
+    #
+    # @example Send a query over a shared connection.
+    #   node.with_connection(:shared => true) do |connection|
+    #     connection.send_and_receive(1, query)
+    #   end
+    #
+    # A socket error other than a timeout takes the node out of the cluster
+    # topology until the cluster has been rescanned.
+    #
+    # @param [ Hash ] options The connection options.
+    #
+    # @option options [ true, false ] :shared Whether a shared connection
+    #   may be yielded.
+    #
+    # @return [ Object ] The result of the block.
+    #
+    # @since 2.0.0
+    def with_connection(options = {}, &block)
+      if options[:shared] && !@multiplexers.empty?
+        yield(next_multiplexer)
+      else
+        pool.with_connection(&block)
+      end
+    rescue Mongo::SocketTimeoutError
+      raise
+    rescue Mongo::SocketError
+      cluster.invalidate(self)
+      raise
+    end
+
+    # Kill a cursor on this node in the background, along with the other
+    # cursors closed meanwhile.
+    #
+    # @example Kill a cursor.
+    #   node.kill_cursor(cursor_id)
+    #
+    # @param [ Integer ] cursor_id The id of the cursor.
+    #
+    # @since 2.0.0
+    def kill_cursor(cursor_id)
+      reaper.schedule(cursor_id)
+    end
+
+    private
+
+    # Split the node address into a host and port. Addresses that end in
+    # .sock are treated as unix socket paths, bracketed hosts as IPv6.
+    #
+    # @api private
+    #
+    # @example Parse the address.
+    #   node.parse_address('127.0.0.1:27018')
+    #
+    # @param [ String ] address The node address.
+    #
+    # @return [ Array<String, Integer> ] The host and port.
+    #
+    # @since 2.0.0
+    def parse_address(address)
+      return [address, nil] if address.end_with?('.sock')
+      if address =~ /\A\[(.+)\](?::(\d+))?\z/
+        host, port = $1, $2
+      else
+        host, port = address.split(':')
+      end
+      [host, port ? port.to_i : DEFAULT_PORT]
+    end
+
+    # Create a new connection to this node.
+    #
+    # @api private
+    #
+    # @param [ Hash ] opts Options overriding the node options.
+    #
+    # @return [ Mongo::Pool::Connection ] The connected connection.
+    #
+    # @since 2.0.0
+    def create_connection(opts = {})
+      opts = options.merge(opts).merge(:node => self)
+      Pool::Connection.new(host, port, socket_timeout, opts)
+    end
+
+    # Create the shared connections asked for with the +:multiplex+
+    # option, which connect on first use.
+    #
+    # @api private
+    #
+    # @return [ Array<Mongo::Pool::Multiplexer> ] The shared connections.
+    #
+    # @since 2.0.0
+    def create_multiplexers
+      Array.new(options[:multiplex] || 0) do
+        Pool::Multiplexer.new(create_connection(:connect => false))
+      end
+    end
+
+    # Get the next shared connection, in turn.
+    #
+    # @api private
+    #
+    # @return [ Mongo::Pool::Multiplexer ] The shared connection.
+    #
+    # @since 2.0.0
+    def next_multiplexer
+      index = @next_multiplexer
+      @next_multiplexer = (index + 1) % @multiplexers.size
+      @multiplexers[index]
+    end
+
+    # Send an ismaster command on the monitoring connection of the node,
+    # connecting it first if needed.
+    #
+    # @api private
+    #
+    # @return [ Array<Hash, Float>, nil ] The reply and the round trip time
+    #   in seconds, or nil if the node could not be reached.
+    #
+    # @since 2.0.0
+    def ismaster
+      @monitor ||= create_connection
+      query = Protocol::Query.new('admin', '$cmd', ISMASTER, :limit => -1)
+      start = Pool::Socket::Base.monotonic_time
+      results, _ = @monitor.send_and_receive(1, query)
+      [results[:docs][0], Pool::Socket::Base.monotonic_time - start]
+    rescue Mongo::SocketError, ::SocketError, SystemCallError, IOError,
+           OpenSSL::SSL::SSLError
+      @monitor.disconnect if @monitor
+      @monitor = nil
+    end
+
+    # Fold a round trip time into the exponentially weighted moving average
+    # of the round trip times of the node.
+    #
+    # @api private
+    #
+    # @param [ Float ] time The round trip time in seconds.
+    #
+    # @since 2.0.0
+    def update_round_trip_time(time)
+      previous = @round_trip_time || time
+      @round_trip_time = ROUND_TRIP_TIME_WEIGHT * time +
+        (1 - ROUND_TRIP_TIME_WEIGHT) * previous
+    end
+
+    # Get the socket timeout in seconds. The +:socket_timeout+ option is in
+    # milliseconds, as in the socketTimeoutMS uri option.
+    #
+    # @api private
+    #
+    # @return [ Float, nil ] The timeout in seconds.
+    #
+    # @since 2.0.0
+    def socket_timeout
+      timeout = options[:socket_timeout]
+      timeout / 1000.0 if timeout
     end
   end
 end
@@ -0,0 +1,135 @@
+# Copyright (C) 2013 MongoDB, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+module Mongo
+  class Node
+
+    # Kills the cursors of a node in the background.
+    #
+    # Closed and garbage collected cursors are queued, and a thread of the
+    # reaper sends their ids to the node in batched +KillCursors+ messages,
+    # so that closing a cursor does not wait on the server, and cursors
+    # that were never closed do not stay open on the server until they
+    # time out.
+    #
+    # @since 2.0.0
+    class CursorReaper
+
+      # The time in seconds the reaper waits after the first cursor is
+      # queued, so that the cursors closed meanwhile go in the same batch.
+      #
+      # @since 2.0.0
+      FLUSH_DELAY = 0.05
+
+      # The maximum number of cursor ids sent in one +KillCursors+ message.
+      #
+      # @since 2.0.0
+      MAX_BATCH_SIZE = 1000
+
+      # Instantiate the new reaper. Its thread is started when the first
+      # cursor is queued.
+      #
+      # @example Instantiate the reaper.
+      #   Mongo::Node::CursorReaper.new(node)
+      #
+      # @param [ Mongo::Node ] node The node the cursors are open on.
+      #
+      # @since 2.0.0
+      def initialize(node)
+        @node = node
+        @queue = Queue.new
+        @thread = nil
+        @mutex = Mutex.new
+      end
+
+      # Queue a cursor to be killed.
+      #
+      # This does not block, so is also safe to call from the finalizer of
+      # a cursor.
+      #
+      # @example Queue a cursor.
+      #   reaper.schedule(cursor_id)
+      #
+      # @param [ Integer ] cursor_id The id of the cursor on the server.
+      #
+      # @since 2.0.0
+      def schedule(cursor_id)
+        @queue.push(cursor_id)
+        start
+      end
+
+      # Get the number of cursors waiting to be killed.
+      #
+      # @return [ Integer ] The number of queued cursor ids.
+      #
+      # @since 2.0.0
+      def size
+        @queue.size
+      end
+
+      private
+
+      # Start the thread of the reaper unless it is started already. The
+      # lock is only tried, so that a finalizer run while the thread is
+      # being started does not wait on it.
+      #
+      # @api private
+      #
+      # @since 2.0.0
+      def start
+        return if @thread && @thread.alive?
+        return unless @mutex.try_lock
+        begin
+          @thread = Thread.new { run } unless @thread && @thread.alive?
+        ensure
+          @mutex.unlock
+        end
+      end
+
+      # Wait for queued cursors and kill them in batches.
+      #
+      # @api private
+      #
+      # @since 2.0.0
+      def run
+        loop do
+          cursor_ids = [@queue.pop]
+          sleep(FLUSH_DELAY)
+          cursor_ids << @queue.pop until @queue.empty?
+          flush(cursor_ids)
+        end
+      end
+
+      # Send the cursor ids to the node. The cursors are given up on when
+      # the node cannot be reached, as the server times them out anyway.
+      #
+      # @api private
+      #
+      # @param [ Array<Integer> ] cursor_ids The ids of the cursors.
+      #
+      # @since 2.0.0
+      def flush(cursor_ids)
+        cursor_ids.each_slice(MAX_BATCH_SIZE) do |batch|
+          message = Protocol::KillCursors.new(batch)
+          @node.with_connection do |connection|
+            connection.send_message(message)
+          end
+        end
+      rescue Mongo::SocketError, Pool::ConnectionPool::WaitTimeout,
+             ::SocketError, SystemCallError, IOError
+        nil
+      end
+    end
+  end
+end
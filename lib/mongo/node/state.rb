@@ -0,0 +1,64 @@
+# Copyright (C) 2013 MongoDB, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+module Mongo
+  class Node
+
+    # The state of a node as described by the reply to its last ismaster
+    # command. Included by the node itself and by the frozen snapshots of
+    # it kept in a topology, which both provide the +description+.
+    #
+    # @since 2.0.0
+    module State
+
+      # Whether the node is a primary, a standalone server or a mongos.
+      #
+      # @return [ true, false ] If the node accepts writes.
+      #
+      # @since 2.0.0
+      def primary?
+        !!description['ismaster']
+      end
+
+      # @return [ true, false ] If the node is a replica set secondary.
+      #
+      # @since 2.0.0
+      def secondary?
+        !!description['secondary']
+      end
+
+      # @return [ true, false ] If the node is a mongos.
+      #
+      # @since 2.0.0
+      def mongos?
+        description['msg'] == 'isdbgrid'
+      end
+
+      # @return [ String, nil ] The name of the replica set of the node, nil
+      #   if the node is not a replica set member.
+      #
+      # @since 2.0.0
+      def replica_set_name
+        description['setName']
+      end
+
+      # @return [ Hash ] The replica set tags of the node.
+      #
+      # @since 2.0.0
+      def tags
+        description['tags'] || {}
+      end
+    end
+  end
+end
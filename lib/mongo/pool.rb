@@ -1,5 +1,7 @@
 require 'mongo/pool/socket'
 require 'mongo/pool/connection'
+require 'mongo/pool/connection_pool'
+require 'mongo/pool/multiplexer'
 
 module Mongo
   class SocketError < StandardError; end
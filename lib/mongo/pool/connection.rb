@@ -12,6 +12,8 @@
 # See the License for the specific language governing permissions and
 # limitations under the License.
 
+require 'stringio'
+
 module Mongo
   module Pool
 
@@ -20,6 +22,12 @@ module Mongo
 
       DEFAULT_TIMEOUT = 5
 
+      # The size in bytes of a wire protocol message header.
+      HEADER_SIZE = 16
+
+      # The op codes of the messages the server replies to.
+      REPLY_OP_CODES = [2004, 2005].freeze
+
       # @!attribute host
       #   @return [String] The hostname (or path for unix sockets).
       # @!attribute port
@@ -28,7 +36,18 @@ module Mongo
       #   @return [Integer] The socket timeout value in seconds.
       # @!attribute last_use
       #   @return [Time.now] The most recent lease time for the connection.
-      attr_reader :host, :port, :timeout, :last_use
+      # @!attribute node
+      #   @return [Mongo::Node] The node the connection belongs to, if any.
+      attr_reader :host, :port, :timeout, :last_use, :node
+
+      # @return [Float, nil] The time in seconds the last checkout of the
+      #   connection waited on its pool, until reported with the next
+      #   operation. Only kept while monitoring is enabled.
+      attr_accessor :pool_wait
+
+      # @return [Integer, nil] The generation of the pool that made the
+      #   connection, which tells connections made before a fork apart.
+      attr_accessor :pool_generation
 
       # Initializes a new connected and ready-to-use Connection instance.
       #
@@ -43,14 +62,35 @@ module Mongo
       # @param timeout [Integer] The socket timeout value in seconds.
       # @param opts [Hash] Optional settings and configuration values.
       #
+      # @option opts [Mongo::Node] :node (nil) The node that owns the
+      #   connection.
+      # @option opts [Array<String>] :compressors ([]) The compressors to
+      #   offer the server, in order of preference. Messages are compressed
+      #   with the first one the server also supports.
+      # @option opts [Integer] :zlib_compression_level (nil) The zlib
+      #   compression level.
+      # @option opts [Integer] :compression_threshold (512) The size in
+      #   bytes from which messages are compressed.
+      #
       # @return [Connection] The connection instance.
       def initialize(host, port, timeout = nil, opts = {})
         @host     = host
         @port     = port
         @timeout  = timeout || DEFAULT_TIMEOUT
         @last_use = nil
+        @node     = opts[:node]
         @socket   = nil
+        @header   = ''.force_encoding('BINARY')
+        @buffer   = Protocol::WriteBuffer.new
         @ssl_opts = opts.reject { |k, v| !k.to_s.start_with?('ssl') }
+        @compression_opts = opts
+        @compressors = Protocol::Compression.available(
+          opts[:compressors] || [])
+        @compression = nil
+        @compression_name = nil
+        @pool_wait = nil
+        @in_flight = {}
+        @in_flight_lock = Mutex.new
         connect if opts.fetch(:connect, true)
         self
       end
@@ -89,20 +129,35 @@ module Mongo
 
       # Create a socket a connected socket instance.
       #
+      # When compressors are configured, the compressor is negotiated with
+      # the server right after connecting, as each connection may reach a
+      # server with different compressors.
+      #
       # @example
       #   connection = Connection.new('::1', 27015, { :connect => false })
       #   connection.connect
       #
       def connect
+        opts = { :deadline => @deadline }
         if @host && @port.nil?
-          @socket = Socket::Unix.new(@host, @timeout)
+          @socket = Socket::Unix.new(@host, @timeout, opts)
         else
-          if @ssl_opts && !@ssl_opts.empty?
-            @socket = Socket::SSL.new(@host, @port, @timeout, @ssl_opts)
+          if Socket::SSLContext.enabled?(@ssl_opts)
+            @socket = Socket::SSL.new(@host, @port, @timeout,
+                                      @ssl_opts.merge(opts))
           else
-            @socket = Socket::TCP.new(@host, @port, @timeout)
+            @socket = Socket::TCP.new(@host, @port, @timeout, opts)
           end
         end
+        negotiate_compression unless @compressors.empty?
+      end
+
+      # Get the name of the compressor negotiated with the server.
+      #
+      # @return [String, nil] The compressor name, or nil if messages are
+      #   sent uncompressed.
+      def compressor
+        @compression_name
       end
 
       # Closes the socket and disposes of the socket instance.
@@ -115,7 +170,10 @@ module Mongo
         if @socket
           @socket.close
           @socket = nil
+          @compression = nil
+          @compression_name = nil
         end
+        @in_flight_lock.synchronize { @in_flight.clear }
       end
 
       # TODO: read and write probably need to be dealt with in terms of
@@ -135,16 +193,409 @@ module Mongo
       # Reads data from the socket and returns the result as an array of
       # documents.
       #
+      # The whole reply is read from the socket with two reads, one for the
+      # header and one for the rest of the message, into buffers that are
+      # reused across replies. The reply is then decoded from memory.
+      #
       # @return [Array<Hash>] The documents from the reply.
       def read
-        Protocol::Reply.deserialize(@socket).documents
+        read_reply.documents
+      end
+
+      # Get the address of the server the connection is to.
+      #
+      # @return [String] The address of the node, or the host and port.
+      def address
+        node ? node.address : "#{host}:#{port}"
+      end
+
+      # Reads a reply from the socket.
+      #
+      # While monitoring is enabled and a message written earlier awaits
+      # its reply, the operation of the message is reported as succeeded
+      # or failed once the reply is read.
+      #
+      # @param opts [Hash] The reply deserialization options.
+      #
+      # @option opts [true, false] :lazy Keep the documents encoded until
+      #   they are accessed.
+      # @option opts [true, false] :raw Return the documents as BSON bytes.
+      #
+      # @return [Mongo::Protocol::Reply] The reply.
+      def read_reply(opts = {})
+        return Protocol::Reply.deserialize_body(*read_message, opts) if
+          @in_flight.empty?
+        instrumented_read_reply(opts)
+      end
+
+      # Writes a message for which the server sends no reply.
+      #
+      # @example
+      #   connection.send_message(kill_cursors)
+      #
+      # @param message [Mongo::Protocol::Message] The message to send.
+      #
+      # @return [Integer] The length in bytes of the data written.
+      def send_message(message)
+        write(message)
+      end
+
+      # Reads the reply to a message that was written earlier. The documents
+      # of the reply are decoded lazily.
+      #
+      # @example
+      #   connection.send_message(get_more)
+      #   results, node = connection.receive
+      #
+      # @param opts [Hash] The reply deserialization options.
+      #
+      # @option opts [true, false] :raw Return the documents as BSON bytes.
+      #
+      # @return [Array<Hash, Mongo::Node>] The results of the reply, made of
+      #   its +:cursor_id+, +:nreturned+, +:docs+ and +:flags+, and the
+      #   node.
+      def receive(opts = {})
+        [results(read_reply(opts.merge(:lazy => true))), node]
       end
 
-      # Serializes the message and writes the data to the connected socket.
+      # Writes a message and reads its reply, reconnecting and resending the
+      # message on a socket error until +tries+ attempts have been made. The
+      # documents of the reply are decoded lazily.
+      #
+      # Each attempt, including the reconnect, has to complete within the
+      # socket timeout of the connection.
+      #
+      # @example
+      #   results, node = connection.send_and_receive(3, query)
+      #
+      # @param tries [Integer] The number of attempts to make.
+      # @param message [Mongo::Protocol::Message] The message to send.
+      # @param opts [Hash] The reply deserialization options.
+      #
+      # @option opts [true, false] :raw Return the documents as BSON bytes.
+      #
+      # @return [Array<Hash, Mongo::Node>] The results of the reply, made of
+      #   its +:cursor_id+, +:nreturned+, +:docs+ and +:flags+, and the
+      #   node.
+      def send_and_receive(tries, message, opts = {})
+        attempt = 0
+        begin
+          attempt += 1
+          with_deadline do
+            connect unless @socket
+            write(message)
+            receive(opts)
+          end
+        rescue Mongo::SocketError
+          raise if attempt >= tries
+          disconnect
+          retry
+        end
+      end
+
+      # Reads the replies to messages that were written earlier, in one
+      # batch, and puts them in the order of the requests they reply to.
+      #
+      # @example
+      #   connection.write([insert, get_last_error])
+      #   replies = connection.receive_replies([get_last_error.request_id])
+      #
+      # @param request_ids [Array<Integer>] The request ids of the messages.
+      # @param opts [Hash] The reply deserialization options.
+      #
+      # @option opts [true, false] :raw Return the documents as BSON bytes.
+      #
+      # @raise [Mongo::SocketError] If a reply does not answer any of the
+      #   requests, leaving the connection in an unknown state.
+      #
+      # @return [Array<Mongo::Protocol::Reply>] The reply to each request.
+      def receive_replies(request_ids, opts = {})
+        replies = {}
+        request_ids.size.times do
+          reply = read_reply(opts.merge(:lazy => true))
+          unless request_ids.include?(reply.response_to)
+            raise Mongo::SocketError,
+                  "Unexpected reply to request #{reply.response_to}."
+          end
+          replies[reply.response_to] = reply
+        end
+        replies.values_at(*request_ids)
+      end
+
+      # Serializes the messages and writes the data to the connected socket.
+      #
+      # The messages are serialized into a write buffer owned by the
+      # connection, which is emptied and reused for every write so its
+      # memory only grows to the size of the largest write. Large encoded
+      # documents are spliced in rather than copied, and the segments of
+      # the buffer, for several messages back to back, are sent with a
+      # single vectored write to the socket.
+      #
+      # When a compressor was negotiated, messages of at least the
+      # compression threshold are compressed from the segments into
+      # +OP_COMPRESSED+ messages, without joining the segments first.
+      #
+      # While monitoring is enabled, each message written is reported as a
+      # started operation, and messages the server does not reply to as
+      # succeeded once written.
+      #
+      # @example
+      #   connection.write([insert, get_last_error])
+      #
+      # @param messages [Mongo::Protocol::Message, Array] The message or
+      #   messages to write.
       #
       # @return [Integer] The length in bytes of the data written.
-      def write(message)
-        @socket.write(message.serialize)
+      def write(messages)
+        @buffer.reset
+        return instrumented_write(Array(messages)) if Monitoring.enabled?
+        Array(messages).each { |message| message.serialize(@buffer) }
+        write_buffer
+      end
+
+      # Extracts the results a cursor needs from a reply.
+      #
+      # @example
+      #   results = connection.results(connection.read_reply)
+      #
+      # @param reply [Mongo::Protocol::Reply] The reply.
+      #
+      # @return [Hash] The cursor id, number returned, documents and flags.
+      def results(reply)
+        {
+          :cursor_id => reply.cursor_id,
+          :nreturned => reply.number_returned,
+          :docs => reply.documents,
+          :flags => reply.flags
+        }
+      end
+
+      private
+
+      # Runs the block with a deadline of the socket timeout from now, which
+      # covers every connect, write and read the block makes.
+      #
+      # @api private
+      #
+      # @return [Object] The result of the block.
+      def with_deadline
+        @deadline = Socket::Base.monotonic_time + @timeout
+        @socket.deadline = @deadline if @socket
+        yield
+      ensure
+        @deadline = nil
+        @socket.deadline = nil if @socket
+      end
+
+      # Writes the serialized messages of the write buffer to the socket.
+      #
+      # @api private
+      #
+      # @return [Integer] The length in bytes of the data written.
+      def write_buffer
+        @socket.write(*buffer_segments)
+      end
+
+      # Get the segments of the write buffer to write, with the messages
+      # compressed when a compressor was negotiated.
+      #
+      # @api private
+      #
+      # @param sizes [Array<Integer>, nil] Receives the size in bytes each
+      #   message is written with.
+      #
+      # @return [Array<String>] The segments to write.
+      def buffer_segments(sizes = nil)
+        return @buffer.segments unless @compression
+        @compression.compress_segments(@buffer.segments, sizes)
+      end
+
+      # Serializes and writes the messages, reporting an operation for
+      # each of them. The operations of messages the server replies to are
+      # kept in flight until their reply is read.
+      #
+      # @api private
+      #
+      # @param messages [Array<Mongo::Protocol::Message>] The messages.
+      #
+      # @return [Integer] The length in bytes of the data written.
+      def instrumented_write(messages)
+        events = messages.map do |message|
+          start = @buffer.bytesize
+          message.serialize(@buffer)
+          operation_event(message, @buffer.byteslice(start, HEADER_SIZE))
+        end
+        sizes = []
+        segments = buffer_segments(sizes)
+        sizes.each_with_index { |size, i| events[i].bytes_written = size }
+        events.each { |event| Monitoring.publish(:started, event.dup) }
+        started = Monitoring.now
+        begin
+          written = @socket.write(*segments)
+        rescue Mongo::SocketError => e
+          events.each { |event| fail_operation(event, e) }
+          raise
+        end
+        finish_write(events, started)
+        written
+      end
+
+      # Builds the operation event of a serialized message. The pool wait
+      # of the connection is reported with its first operation.
+      #
+      # @api private
+      #
+      # @param message [Mongo::Protocol::Message] The message.
+      # @param header [String] The serialized header of the message.
+      #
+      # @return [Mongo::Monitoring::OperationEvent] The event.
+      def operation_event(message, header)
+        length, request_id, _, op_code =
+          header.unpack(Protocol::Serializers::HEADER_PACK)
+        wait, @pool_wait = @pool_wait || 0.0, nil
+        namespace = message.namespace if message.respond_to?(:namespace)
+        Monitoring::OperationEvent.new(
+          request_id, namespace, op_code, address, length, 0, wait, 0.0, 0.0)
+      end
+
+      # Records the write time of the operations, reporting those the
+      # server does not reply to as succeeded and keeping the others in
+      # flight.
+      #
+      # @api private
+      #
+      # @param events [Array<Mongo::Monitoring::OperationEvent>] The events.
+      # @param started [Float] The time the write started.
+      def finish_write(events, started)
+        written_at = Monitoring.now
+        events.each do |event|
+          event.write_time = written_at - started
+          if REPLY_OP_CODES.include?(event.op_code)
+            @in_flight_lock.synchronize do
+              @in_flight[event.request_id] = [event, written_at]
+            end
+          else
+            Monitoring.publish(:succeeded, event)
+          end
+        end
+      end
+
+      # Reads a reply and reports the operation in flight it replies to,
+      # or fails every operation in flight if the read fails for any
+      # reason, since the connection is discarded then.
+      #
+      # @api private
+      #
+      # @param opts [Hash] The reply deserialization options.
+      #
+      # @return [Mongo::Protocol::Reply] The reply.
+      def instrumented_read_reply(opts)
+        header, body = read_message
+        reply = Protocol::Reply.deserialize_body(header, body, opts)
+        event, written_at = @in_flight_lock.synchronize do
+          @in_flight.delete(reply.response_to)
+        end
+        if event
+          event.bytes_read = HEADER_SIZE + body.bytesize
+          event.read_time = Monitoring.now - written_at
+          Monitoring.publish(:succeeded, event)
+        end
+        reply
+      rescue Exception => e
+        in_flight = @in_flight_lock.synchronize do
+          @in_flight.values.tap { @in_flight.clear }
+        end
+        in_flight.each { |event, _| fail_operation(event, e) }
+        raise
+      end
+
+      # Reports an operation as failed.
+      #
+      # @api private
+      #
+      # @param event [Mongo::Monitoring::OperationEvent] The event.
+      # @param error [Exception] The error the operation failed with.
+      def fail_operation(event, error)
+        event.error = error
+        Monitoring.publish(:failed, event)
+      end
+
+      # Negotiates the compressor with the server, by offering the
+      # configured compressors in an ismaster command and keeping the first
+      # one the server lists back. The command itself is not compressed.
+      #
+      # @api private
+      #
+      # @return [Protocol::Compression, nil] The compression, if any
+      #   compressor is supported by both sides.
+      def negotiate_compression
+        write(handshake)
+        supported = Array((read_reply.documents[0] || {})['compression'])
+        @compression_name = (@compressors & supported).first
+        return unless @compression_name
+        compressor = Protocol::Compression.get(@compression_name,
+                                               @compression_opts)
+        @compression = Protocol::Compression.new(
+          compressor, @compression_opts[:compression_threshold])
+      end
+
+      # Get the ismaster command that offers the compressors.
+      #
+      # @api private
+      #
+      # @return [Protocol::Query] The command.
+      def handshake
+        Protocol::Query.new('admin', '$cmd',
+                            { :ismaster => 1, :compression => @compressors },
+                            :limit => -1)
+      end
+
+      # Reads one complete message off the socket, decompressing it if it
+      # is compressed.
+      #
+      # The header is read into a buffer reused across messages and decoded
+      # from it. The body is read straight into a string of its own, which
+      # is handed to the reply as it is, so an uncompressed body is only
+      # ever copied once, off the socket.
+      #
+      # @api private
+      #
+      # @return [Array<Array<Integer>, String>] The decoded header and the
+      #   body of the message.
+      def read_message
+        read_exactly(HEADER_SIZE, @header)
+        header = @header.unpack(Protocol::Serializers::HEADER_PACK)
+        if header[0] < HEADER_SIZE
+          raise Mongo::SocketError, "Invalid message length #{header[0]}."
+        end
+        body = read_exactly(header[0] - HEADER_SIZE,
+                            ''.force_encoding('BINARY'))
+        return [header, body] unless Protocol::Compression.compressed?(@header)
+        unless @compression
+          raise Mongo::SocketError, 'Unexpected compressed message.'
+        end
+        message = @compression.decompress(@header + body)
+        [message.unpack(Protocol::Serializers::HEADER_PACK),
+         message.byteslice(HEADER_SIZE..-1)]
+      end
+
+      # Reads exactly +length+ bytes from the socket into the buffer.
+      #
+      # @api private
+      #
+      # @param length [Integer] The number of bytes to read.
+      # @param buffer [String] The buffer to read into.
+      #
+      # @raise [Mongo::SocketError] If the socket closed before all bytes
+      #   were read.
+      #
+      # @return [String] The buffer.
+      def read_exactly(length, buffer)
+        data = @socket.read(length, buffer)
+        unless data && data.bytesize == length
+          raise Mongo::SocketError, 'Socket closed while reading a message.'
+        end
+        buffer
       end
 
     end
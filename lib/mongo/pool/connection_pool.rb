@@ -0,0 +1,398 @@
+# Copyright (C) 2013 MongoDB, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+module Mongo
+  module Pool
+
+    # A bounded, thread safe pool of connections to a single node.
+    #
+    # Available connections are kept on a stack so the most recently used
+    # connection is handed out first, which lets the least recently used
+    # ones age out and be reaped once they have been idle for longer than
+    # +:max_idle_time+.
+    #
+    # Under a fiber scheduler a checkout waiting for a connection only
+    # blocks its own fiber, so many fibers of one thread can share the pool.
+    #
+    # While monitoring is enabled, checkouts, checkins and the creation and
+    # closing of connections are published as pool events, and the time a
+    # checkout waited is reported with the next operation of the connection.
+    class ConnectionPool
+
+      # The default maximum number of connections in the pool.
+      DEFAULT_MAX_SIZE = 5
+
+      # The default minimum number of connections kept open in the pool.
+      DEFAULT_MIN_SIZE = 0
+
+      # The default time in seconds to wait for a connection to be checked
+      # back in when the pool is at its maximum size.
+      DEFAULT_WAIT_TIMEOUT = 1
+
+      # @!attribute max_size
+      #   @return [Integer] The maximum number of connections in the pool.
+      # @!attribute min_size
+      #   @return [Integer] The number of connections that are never reaped.
+      # @!attribute wait_timeout
+      #   @return [Numeric] The checkout wait timeout in seconds.
+      # @!attribute max_idle_time
+      #   @return [Numeric, nil] Idle time in seconds before a connection is
+      #     reaped, or nil if connections are never reaped.
+      # @!attribute size
+      #   @return [Integer] The number of connections owned by the pool.
+      attr_reader :max_size, :min_size, :wait_timeout, :max_idle_time, :size
+
+      # Initializes a new connection pool. No connections are created until
+      # the first checkout.
+      #
+      # @example
+      #   ConnectionPool.new(:max_pool_size => 10) do
+      #     Connection.new('localhost', 27017)
+      #   end
+      #
+      # @param opts [Hash] Optional settings and configuration values.
+      # @param block [Proc] The block used to create a new connection.
+      #
+      # @option opts [Integer] :max_pool_size (5) The maximum number of
+      #   connections in the pool.
+      # @option opts [Integer] :min_pool_size (0) The number of connections
+      #   that are kept open when reaping idle connections.
+      # @option opts [Numeric] :wait_queue_timeout (1) The time in seconds to
+      #   wait for a connection to become available.
+      # @option opts [Numeric] :max_idle_time (nil) The time in seconds an
+      #   available connection may go unused before it is closed.
+      #
+      # @return [ConnectionPool] The connection pool instance.
+      def initialize(opts = {}, &block)
+        @max_size      = opts[:max_pool_size] || DEFAULT_MAX_SIZE
+        @min_size      = opts[:min_pool_size] || DEFAULT_MIN_SIZE
+        @wait_timeout  = opts[:wait_queue_timeout] || DEFAULT_WAIT_TIMEOUT
+        @max_idle_time = opts[:max_idle_time]
+        @factory       = block
+        @available     = []
+        @size          = 0
+        @generation    = 0
+        @mutex         = Mutex.new
+        @resource      = ConditionVariable.new
+      end
+
+      # Checks out a connection, creating a new one if none are available
+      # and the pool has not reached its maximum size. Blocks for up to
+      # +wait_timeout+ seconds otherwise.
+      #
+      # @example
+      #   connection = pool.checkout
+      #
+      # @raise [WaitTimeout] If no connection became available in time.
+      #
+      # @return [Connection] The leased connection.
+      def checkout
+        started = Monitoring.now if Monitoring.enabled?
+        reaped = []
+        begin
+          connection = @mutex.synchronize { acquire(reaped) }
+        ensure
+          close_reaped(reaped)
+        end
+        connection ||= create_connection
+        connection.lease
+        checked_out(connection, started) if started
+        connection
+      end
+
+      # Returns a connection to the pool and wakes up one waiting thread.
+      # Connections made before the process forked are dropped instead,
+      # without closing them, as the pool no longer counts them.
+      #
+      # @example
+      #   pool.checkin(connection)
+      #
+      # @param connection [Connection] The connection to return.
+      def checkin(connection)
+        @mutex.synchronize do
+          return unless current?(connection)
+          @available.push(connection)
+          @resource.signal
+        end
+        publish(:checked_in, connection) if Monitoring.enabled?
+      end
+
+      # Removes a connection from the pool and disconnects it. Used when a
+      # connection can no longer be trusted, for instance after a socket
+      # error left it in an unknown state. Connections made before the
+      # process forked are left open, like in #after_fork.
+      #
+      # @example
+      #   pool.discard(connection)
+      #
+      # @param connection [Connection] The checked out connection.
+      def discard(connection)
+        connection.expire
+        @mutex.synchronize do
+          return unless current?(connection)
+          @size -= 1
+          @resource.signal
+        end
+        connection.disconnect
+        publish(:connection_closed, connection) if Monitoring.enabled?
+      end
+
+      # Yields a checked out connection and checks it back in once the block
+      # finishes. Connections are discarded when the block raises, whatever
+      # the error: it may have been raised between a write and its reply,
+      # say by a timeout or a failed decode, and the next borrower would
+      # read that reply.
+      #
+      # @example
+      #   pool.with_connection do |connection|
+      #     connection.write(message)
+      #   end
+      #
+      # @return [Object] The result of the block.
+      def with_connection
+        connection = checkout
+        yield(connection)
+      rescue Exception
+        if connection
+          discard(connection)
+          connection = nil
+        end
+        raise
+      ensure
+        checkin(connection) if connection
+      end
+
+      # Opens connections until the pool holds +min_size+ of them, so that
+      # the first checkouts do not wait for a connection to be made. The
+      # new connections count as just used, to be kept until they have been
+      # idle for +max_idle_time+.
+      #
+      # @example
+      #   pool.warm
+      #
+      # @return [ConnectionPool] The pool.
+      def warm
+        while reserve_warm_slot
+          connection = create_connection
+          connection.lease
+          @mutex.synchronize do
+            @available.push(connection)
+            @resource.signal
+          end
+        end
+        self
+      end
+
+      # Forgets every connection of the pool without closing them, in a
+      # process forked from the one that made them. Their sockets are
+      # shared with the parent process, which keeps using them, so closing
+      # them here, which sends a TLS close notification for SSL sockets,
+      # would break the parent's connections.
+      #
+      # Connections that were checked out when the process forked belong to
+      # the previous generation of the pool and are dropped when checked
+      # back in.
+      #
+      # @example
+      #   pool.after_fork
+      #
+      # @return [ConnectionPool] The pool.
+      def after_fork
+        @mutex.synchronize do
+          @available = []
+          @size = 0
+          @generation += 1
+        end
+        self
+      end
+
+      # Get the number of connections waiting to be checked out.
+      #
+      # @example
+      #   pool.available
+      #
+      # @return [Integer] The number of available connections.
+      def available
+        @mutex.synchronize { @available.size }
+      end
+
+      # Get a human-readable string representation of the pool.
+      #
+      # @return [String] A string representation of the pool.
+      def inspect
+        "<Mongo::Pool::ConnectionPool:0x#{object_id} size=#{@size} " +
+        "max_size=#{@max_size} available=#{@available.size}>"
+      end
+
+      # Exception that is raised when no connection could be checked out
+      # within the wait timeout.
+      class WaitTimeout < DriverError
+
+        # Instantiate the new exception.
+        #
+        # @example
+        #   WaitTimeout.new(1)
+        #
+        # @param timeout [Numeric] The wait timeout that was exceeded.
+        def initialize(timeout)
+          super("Timed out after #{timeout} seconds waiting for a " +
+                'connection from the pool.')
+        end
+      end
+
+      private
+
+      # Takes an available connection or reserves room for a new one. Must
+      # be called while holding the pool lock.
+      #
+      # @api private
+      #
+      # @param reaped [Array<Connection>] Collects the idle connections
+      #   taken out of the pool, to be closed once the lock is released.
+      #
+      # @return [Connection, nil] An available connection, or nil when the
+      #   caller should create a new connection.
+      def acquire(reaped)
+        deadline = Time.now + @wait_timeout
+        loop do
+          reap(reaped)
+          return @available.pop unless @available.empty?
+          if @size < @max_size
+            @size += 1
+            return nil
+          end
+          remaining = deadline - Time.now
+          raise WaitTimeout.new(@wait_timeout) if remaining <= 0
+          @resource.wait(@mutex, remaining)
+        end
+      end
+
+      # Reserves room for a connection while the pool holds fewer than
+      # +min_size+ connections.
+      #
+      # @api private
+      #
+      # @return [true, false] If room was reserved.
+      def reserve_warm_slot
+        @mutex.synchronize do
+          reserved = @size < @min_size
+          @size += 1 if reserved
+          reserved
+        end
+      end
+
+      # Creates a new connection for a slot reserved by #acquire, releasing
+      # the slot again if the connection cannot be made.
+      #
+      # @api private
+      #
+      # @return [Connection] The new connection.
+      def create_connection
+        connection = @factory.call
+        connection.pool_generation = @mutex.synchronize { @generation }
+        publish(:connection_created, connection) if Monitoring.enabled?
+        connection
+      rescue StandardError
+        @mutex.synchronize do
+          @size -= 1
+          @resource.signal
+        end
+        raise
+      end
+
+      # Takes the available connections that have been idle for longer than
+      # +max_idle_time+ out of the pool, leaving at least +min_size+
+      # connections. Must be called while holding the pool lock.
+      #
+      # @api private
+      #
+      # @param reaped [Array<Connection>] Collects the connections taken out.
+      def reap(reaped)
+        return unless @max_idle_time
+        cutoff = Time.now - @max_idle_time
+        while @size > @min_size && idle?(@available.first, cutoff)
+          connection = @available.shift
+          connection.expire
+          @size -= 1
+          reaped.push(connection)
+        end
+      end
+
+      # Closes the reaped connections and publishes their closing. Called
+      # without holding the pool lock, so neither closing a socket nor a
+      # subscriber holds up other checkouts, and subscribers may use the
+      # pool.
+      #
+      # @api private
+      #
+      # @param reaped [Array<Connection>] The reaped connections.
+      def close_reaped(reaped)
+        reaped.each do |connection|
+          connection.disconnect
+          publish(:connection_closed, connection) if Monitoring.enabled?
+        end
+      end
+
+      # Records the time a checkout waited on the connection, to be reported
+      # with its next operation, and publishes the checkout.
+      #
+      # @api private
+      #
+      # @param connection [Connection] The checked out connection.
+      # @param started [Float] The time the checkout started.
+      def checked_out(connection, started)
+        wait = Monitoring.now - started
+        connection.pool_wait = wait
+        publish(:checked_out, connection, wait)
+      end
+
+      # Publishes a pool event about a connection.
+      #
+      # @api private
+      #
+      # @param name [Symbol] The name of the event.
+      # @param connection [Connection] The connection.
+      # @param wait [Float, nil] The time a checkout waited.
+      def publish(name, connection, wait = nil)
+        event = Monitoring::PoolEvent.new(connection.address, wait, @size)
+        Monitoring.publish(name, event)
+      end
+
+      # Whether the connection was made by the current generation of the
+      # pool, rather than before the process forked. Must be called while
+      # holding the pool lock.
+      #
+      # @api private
+      #
+      # @param connection [Connection] The connection to check.
+      #
+      # @return [true, false] If the pool counts the connection.
+      def current?(connection)
+        connection.pool_generation == @generation
+      end
+
+      # Whether the connection was last leased before the cutoff.
+      #
+      # @api private
+      #
+      # @param connection [Connection, nil] The connection to check.
+      # @param cutoff [Time] The oldest acceptable lease time.
+      #
+      # @return [true, false] If the connection is idle.
+      def idle?(connection, cutoff)
+        !!connection && (connection.expired? || connection.last_use < cutoff)
+      end
+    end
+  end
+end
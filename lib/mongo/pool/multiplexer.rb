@@ -0,0 +1,233 @@
+# Copyright (C) 2013 MongoDB, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+module Mongo
+  module Pool
+
+    # Shares one connection between many threads. Each thread writes its
+    # request onto the socket and then waits for the reply to it, which is
+    # routed to it by the response to id of the reply.
+    #
+    # There is no dedicated reader thread. Whenever replies are awaited,
+    # one of the waiting threads reads replies off the socket on behalf of
+    # all of them, until its own reply arrives and another waiting thread
+    # takes over.
+    #
+    # The server handles the requests of a connection one at a time, so a
+    # multiplexer suits many small requests rather than long running ones.
+    #
+    # @example
+    #   multiplexer = Multiplexer.new(connection)
+    #   results, node = multiplexer.send_and_receive(1, query)
+    class Multiplexer
+
+      # @!attribute connection
+      #   @return [Connection] The shared connection.
+      attr_reader :connection
+
+      # Initializes a new multiplexer over a connection. The connection is
+      # connected when the first request is sent.
+      #
+      # @example
+      #   Multiplexer.new(Connection.new('::1', 27017, nil, :connect => false))
+      #
+      # @param connection [Connection] The connection to share.
+      #
+      # @return [Multiplexer] The multiplexer instance.
+      def initialize(connection)
+        @connection = connection
+        @connected  = false
+        @generation = 0
+        @reading    = false
+        @replies    = {}
+        @abandoned  = {}
+        @write_lock = Mutex.new
+        @mutex      = Mutex.new
+        @replied    = ConditionVariable.new
+      end
+
+      # Get the node of the shared connection.
+      #
+      # @return [Mongo::Node] The node the connection belongs to, if any.
+      def node
+        @connection.node
+      end
+
+      # Writes a message and waits for its reply, resending the message on
+      # a new connection after a socket error until +tries+ attempts have
+      # been made. The documents of the reply are decoded lazily.
+      #
+      # @example
+      #   results, node = multiplexer.send_and_receive(3, query)
+      #
+      # @param tries [Integer] The number of attempts to make.
+      # @param message [Mongo::Protocol::Message] The message to send.
+      # @param opts [Hash] The reply deserialization options.
+      #
+      # @option opts [true, false] :raw Return the documents as BSON bytes.
+      #
+      # @return [Array<Hash, Mongo::Node>] The results of the reply, made of
+      #   its +:cursor_id+, +:nreturned+, +:docs+ and +:flags+, and the
+      #   node.
+      def send_and_receive(tries, message, opts = {})
+        attempt = 0
+        begin
+          attempt += 1
+          reply = await(*dispatch(message))
+        rescue Mongo::SocketError
+          raise if attempt >= tries
+          retry
+        end
+        reply.documents.raw! if opts[:raw]
+        [@connection.results(reply), node]
+      end
+
+      # Get a human-readable string representation of the multiplexer.
+      #
+      # @return [String] A string representation of the multiplexer.
+      def inspect
+        "<Mongo::Pool::Multiplexer:0x#{object_id} " +
+        "host=#{@connection.host} port=#{@connection.port}>"
+      end
+
+      private
+
+      # Writes the message, connecting first if the connection is not
+      # connected, for instance after a socket error. A failed write fails
+      # every request in flight.
+      #
+      # @api private
+      #
+      # @param message [Mongo::Protocol::Message] The message to send.
+      #
+      # @return [Array<Integer>] The request id of the message and the
+      #   generation of the connection it was written to.
+      def dispatch(message)
+        @write_lock.synchronize do
+          unless @connected
+            @connection.connect
+            @connected = true
+          end
+          begin
+            @connection.write(message)
+          rescue Exception
+            reset
+            raise
+          end
+          [message.request_id, @mutex.synchronize { @generation }]
+        end
+      end
+
+      # Waits for the reply to a request, reading replies off the socket
+      # whenever no other thread is. When the wait is interrupted before
+      # the reply arrived, the request is marked as abandoned, so its reply
+      # is dropped on arrival rather than kept forever.
+      #
+      # @api private
+      #
+      # @param request_id [Integer] The request id of the message.
+      # @param generation [Integer] The generation it was written to.
+      #
+      # @raise [Mongo::SocketError] If the connection failed before the
+      #   reply was read.
+      #
+      # @return [Mongo::Protocol::Reply] The reply.
+      def await(request_id, generation)
+        @mutex.synchronize do
+          reply = nil
+          begin
+            until @replies.key?(request_id)
+              if @generation != generation
+                raise Mongo::SocketError, 'The shared connection failed.'
+              end
+              @reading ? @replied.wait(@mutex) : read_next
+            end
+            reply = @replies.delete(request_id)
+          ensure
+            abandon(request_id, generation) unless reply
+          end
+        end
+      end
+
+      # Forgets the reply to a request whose waiter stopped waiting, or mark
+      # the request as abandoned if its reply has not arrived yet. Must be
+      # called while holding the lock.
+      #
+      # @api private
+      #
+      # @param request_id [Integer] The request id of the message.
+      # @param generation [Integer] The generation it was written to.
+      def abandon(request_id, generation)
+        return if @replies.delete(request_id) || @generation != generation
+        @abandoned[request_id] = true
+      end
+
+      # Reads the next reply and keeps it for its waiter, unless the request
+      # was abandoned, then wakes up the waiting threads. Must be called
+      # while holding the lock, which is released for the duration of the
+      # read.
+      #
+      # @api private
+      def read_next
+        @reading = true
+        @mutex.unlock
+        begin
+          reply = receive
+        ensure
+          @mutex.lock
+          @reading = false
+          @replied.broadcast
+        end
+        return unless reply
+        return if @abandoned.delete(reply.response_to)
+        @replies[reply.response_to] = reply
+      end
+
+      # Reads a reply off the socket. A socket error leaves the connection
+      # in an unknown state, so it is disconnected and every request in
+      # flight on it fails. So does a read that ends any other way, such
+      # as the reading thread being interrupted or killed.
+      #
+      # @api private
+      #
+      # @return [Mongo::Protocol::Reply, nil] The reply, or nil if the
+      #   connection failed.
+      def receive
+        reply = nil
+        begin
+          reply = @connection.read_reply(:lazy => true)
+        rescue Mongo::SocketError
+          nil
+        ensure
+          @write_lock.synchronize { reset } unless reply
+        end
+      end
+
+      # Disconnects the connection and starts a new generation, so that the
+      # requests written to the old one stop waiting for their replies. Must
+      # be called while holding the write lock.
+      #
+      # @api private
+      def reset
+        @connection.disconnect
+        @connected = false
+        @mutex.synchronize do
+          @generation += 1
+          @replies.clear
+          @abandoned.clear
+        end
+      end
+    end
+  end
+end
@@ -1,4 +1,6 @@
 require 'mongo/pool/socket/base'
+require 'mongo/pool/socket/resolver'
 require 'mongo/pool/socket/tcp'
+require 'mongo/pool/socket/ssl_context'
 require 'mongo/pool/socket/ssl'
 require 'mongo/pool/socket/unix'
@@ -13,6 +13,7 @@
 # limitations under the License.
 
 require 'socket'
+require 'io/wait'
 require 'openssl'
 require 'timeout'
 
@@ -21,32 +22,112 @@ module Mongo
     module Socket
 
       # Module for behavior common across all supported socket types.
+      #
+      # Sockets are used in non-blocking mode. Every read, write and connect
+      # waits for the socket to become ready, for no longer than what is
+      # left of the deadline of the current operation, or of the socket
+      # timeout when no deadline is set.
+      #
+      # The waits go through IO#wait_readable and IO#wait_writable, which
+      # hand over to the fiber scheduler of the thread when there is one.
+      # Inside a non-blocking fiber an operation then yields to the other
+      # fibers until its socket is ready, so one thread can run many
+      # operations at once.
       module Base
 
         include ::Socket::Constants
 
-        # Reads data from the socket instance.
+        # Whether IO#write takes several strings, which it then sends with a
+        # single writev call.
+        VECTORED_WRITE = ::IO.instance_method(:write).arity != 1
+
+        # The number of segments passed to each vectored write, kept below
+        # the IOV_MAX of common platforms beyond which Ruby stops using
+        # writev.
+        MAX_SEGMENTS = 512
+
+        # The time in seconds to wait for a connection attempt before the
+        # next address is tried alongside it, as in RFC 6555.
+        CONNECT_ATTEMPT_DELAY = 0.25
+
+        # The errors raised by a socket call that timed out.
+        TIMEOUT_ERRORS = [Errno::ETIMEDOUT]
+        TIMEOUT_ERRORS << ::IO::TimeoutError if defined?(::IO::TimeoutError)
+
+        # @return [Float, nil] The monotonic time by which the current
+        #   operation must complete, or nil when each wait is given the
+        #   whole socket timeout.
+        attr_accessor :deadline
+
+        # Get the current time of a monotonic clock where one is available.
+        #
+        # @example
+        #   Base.monotonic_time
+        #
+        # @return [Float] The current time in seconds.
+        def self.monotonic_time
+          if defined?(Process::CLOCK_MONOTONIC)
+            Process.clock_gettime(Process::CLOCK_MONOTONIC)
+          else
+            Time.now.to_f
+          end
+        end
+
+        # Reads data from the socket instance, waiting for it to arrive
+        # until the operation times out.
         #
         # @example
         #   socket.read(4096)
+        #   socket.read(4096, buffer)
         #
         # @param  length [Integer] The length of data to read.
+        # @param  buffer [String] Optional buffer to read the data into.
         #
-        # @return [Object] The data read from the socket.
-        def read(length)
-          handle_socket_error { @socket.read(length) }
+        # @return [Object] The data read from the socket, shorter than the
+        #   length if the stream ended, or nil if it had already ended.
+        def read(length, buffer = nil)
+          buffer ||= ''.force_encoding('BINARY')
+          handle_socket_error do
+            return nil unless read_available(length, buffer)
+            while buffer.bytesize < length
+              chunk = read_available(length - buffer.bytesize, read_chunk)
+              break unless chunk
+              buffer << chunk
+            end
+            buffer
+          end
         end
 
-        # Writes data to the socket instance.
+        # Writes data to the socket instance. Several strings are sent with
+        # a single vectored write where the Ruby supports it and can bound
+        # its wait with an IO timeout, and joined otherwise.
         #
         # @example
         #   socket.write(data)
+        #   socket.write(header, document, trailer)
         #
-        # @param  *args [Object] The data to be written.
+        # @param  *args [String] The data to be written.
         #
         # @return [Integer] The length of bytes written to the socket.
         def write(*args)
-          handle_socket_error { @socket.write(args) }
+          handle_socket_error do
+            if args.size > 1 && vectored_write?
+              write_segments(args)
+            else
+              write_available(args.join)
+            end
+          end
+        end
+
+        # Closes the socket, if it is open.
+        #
+        # @example
+        #   socket.close
+        #
+        # @return [nil] Always nil.
+        def close
+          @socket.close if @socket && !@socket.closed?
+          nil
         end
 
         private
@@ -54,6 +135,12 @@ module Mongo
         # Helper method to handle connection logic for tcp socket types and
         # all possible socket address families.
         #
+        # The addresses are tried in the order of the resolver, alternating
+        # between address families. When an attempt has not completed after
+        # +CONNECT_ATTEMPT_DELAY+, the next address is tried while it stays
+        # pending, and the first connection to complete is used. Resolved
+        # addresses are reused until none of them can be connected to.
+        #
         # @api private
         #
         # @example
@@ -61,19 +148,255 @@ module Mongo
         #
         # @return [Socket] The connected socket instance.
         def handle_connect
-          error  = nil
-          addr_info = ::Socket.getaddrinfo(@host, nil, AF_UNSPEC, SOCK_STREAM)
-          addr_info.each do |info|
+          addresses = interleave(Resolver.resolve(@host))
+          pending = {}
+          error = nil
+          until addresses.empty? && pending.empty?
             begin
-              sock        = create_socket(info[4])
-              socket_addr = ::Socket.pack_sockaddr_in(@port, info[3])
-              sock.connect(socket_addr)
-              return sock
+              sock = start_connect(addresses.shift, pending) if addresses.any?
+              sock ||= await_connect(pending, addresses.empty?)
+              return sock if sock
             rescue IOError, SystemCallError => e
               error = e
             end
           end
+          Resolver.forget(@host)
           raise error
+        ensure
+          pending.each_key(&:close) if pending
+        end
+
+        # Orders the resolved addresses so that address families alternate,
+        # starting with the family of the first address.
+        #
+        # @api private
+        #
+        # @param addresses [Array<Array>] The getaddrinfo results.
+        #
+        # @return [Array<Array>] The reordered results.
+        def interleave(addresses)
+          family = addresses.first && addresses.first[0]
+          first, other = addresses.partition { |info| info[0] == family }
+          Array.new([first.size, other.size].max) do |i|
+            [first[i], other[i]]
+          end.flatten(1).compact
+        end
+
+        # Starts a non-blocking connection attempt to the address.
+        #
+        # @api private
+        #
+        # @param info [Array] The getaddrinfo result for the address.
+        # @param pending [Hash] The pending attempts by socket.
+        #
+        # @return [Socket, nil] The socket if it connected at once, nil if
+        #   the attempt is pending.
+        def start_connect(info, pending)
+          sock = create_socket(info[4])
+          socket_addr = ::Socket.pack_sockaddr_in(@port, info[3])
+          begin
+            sock.connect_nonblock(socket_addr)
+            sock
+          rescue IO::WaitWritable
+            pending[sock] = socket_addr
+            nil
+          rescue IOError, SystemCallError
+            sock.close
+            raise
+          end
+        end
+
+        # Waits for one of the pending connection attempts to complete.
+        # Unless the last address is being waited on, only waits for
+        # +CONNECT_ATTEMPT_DELAY+ before the next address is tried. IO.select
+        # hands over to the fiber scheduler as well, where the scheduler
+        # supports it.
+        #
+        # @api private
+        #
+        # @param pending [Hash] The pending attempts by socket.
+        # @param last [true, false] Whether no addresses are left to try.
+        #
+        # @raise [Mongo::SocketTimeoutError] If the last attempts did not
+        #   complete in time.
+        #
+        # @return [Socket, nil] The connected socket, if any.
+        def await_connect(pending, last)
+          return nil if pending.empty?
+          remaining = remaining_time
+          wait = remaining
+          wait = [CONNECT_ATTEMPT_DELAY, remaining].compact.min unless last
+          _, ready = ::IO.select(nil, pending.keys, nil, wait)
+          if ready.nil? && wait == remaining
+            raise Mongo::SocketTimeoutError, 'Socket connection timed out.'
+          end
+          Array(ready).each do |sock|
+            return sock if finish_connect(sock, pending)
+          end
+          nil
+        end
+
+        # Checks the result of a connection attempt whose socket became
+        # writable.
+        #
+        # @api private
+        #
+        # @param sock [Socket] The socket of the attempt.
+        # @param pending [Hash] The pending attempts by socket.
+        #
+        # @return [true, false] If the socket connected.
+        def finish_connect(sock, pending)
+          sock.connect_nonblock(pending[sock])
+          pending.delete(sock)
+        rescue Errno::EISCONN
+          pending.delete(sock)
+        rescue IO::WaitWritable
+          false
+        rescue IOError, SystemCallError
+          pending.delete(sock)
+          sock.close
+          raise
+        end
+
+        # Reads whatever data is available, up to the length, waiting for
+        # the socket to become readable.
+        #
+        # @api private
+        #
+        # @param length [Integer] The maximum length of data to read.
+        # @param buffer [String] The buffer to read into.
+        #
+        # @return [String, nil] The buffer, or nil at the end of the stream.
+        def read_available(length, buffer)
+          io.read_nonblock(length, buffer)
+        rescue IO::WaitReadable
+          wait_for(:read)
+          retry
+        rescue IO::WaitWritable
+          wait_for(:write)
+          retry
+        rescue EOFError
+          nil
+        end
+
+        # Writes all of the data, waiting for the socket to become writable
+        # whenever its send buffer is full.
+        #
+        # @api private
+        #
+        # @param data [String] The data to write.
+        #
+        # @return [Integer] The length of bytes written.
+        def write_available(data)
+          written = 0
+          while written < data.bytesize
+            begin
+              rest = written == 0 ? data : data.byteslice(written..-1)
+              written += io.write_nonblock(rest)
+            rescue IO::WaitWritable
+              wait_for(:write)
+            rescue IO::WaitReadable
+              wait_for(:read)
+            end
+          end
+          written
+        end
+
+        # Whether several strings can be written with a single vectored
+        # write. Ruby waits on a full send buffer itself during those, so
+        # they are only used where the socket takes an IO timeout to bound
+        # that wait, which Ruby supports from 3.2.
+        #
+        # @api private
+        #
+        # @return [true, false] If writes may be vectored.
+        def vectored_write?
+          VECTORED_WRITE && @socket.respond_to?(:timeout=)
+        end
+
+        # Writes the segments with vectored writes. Ruby waits on a full
+        # send buffer itself, so the IO timeout of the socket is set to
+        # what is left of the deadline.
+        #
+        # @api private
+        #
+        # @param segments [Array<String>] The segments to write.
+        #
+        # @return [Integer] The length of bytes written.
+        def write_segments(segments)
+          remaining = remaining_time
+          if remaining && remaining <= 0
+            raise Mongo::SocketTimeoutError, 'Socket request timed out.'
+          end
+          @socket.timeout = remaining
+          segments.each_slice(MAX_SEGMENTS).reduce(0) do |written, slice|
+            written + io.write(*slice)
+          end
+        end
+
+        # Get the IO the data is read from and written to, which is the
+        # socket itself unless it is wrapped.
+        #
+        # @api private
+        #
+        # @return [IO] The socket.
+        def io
+          @socket
+        end
+
+        # Waits for the socket to become ready for reading or writing,
+        # yielding to the fiber scheduler if one is set.
+        #
+        # @api private
+        #
+        # @param mode [Symbol] Either :read or :write.
+        #
+        # @raise [Mongo::SocketTimeoutError] If the socket did not become
+        #   ready in time.
+        def wait_for(mode)
+          timeout = remaining_time
+          if mode == :read
+            return if @socket.wait_readable(timeout)
+          else
+            return if @socket.wait_writable(timeout)
+          end
+          raise Mongo::SocketTimeoutError, 'Socket request timed out.'
+        end
+
+        # Get the time left before the current operation times out.
+        #
+        # @api private
+        #
+        # @return [Float, nil] The time left in seconds, never negative, or
+        #   nil if the socket has no timeout.
+        def remaining_time
+          return @timeout unless @deadline
+          [@deadline - Base.monotonic_time, 0].max
+        end
+
+        # Sets a deadline from the socket timeout for the duration of the
+        # block, unless the operation already has one.
+        #
+        # @api private
+        #
+        # @return [Object] The result of the block.
+        def with_deadline
+          return yield if @deadline || @timeout.nil?
+          begin
+            @deadline = Base.monotonic_time + @timeout
+            yield
+          ensure
+            @deadline = nil
+          end
+        end
+
+        # The buffer the rest of a partial read is read into.
+        #
+        # @api private
+        #
+        # @return [String] The read chunk buffer.
+        def read_chunk
+          @read_chunk ||= ''.force_encoding('BINARY')
         end
 
         # Initializes a new socket instance with default options and encoding.
@@ -92,11 +415,6 @@ module Mongo
           sock = ::Socket.new(family, SOCK_STREAM, 0)
           sock.set_encoding('binary') if sock.respond_to?(:set_encoding)
           sock.setsockopt(IPPROTO_TCP, TCP_NODELAY, 1) if family != AF_UNIX
-
-          timeout_value = [@timeout, 0].pack('l_2')
-          sock.setsockopt(SOL_SOCKET, SO_RCVTIMEO, timeout_value)
-          sock.setsockopt(SOL_SOCKET, SO_SNDTIMEO, timeout_value)
-
           sock
         end
 
@@ -114,7 +432,7 @@ module Mongo
         # @return [Object] The yield result.
         def handle_socket_error
           yield
-          rescue Errno::ETIMEDOUT
+          rescue *TIMEOUT_ERRORS
             raise Mongo::SocketTimeoutError,
                   'Socket request timed out.'
           rescue IOError, SystemCallError
@@ -0,0 +1,78 @@
+# Copyright (C) 2013 MongoDB, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+module Mongo
+  module Pool
+    module Socket
+
+      # Caches the addresses hosts resolve to, so that a new connection to a
+      # node does not wait on a DNS lookup. The first connection to a host,
+      # which is usually the one the monitor makes, resolves it.
+      #
+      # Addresses are kept for +TTL+ seconds, and forgotten as soon as none
+      # of them could be connected to, so that a node that moved is looked
+      # up again.
+      #
+      # @example
+      #   Resolver.resolve('db.example.com')
+      module Resolver
+
+        # The time in seconds the addresses of a host are kept.
+        TTL = 60
+
+        @cache = {}
+        @mutex = Mutex.new
+
+        # Gets the addresses of a host, resolving it unless it was resolved
+        # less than +TTL+ seconds ago.
+        #
+        # @example
+        #   Resolver.resolve('localhost')
+        #
+        # @param host [String] The hostname or IP address.
+        #
+        # @return [Array<Array>] The getaddrinfo results for the host.
+        def self.resolve(host)
+          now = Base.monotonic_time
+          addresses, expiry = @mutex.synchronize { @cache[host] }
+          return addresses if addresses && expiry > now
+          addresses = ::Socket.getaddrinfo(
+            host, nil, ::Socket::AF_UNSPEC, ::Socket::SOCK_STREAM
+          ).freeze
+          @mutex.synchronize { @cache[host] = [addresses, now + TTL] }
+          addresses
+        end
+
+        # Forgets the addresses of a host.
+        #
+        # @example
+        #   Resolver.forget('localhost')
+        #
+        # @param host [String] The hostname or IP address.
+        def self.forget(host)
+          @mutex.synchronize { @cache.delete(host) }
+        end
+
+        # Forgets the addresses of every host.
+        #
+        # @example
+        #   Resolver.clear
+        def self.clear
+          @mutex.synchronize { @cache.clear }
+        end
+      end
+
+    end
+  end
+end
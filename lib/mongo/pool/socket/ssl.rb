@@ -47,39 +47,30 @@ module Mongo
         #   containing a set of concatenated "certification authority"
         #   certificates, which are used to validate the certificates returned
         #   from the other end of the socket connection. Implies :ssl_verify.
+        # @option opts [SSLContext] :ssl_context (nil) The context shared
+        #   with the other sockets of the cluster, which the other SSL
+        #   options are ignored in favor of.
+        # @option opts [Float] :deadline (nil) The monotonic time by which
+        #   the current operation, including the connect, must complete.
         #
         # @return [SSL] The SSL socket instance.
         def initialize(host, port, timeout, opts = {})
-          @host    = host
-          @port    = port
-          @timeout = timeout
+          @host     = host
+          @port     = port
+          @timeout  = timeout
+          @deadline = opts[:deadline]
 
-          @context = OpenSSL::SSL::SSLContext.new
-
-          # client SSL certificate
-          if opts[:ssl_cert]
-            @context.cert =
-              OpenSSL::X509::Certificate.new(File.open(opts[:ssl_cert]))
-          end
-
-          # client private key file (optional if included in cert)
-          if opts[:ssl_key]
-            @context.key = OpenSSL::PKey::RSA.new(File.open(opts[:ssl_key]))
-          end
-
-          # peer certificate validation
-          if opts[:ssl_verify] || opts[:ssl_ca_cert]
-            @ssl_verify          = true
-            @context.ca_file     = opts[:ca_cert]
-            @context.verify_mode = OpenSSL::SSL::VERIFY_PEER
-          end
+          @context    = opts[:ssl_context] || SSLContext.new(opts)
+          @ssl_verify = @context.verify?
 
           connect if opts.fetch(:connect, true)
           self
         end
 
         # Establishes the socket connection and performs
-        # optional SSL valiation.
+        # optional SSL valiation, within the deadline of the current
+        # operation or else the socket timeout. The last session with the
+        # server is resumed when the server still accepts it.
         #
         # @example
         #   sock = SSL.new('::1', 27017, 30)
@@ -87,13 +78,16 @@ module Mongo
         #
         # @return [Socket] The connected socket instance.
         def connect
-          Timeout.timeout(@timeout, Mongo::SocketTimeoutError) do
+          with_deadline do
             @socket = handle_connect
 
             # apply ssl wrapper and perform handshake
-            @ssl_socket = OpenSSL::SSL::SSLSocket.new(@socket, @context)
+            @ssl_socket =
+              OpenSSL::SSL::SSLSocket.new(@socket, @context.context)
             @ssl_socket.sync_close = true
-            @ssl_socket.connect
+            @context.resume(@ssl_socket)
+            handshake
+            @context.resumed(@ssl_socket)
 
             # perform peer cert validation if needed
             if @ssl_verify
@@ -107,6 +101,38 @@ module Mongo
           end
         end
 
+        # Whether the session of the last handshake was resumed.
+        #
+        # @return [true, false] If the handshake was abbreviated.
+        def session_reused?
+          !!(@ssl_socket && @ssl_socket.session_reused?)
+        end
+
+        private
+
+        # Get the SSL socket the data is read from and written to.
+        #
+        # @api private
+        #
+        # @return [OpenSSL::SSL::SSLSocket] The SSL socket.
+        def io
+          @ssl_socket
+        end
+
+        # Performs the SSL handshake without blocking, waiting on the
+        # underlying socket whenever the handshake needs to read or write.
+        #
+        # @api private
+        def handshake
+          @ssl_socket.connect_nonblock
+        rescue IO::WaitReadable
+          wait_for(:read)
+          retry
+        rescue IO::WaitWritable
+          wait_for(:write)
+          retry
+        end
+
       end
 
     end
@@ -0,0 +1,214 @@
+# Copyright (C) 2013 10gen Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+module Mongo
+  module Pool
+    module Socket
+
+      # The SSL configuration shared by every SSL socket of a cluster.
+      #
+      # The certificate and key files are read once, when the context is
+      # built, and the OpenSSL context is frozen so that sockets on any
+      # thread can use it. The sessions negotiated with each server are
+      # kept, and new connections to the same server offer them to resume
+      # the session, which saves a full handshake.
+      #
+      # @example
+      #   context = SSLContext.new(:ssl_cert => '/path/to/cert.pem')
+      #   SSL.new('127.0.0.1', 27017, 30, :ssl_context => context)
+      class SSLContext
+
+        # The number of sessions kept for each server.
+        MAX_SESSIONS = 16
+
+        # The name OpenSSL gives to the TLS 1.3 protocol version.
+        TLS1_3 = 'TLSv1.3'
+
+        # @!attribute context
+        #   @return [OpenSSL::SSL::SSLContext] The frozen OpenSSL context.
+        attr_reader :context
+
+        # Builds the shared context from the SSL options, when SSL is
+        # enabled.
+        #
+        # @example
+        #   SSLContext.get(:ssl => true)
+        #
+        # @param opts [Hash] The connection options.
+        #
+        # @return [SSLContext, nil] The context, or nil without SSL.
+        def self.get(opts)
+          opts[:ssl_context] || (new(opts) if enabled?(opts))
+        end
+
+        # Whether the options enable SSL. An +:ssl+ option decides, so that
+        # +:ssl => false+ turns SSL off whatever other SSL options are set.
+        # Without it, any SSL option turns SSL on.
+        #
+        # @example
+        #   SSLContext.enabled?(:ssl => false, :ssl_verify => true)
+        #
+        # @param opts [Hash] The connection options.
+        #
+        # @return [true, false] If connections use SSL.
+        def self.enabled?(opts)
+          return !!opts[:ssl] if opts.key?(:ssl)
+          opts.any? { |key, _| key.to_s.start_with?('ssl') }
+        end
+
+        # Initializes a new shared context.
+        #
+        # @param opts [Hash] The SSL options.
+        #
+        # @option opts [String] :ssl_cert (nil) Path to the certificate file
+        #   used to identify the local connection against MongoDB.
+        # @option opts [String] :ssl_key (nil) Path to the private key file
+        #   used to identify the local connection against MongoDB. If
+        #   included in the ssl certificate file then only :ssl_cert is
+        #   needed.
+        # @option opts [true, false] :ssl_verify (nil) Specifies whether or
+        #   not peer certificate validation should occur.
+        # @option opts [String] :ssl_ca_cert (nil) Path to the :ca_certs
+        #   file containing a set of concatenated "certification authority"
+        #   certificates, which are used to validate the certificates
+        #   returned from the other end of the socket connection. Implies
+        #   :ssl_verify.
+        #
+        # @return [SSLContext] The context instance.
+        def initialize(opts = {})
+          @verify   = !!(opts[:ssl_verify] || opts[:ssl_ca_cert])
+          @sessions = {}
+          @mutex    = Mutex.new
+          @context  = build(opts)
+        end
+
+        # Whether peer certificates are verified.
+        #
+        # @return [true, false] If peer certificate validation occurs.
+        def verify?
+          @verify
+        end
+
+        # Offers the newest session negotiated with the server the socket
+        # is connected to, if any, for the socket to resume. The session is
+        # taken out, so that sockets connecting at the same time each offer
+        # a different one, as TLS 1.3 sessions may only be resumed once.
+        #
+        # @param ssl_socket [OpenSSL::SSL::SSLSocket] The socket, before its
+        #   handshake.
+        def resume(ssl_socket)
+          key = server(ssl_socket)
+          return unless key
+          session = @mutex.synchronize do
+            sessions = @sessions[key]
+            sessions.pop if sessions
+          end
+          ssl_socket.session = session if session
+        rescue OpenSSL::SSL::SSLError
+          nil
+        end
+
+        # Keeps the session of a socket that resumed one after its
+        # handshake, unless it was a TLS 1.3 one, where the server sends
+        # new sessions instead.
+        #
+        # @param ssl_socket [OpenSSL::SSL::SSLSocket] The socket, after its
+        #   handshake.
+        def resumed(ssl_socket)
+          return unless ssl_socket.session_reused?
+          return if ssl_socket.ssl_version == TLS1_3
+          store(ssl_socket, ssl_socket.session)
+        end
+
+        # Forgets the kept sessions, in a process forked from the one that
+        # negotiated them, so that the parent and child processes do not
+        # both offer the same sessions.
+        def clear
+          @mutex.synchronize { @sessions.clear }
+        end
+
+        private
+
+        # Builds the OpenSSL context and freezes it, which also sets it up,
+        # as OpenSSL would otherwise do on the first socket.
+        #
+        # @api private
+        #
+        # @param opts [Hash] The SSL options.
+        #
+        # @return [OpenSSL::SSL::SSLContext] The frozen context.
+        def build(opts)
+          context = OpenSSL::SSL::SSLContext.new
+
+          # client SSL certificate
+          if opts[:ssl_cert]
+            context.cert =
+              OpenSSL::X509::Certificate.new(File.read(opts[:ssl_cert]))
+          end
+
+          # client private key file (optional if included in cert)
+          if opts[:ssl_key]
+            context.key = OpenSSL::PKey::RSA.new(File.read(opts[:ssl_key]))
+          end
+
+          # peer certificate validation
+          if @verify
+            context.ca_file     = opts[:ssl_ca_cert]
+            context.verify_mode = OpenSSL::SSL::VERIFY_PEER
+          end
+
+          context.session_cache_mode =
+            OpenSSL::SSL::SSLContext::SESSION_CACHE_CLIENT
+          context.session_new_cb = proc do |ssl_socket, session|
+            store(ssl_socket, session)
+          end
+          context.freeze
+          context
+        end
+
+        # Keeps a session negotiated with a server, dropping the oldest one
+        # past +MAX_SESSIONS+.
+        #
+        # @api private
+        #
+        # @param ssl_socket [OpenSSL::SSL::SSLSocket] The socket.
+        # @param session [OpenSSL::SSL::Session] The new session.
+        def store(ssl_socket, session)
+          key = server(ssl_socket)
+          return unless key
+          @mutex.synchronize do
+            sessions = (@sessions[key] ||= [])
+            sessions.push(session)
+            sessions.shift if sessions.size > MAX_SESSIONS
+          end
+        end
+
+        # Get the address of the server a socket is connected to.
+        #
+        # @api private
+        #
+        # @param ssl_socket [OpenSSL::SSL::SSLSocket] The socket.
+        #
+        # @return [String, nil] The address and port of the server, or nil
+        #   if the socket is not connected.
+        def server(ssl_socket)
+          ssl_socket.io.remote_address.inspect_sockaddr
+        rescue SystemCallError, IOError
+          nil
+        end
+      end
+
+    end
+  end
+end
@@ -35,18 +35,22 @@ module Mongo
         #
         # @option opts [true, false] :connect (true) If true calls connect
         #   before returning the object instance.
+        # @option opts [Float] :deadline (nil) The monotonic time by which
+        #   the current operation, including the connect, must complete.
         #
         # @return [TCP] The TCP socket instance.
         def initialize(host, port, timeout, opts = {})
-          @host    = host
-          @port    = port
-          @timeout = timeout
+          @host     = host
+          @port     = port
+          @timeout  = timeout
+          @deadline = opts[:deadline]
 
           connect if opts.fetch(:connect, true)
           self
         end
 
-        # Establishes a socket connection.
+        # Establishes a socket connection, within the deadline of the
+        # current operation or else the socket timeout.
         #
         # @example
         #   sock = TCP.new('::1', 27017, 30)
@@ -54,9 +58,7 @@ module Mongo
         #
         # @return [Socket] The connected socket instance.
         def connect
-          Timeout.timeout(@timeout, Mongo::SocketTimeoutError) do
-            @socket = handle_connect
-          end
+          with_deadline { @socket = handle_connect }
         end
 
       end
@@ -21,6 +21,10 @@ module Mongo
 
         include Socket::Base
 
+        # The time in seconds to wait before connecting again while the
+        # server's backlog is full.
+        CONNECT_RETRY_INTERVAL = 0.01
+
         # Initializes a new Unix socket.
         #
         # @example
@@ -33,17 +37,21 @@ module Mongo
         #
         # @option opts [true, false] :connect (true) If true calls connect
         #   before returning the object instance.
+        # @option opts [Float] :deadline (nil) The monotonic time by which
+        #   the current operation must complete.
         #
         # @return [Unix] The Unix socket instance.
         def initialize(path, timeout, opts = {})
-          @host    = path
-          @timeout = timeout
+          @host     = path
+          @timeout  = timeout
+          @deadline = opts[:deadline]
 
           connect if opts.fetch(:connect, true)
           self
         end
 
-        # Establishes a socket connection.
+        # Establishes a socket connection, within the deadline of the
+        # current operation or else the socket timeout.
         #
         # @example
         #   sock = Unix.new('/path/to/socket.sock', 30)
@@ -51,18 +59,48 @@ module Mongo
         #
         # @return [Socket] The connected socket instance.
         def connect
-          Timeout.timeout(@timeout, Mongo::SocketTimeoutError) do
+          with_deadline do
             begin
               @socket = create_socket(AF_UNIX)
-              @socket.connect(@host)
-              return @socket
-            rescue IOError, SystemCallError => e
+              connect_socket(::Socket.pack_sockaddr_un(@host))
+              @socket
+            rescue IOError, SystemCallError, Mongo::SocketTimeoutError
               @socket.close if @socket
-              raise e
+              raise
             end
           end
         end
 
+        private
+
+        # Connects the socket without blocking. A pending connection is
+        # waited on, and while the server's backlog is full, which the
+        # socket cannot be waited on for, the connection is tried again
+        # every +CONNECT_RETRY_INTERVAL+.
+        #
+        # @api private
+        #
+        # @param address [String] The packed address of the socket file.
+        #
+        # @raise [Mongo::SocketTimeoutError] If the socket did not connect
+        #   in time.
+        def connect_socket(address)
+          @socket.connect_nonblock(address)
+        rescue IO::WaitWritable, Errno::EAGAIN => e
+          remaining = remaining_time
+          if remaining == 0
+            raise Mongo::SocketTimeoutError, 'Socket connection timed out.'
+          end
+          if e.is_a?(IO::WaitWritable)
+            wait_for(:write)
+          else
+            sleep([CONNECT_RETRY_INTERVAL, remaining].compact.min)
+          end
+          retry
+        rescue Errno::EISCONN
+          nil
+        end
+
       end
 
     end
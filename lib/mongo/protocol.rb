@@ -2,6 +2,15 @@
 require 'mongo/protocol/serializers'
 require 'mongo/protocol/bit_vector'
 require 'mongo/protocol/message'
+require 'mongo/protocol/write_buffer'
+require 'mongo/protocol/compression'
+
+# Native Serializers
+begin
+  require 'mongo/native'
+rescue LoadError
+  # The pure Ruby serializers are used if the extension is not compiled.
+end
 
 # Client Requests
 require 'mongo/protocol/messages/delete'
@@ -12,4 +21,5 @@ require 'mongo/protocol/messages/query'
 require 'mongo/protocol/messages/update'
 
 # Server Responses
+require 'mongo/protocol/lazy_documents'
 require 'mongo/protocol/messages/reply'
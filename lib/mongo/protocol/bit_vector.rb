@@ -17,7 +17,10 @@ module Mongo
     module Serializers
       # Class used to define a bitvector for a MongoDB wire protocol message.
       #
-      # Defines serialization strategy upon initialization.
+      # Defines serialization strategy upon initialization. The flags of
+      # every value the vector can hold are built once, frozen, together
+      # with their packed bytes, so encoding and decoding a vector looks
+      # them up instead of packing or collecting flags for each message.
       #
       # @api private
       class BitVector
@@ -30,30 +33,153 @@ module Mongo
           layout.each_with_index do |field, index|
             @masks[field] = 2**index
           end
+          @masks.freeze
+          @all = 2**layout.size - 1
+          type = Flags.define(@masks)
+          @sets = Array.new(@all + 1) { |bits| type.new(bits, @masks) }.freeze
+          @packed = { [] => @sets[0].bytes }
+          @masks.each { |flag, mask| @packed[[flag]] = @sets[mask].bytes }
+          @packed.freeze
         end
 
-        # Serializes vector by encoding each symbol according to its mask
+        # Gets the flags of a list of flags, to keep as the flags of many
+        # messages.
+        #
+        # @example Get the flags of secondary queries.
+        #   vector.flags([:slave_ok])
+        #
+        # @param value [Array<Symbol>] The flags.
+        # @return [Flags] The frozen flags.
+        def flags(value)
+          @sets[bits(value)]
+        end
+
+        # Serializes vector by encoding each symbol according to its mask.
+        # The bytes of no flag, of a single flag and of Flags are packed
+        # already.
         #
         # @param buffer [IO] Buffer to receive the serialized vector
-        # @param value [Array<Symbol>] Array of flags to encode
+        # @param value [Array<Symbol>, Flags] The flags to encode
         # @return [IO] Buffer that received the serialized vector
         def serialize(buffer, value)
-          bits = 0
-          value.each { |flag| bits |= @masks[flag] }
-          buffer << [bits].pack(INT32_PACK)
+          return buffer << value.bytes if value.is_a?(Flags)
+          buffer << (@packed[value] || @sets[bits(value)].bytes)
         end
 
         # Deserializes vector by decoding the symbol according to its mask
         #
         # @param io [IO] Stream containing the vector to be deserialized
-        # @return [Array<Symbol>] Flags contained in the vector
+        # @return [Flags] Flags contained in the vector. Bits outside the
+        #   layout are ignored.
         def deserialize(io)
-          vector = io.read(4).unpack(INT32_PACK).first
-          flags = []
-          @masks.each do |flag, mask|
-            flags << flag if mask & vector != 0
+          @sets[io.read(4).unpack(INT32_PACK).first & @all]
+        end
+
+        private
+
+        # Combines the masks of a list of flags.
+        #
+        # @param value [Array<Symbol>] The flags.
+        # @return [Integer] The bits of the flags.
+        def bits(value)
+          bits = 0
+          value.each { |flag| bits |= @masks.fetch(flag) }
+          bits
+        end
+
+        # The frozen set of flags of a vector value, backed by its integer
+        # and queried without allocating. Flags enumerate as their symbols
+        # and are equal to the array of the same symbols, and a predicate is
+        # defined for each flag of the layout, like +cursor_not_found?+.
+        #
+        # @api private
+        class Flags
+          include Enumerable
+
+          # @return [Integer] The bits of the vector.
+          attr_reader :bits
+          # @return [String] The frozen packed bytes of the vector.
+          attr_reader :bytes
+
+          # Defines the flags of a layout with a predicate per flag.
+          #
+          # @param masks [Hash<Symbol, Integer>] The mask of each flag.
+          # @return [Class] The flags class of the layout.
+          def self.define(masks)
+            Class.new(self) do
+              masks.each do |flag, mask|
+                define_method("#{flag}?") { @bits & mask != 0 }
+              end
+            end
+          end
+
+          # Initializes the frozen flags of a vector value.
+          #
+          # @param bits [Integer] The bits of the vector.
+          # @param masks [Hash<Symbol, Integer>] The mask of each flag.
+          def initialize(bits, masks)
+            @bits = bits
+            @masks = masks
+            @bytes = [bits].pack(INT32_PACK).freeze
+            @hash = to_a.hash
+            freeze
+          end
+
+          # Whether a flag is set.
+          #
+          # @param flag [Symbol] The flag.
+          # @return [true, false] If the flag is set.
+          def include?(flag)
+            mask = @masks[flag]
+            !mask.nil? && @bits & mask != 0
+          end
+
+          # Whether no flag is set.
+          #
+          # @return [true, false] If no flag is set.
+          def empty?
+            @bits == 0
+          end
+
+          # Get the flags that are set as an array of their symbols. Arrays
+          # compare to objects that convert to arrays by asking them, which
+          # keeps comparisons with arrays symmetric.
+          #
+          # @return [Array<Symbol>] The flags that are set.
+          def to_a
+            each.to_a
+          end
+          alias_method :to_ary, :to_a
+
+          # Yields each flag that is set, in layout order.
+          #
+          # @yieldparam flag [Symbol] Each flag that is set.
+          def each
+            return to_enum unless block_given?
+            @masks.each { |flag, mask| yield flag if @bits & mask != 0 }
+            self
+          end
+
+          # Compares the flags to other flags or to an array of flags.
+          #
+          # @param other [Flags, Array<Symbol>] The flags to compare to.
+          # @return [true, false] If the same flags are set.
+          def ==(other)
+            return bits == other.bits if other.is_a?(Flags)
+            other.is_a?(Array) && to_a == other
+          end
+          alias_method :eql?, :==
+
+          # @return [Integer] The hash of the array of the flags, as flags
+          #   are equal to that array.
+          def hash
+            @hash
+          end
+
+          # @return [String] The flags as an array.
+          def inspect
+            to_a.inspect
           end
-          flags
         end
       end
     end
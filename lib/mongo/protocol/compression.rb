@@ -0,0 +1,327 @@
+# Copyright (C) 2013 MongoDB, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+require 'zlib'
+
+module Mongo
+  module Protocol
+
+    # Compresses messages into +OP_COMPRESSED+ messages and decompresses
+    # them back, with one of the compressors negotiated with the server.
+    #
+    # Compressors are pluggable: one answers +#compress+ and +#decompress+
+    # and is registered under its name and wire protocol id. One that also
+    # answers +#compress_parts+ compresses a message from its parts without
+    # joining them first. Zlib is always available, and snappy once the
+    # snappy gem can be loaded.
+    #
+    # @example
+    #   compression = Compression.new(Compression.get('zlib'))
+    #   socket.write(compression.compress(insert.serialize))
+    #
+    # @api semiprivate
+    class Compression
+
+      # The op code of a compressed message.
+      OP_CODE = 2012
+
+      # The size in bytes of the message header, and of the fields an
+      # +OP_COMPRESSED+ message adds to it.
+      HEADER_SIZE = 16
+      COMPRESSED_HEADER_SIZE = HEADER_SIZE + 9
+
+      # The size in bytes below which a message is sent uncompressed, as
+      # compressing it would save too little to be worth the time.
+      DEFAULT_MIN_SIZE = 512
+
+      # The packing of the header of a compressed message with the original
+      # op code, uncompressed size and compressor id.
+      COMPRESSED_HEADER_PACK = 'l<l<l<l<l<l<C'.freeze
+
+      # The header packing of a message.
+      HEADER_PACK = 'l<l<l<l<'.freeze
+
+      # Compresses with zlib, at the provided compression level.
+      class Zlib
+
+        # The wire protocol id of zlib.
+        ID = 2
+
+        # Initializes a new zlib compressor.
+        #
+        # @param level [Integer, nil] The zlib compression level, from 0 to
+        #   9, or the zlib default when nil.
+        def initialize(level = nil)
+          @level = level || ::Zlib::DEFAULT_COMPRESSION
+        end
+
+        # @return [Integer] The wire protocol id of the compressor.
+        def id
+          ID
+        end
+
+        # @param data [String] The bytes to compress.
+        #
+        # @return [String] The compressed bytes.
+        def compress(data)
+          ::Zlib::Deflate.deflate(data, @level)
+        end
+
+        # Streams the parts of a message through the deflater, so large
+        # documents spliced into the write are not copied to be joined.
+        #
+        # @param parts [Array<String>] The bytes to compress, in order.
+        #
+        # @return [String] The compressed bytes.
+        def compress_parts(parts)
+          deflate = ::Zlib::Deflate.new(@level)
+          compressed = ''.force_encoding('BINARY')
+          parts.each { |part| compressed << deflate.deflate(part) }
+          compressed << deflate.finish
+        ensure
+          deflate.close if deflate
+        end
+
+        # @param data [String] The compressed bytes.
+        #
+        # @return [String] The decompressed bytes.
+        def decompress(data)
+          ::Zlib::Inflate.inflate(data)
+        end
+      end
+
+      # Compresses with snappy, through the snappy gem.
+      class Snappy
+
+        # The wire protocol id of snappy.
+        ID = 1
+
+        # @return [Integer] The wire protocol id of the compressor.
+        def id
+          ID
+        end
+
+        # @param data [String] The bytes to compress.
+        #
+        # @return [String] The compressed bytes.
+        def compress(data)
+          ::Snappy.deflate(data)
+        end
+
+        # @param data [String] The compressed bytes.
+        #
+        # @return [String] The decompressed bytes.
+        def decompress(data)
+          ::Snappy.inflate(data)
+        end
+      end
+
+      @compressors = {}
+
+      class << self
+
+        # Registers a compressor under its name.
+        #
+        # @example
+        #   Compression.register('zlib') { |opts| Zlib.new(opts[:level]) }
+        #
+        # @param name [String] The name of the compressor, as negotiated.
+        # @yieldparam opts [Hash] The connection options.
+        # @yieldreturn [Object] A new compressor.
+        def register(name, &factory)
+          @compressors[name.to_s] = factory
+        end
+
+        # Get the names of the compressors available, among those provided.
+        #
+        # @param names [Array<String, Symbol>] The compressor names.
+        #
+        # @return [Array<String>] The available names, in the same order.
+        def available(names)
+          names.map(&:to_s).select { |name| @compressors.key?(name) }
+        end
+
+        # Get a new compressor by name.
+        #
+        # @param name [String] The name of the compressor.
+        # @param opts [Hash] The connection options.
+        #
+        # @return [Object, nil] The compressor, if one has that name.
+        def get(name, opts = {})
+          factory = @compressors[name.to_s]
+          factory.call(opts) if factory
+        end
+      end
+
+      register('zlib') { |opts| Zlib.new(opts[:zlib_compression_level]) }
+
+      begin
+        require 'snappy'
+        register('snappy') { Snappy.new }
+      rescue LoadError
+        # Snappy is only offered to servers when the gem is installed.
+      end
+
+      # Initializes a new compression over a compressor.
+      #
+      # @param compressor [Object] The compressor.
+      # @param min_size [Integer] The size in bytes from which messages are
+      #   compressed.
+      #
+      # @return [Compression] The compression instance.
+      def initialize(compressor, min_size = nil)
+        @compressor = compressor
+        @min_size   = min_size || DEFAULT_MIN_SIZE
+      end
+
+      # Compresses each of the messages serialized back to back in the data
+      # that is large enough to be worth it.
+      #
+      # @param data [String] The serialized messages.
+      #
+      # @return [String] The messages, compressed or not.
+      def compress(data)
+        return data if data.bytesize < @min_size
+        compress_segments([data]).join
+      end
+
+      # Compresses each of the messages serialized back to back in the
+      # segments of a write buffer that is large enough to be worth it.
+      # Messages are compressed from their parts, so documents spliced into
+      # the buffer are not copied, and messages sent uncompressed are passed
+      # through as they are.
+      #
+      # @param segments [Array<String>] The segments of the messages.
+      # @param sizes [Array<Integer>, nil] Receives the size in bytes each
+      #   message is written with.
+      #
+      # @return [Array<String>] The segments to write.
+      def compress_segments(segments, sizes = nil)
+        reader = SegmentReader.new(segments)
+        compressed = []
+        until reader.eof?
+          header = reader.read(HEADER_SIZE).join
+          length = header.unpack(HEADER_PACK).first
+          parts = reader.read(length - HEADER_SIZE)
+          if length < @min_size
+            compressed.push(header).concat(parts)
+            sizes.push(length) if sizes
+          else
+            message = compress_message(header, parts)
+            compressed.push(message)
+            sizes.push(message.bytesize) if sizes
+          end
+        end
+        compressed
+      end
+
+      # Decompresses a message if it is compressed.
+      #
+      # @param message [String] The message, header included.
+      #
+      # @return [String] The original message.
+      def decompress(message)
+        return message unless Compression.compressed?(message)
+        _, request_id, response_to, _, op_code, size, id =
+          message.unpack(COMPRESSED_HEADER_PACK)
+        unless id == @compressor.id
+          raise Mongo::SocketError, "Unexpected compressor id #{id}."
+        end
+        body = @compressor.decompress(
+          message.byteslice(COMPRESSED_HEADER_SIZE..-1))
+        header = [size + HEADER_SIZE, request_id, response_to, op_code]
+        header.pack(HEADER_PACK) << body
+      end
+
+      # Whether the message is a compressed one.
+      #
+      # @param message [String] The message, or at least its header.
+      #
+      # @return [true, false] If its op code is that of +OP_COMPRESSED+.
+      def self.compressed?(message)
+        message.byteslice(12, 4).unpack(HEADER_PACK).first == OP_CODE
+      end
+
+      private
+
+      # Compresses a single message.
+      #
+      # @api private
+      #
+      # @param header [String] The header of the message.
+      # @param parts [Array<String>] The parts of the rest of the message.
+      #
+      # @return [String] The compressed message.
+      def compress_message(header, parts)
+        length, request_id, response_to, op_code = header.unpack(HEADER_PACK)
+        body = if @compressor.respond_to?(:compress_parts)
+          @compressor.compress_parts(parts)
+        else
+          @compressor.compress(parts.join)
+        end
+        [COMPRESSED_HEADER_SIZE + body.bytesize, request_id, response_to,
+         OP_CODE, op_code, length - HEADER_SIZE, @compressor.id
+        ].pack(COMPRESSED_HEADER_PACK) << body
+      end
+
+      # Reads the segments of a write buffer in order, by length, as slices
+      # of the segments. A segment read as a whole is returned as it is.
+      #
+      # @api private
+      class SegmentReader
+
+        # @param segments [Array<String>] The segments.
+        def initialize(segments)
+          @segments = segments
+          @index = 0
+          @offset = 0
+        end
+
+        # Whether every segment was read.
+        #
+        # @return [true, false] If nothing is left to read.
+        def eof?
+          @index >= @segments.size
+        end
+
+        # Reads the next bytes of the segments.
+        #
+        # @param length [Integer] The number of bytes to read.
+        #
+        # @return [Array<String>] The bytes read, in parts.
+        def read(length)
+          parts = []
+          while length > 0 && !eof?
+            segment = @segments[@index]
+            size = [segment.bytesize - @offset, length].min
+            whole = @offset == 0 && size == segment.bytesize
+            parts << (whole ? segment : segment.byteslice(@offset, size))
+            length -= size
+            @offset += size
+            next_segment if @offset == segment.bytesize
+          end
+          parts
+        end
+
+        private
+
+        # Moves on to the next segment.
+        def next_segment
+          @index += 1
+          @offset = 0
+        end
+      end
+    end
+  end
+end
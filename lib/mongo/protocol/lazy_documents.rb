@@ -0,0 +1,176 @@
+# Copyright (C) 2013 MongoDB, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+require 'stringio'
+
+module Mongo
+  module Protocol
+
+    # The documents of a reply, kept as the encoded bytes received from the
+    # server together with the offset of each document. A document is only
+    # decoded when it is accessed, and in raw mode never, in which case the
+    # BSON bytes of the document are returned.
+    #
+    # @example
+    #   documents = LazyDocuments.new(bytes, 2)
+    #   documents[1] #=> { 'name' => 'Tyler' }
+    #
+    # @api semipublic
+    class LazyDocuments
+      include Enumerable
+
+      # Creates a new set of lazily decoded documents.
+      #
+      # @param bytes [String] The BSON documents, back to back.
+      # @param count [Integer] The number of documents in the bytes.
+      # @param raw [true, false] Whether to return documents as BSON bytes.
+      def initialize(bytes, count, raw = false)
+        @bytes = bytes
+        @raw = raw
+        @offsets = document_offsets(count)
+        @position = 0
+      end
+
+      # Get the document at the provided index.
+      #
+      # @param index [Integer] The index of the document.
+      #
+      # @return [Hash, String, nil] The decoded document, or its BSON bytes
+      #   in raw mode. Nil if there is no document at the index.
+      def [](index)
+        offset = @offsets[index]
+        return nil unless offset
+        @raw ? raw_document(offset) : decode(offset)
+      end
+
+      # Get the BSON bytes of the document at the provided index.
+      #
+      # @param index [Integer] The index of the document.
+      #
+      # @return [String, nil] The encoded document.
+      def raw(index)
+        offset = @offsets[index]
+        raw_document(offset) if offset
+      end
+
+      # Return the documents as BSON bytes from now on, rather than
+      # decoding them.
+      #
+      # @return [LazyDocuments] self.
+      def raw!
+        @raw = true
+        self
+      end
+
+      # Remove and return the next document that has not been shifted off.
+      #
+      # @return [Hash, String, nil] The next document.
+      def shift
+        document = self[@position]
+        @position += 1 if document
+        document
+      end
+
+      # Iterate over the documents not yet shifted off, decoding each one as
+      # it is yielded.
+      #
+      # @yieldparam doc [Hash, String] Each document.
+      def each
+        @position.upto(@offsets.size - 1) { |index| yield self[index] }
+        self
+      end
+
+      # Get the number of documents not yet shifted off.
+      #
+      # @return [Integer] The number of documents.
+      def size
+        @offsets.size - @position
+      end
+      alias_method :length, :size
+
+      # Whether all documents have been shifted off.
+      #
+      # @return [true, false] If there are no documents left.
+      def empty?
+        size == 0
+      end
+
+      # Get the remaining documents as an array.
+      #
+      # @return [Array<Hash, String>] The documents.
+      def to_a
+        map { |document| document }
+      end
+      alias_method :to_ary, :to_a
+
+      # Compare the documents against another set of documents.
+      #
+      # @param other [Object] The documents to compare.
+      #
+      # @return [true, false] If the documents are equal.
+      def ==(other)
+        other.respond_to?(:to_ary) && to_a == other.to_ary
+      end
+
+      private
+
+      # Walk the length prefix of each document to find where each one
+      # starts.
+      #
+      # @param count [Integer] The number of documents.
+      #
+      # @return [Array<Integer>] The offset of each document.
+      def document_offsets(count)
+        offset = 0
+        Array.new(count) do
+          start = offset
+          offset += length_at(start)
+          start
+        end
+      end
+
+      # Read the little endian 32 bit length of the document at the offset.
+      #
+      # @param offset [Integer] The offset of the document.
+      #
+      # @return [Integer] The length of the document in bytes.
+      def length_at(offset)
+        @bytes.getbyte(offset) |
+          (@bytes.getbyte(offset + 1) << 8) |
+          (@bytes.getbyte(offset + 2) << 16) |
+          (@bytes.getbyte(offset + 3) << 24)
+      end
+
+      # Decode the document at the offset.
+      #
+      # @param offset [Integer] The offset of the document.
+      #
+      # @return [Hash] The decoded document.
+      def decode(offset)
+        @io ||= StringIO.new(@bytes)
+        @io.pos = offset
+        Serializers::Document.deserialize(@io)
+      end
+
+      # Get the encoded bytes of the document at the offset.
+      #
+      # @param offset [Integer] The offset of the document.
+      #
+      # @return [String] The BSON bytes.
+      def raw_document(offset)
+        @bytes.byteslice(offset, length_at(offset))
+      end
+    end
+  end
+end
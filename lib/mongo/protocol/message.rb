@@ -47,8 +47,16 @@ module Mongo
       # @return [Fixnum] The request id for this message
       attr_reader :request_id
 
+      # Returns the request id of the message this message replies to
+      #
+      # @return [Fixnum] The response to id of a deserialized message
+      attr_reader :response_to
+
       # Serializes message into bytes that can be sent on the wire
       #
+      # Documents spliced into a +WriteBuffer+ count towards the length of
+      # the message without being part of the buffer.
+      #
       # @param buffer [String] buffer where the message should be inserted
       # @return [String] buffer containing the serialized message
       def serialize(buffer = ''.force_encoding('BINARY'))
@@ -56,8 +64,10 @@ module Mongo
         serialize_header(buffer)
         serialize_fields(buffer)
         length = buffer.bytesize - start
-        buffer[start, 4] = Int32.serialize('', length)
-        buffer
+        if buffer.respond_to?(:spliced_bytesize)
+          length += buffer.spliced_bytesize(start)
+        end
+        Int32.serialize_at(buffer, start, length)
       end
 
       alias_method :to_s, :serialize
@@ -67,39 +77,22 @@ module Mongo
       # @param io [IO] Stream containing a message
       # @return [Message] Instance of a Message class
       def self.deserialize(io)
-        deserialize_header(io)
+        header = deserialize_header(io)
         message = allocate
-        fields.each do |field|
-          if field[:multi]
-            deserialize_array(message, io, field)
-          else
-            deserialize_field(message, io, field)
-          end
-        end
+        message.send(:set_header, header)
+        message.send(:deserialize_fields, io)
         message
       end
 
-      # Tests for equality between two wire protocol messages
-      # by comparing class and field values.
-      #
-      # @param other [Mongo::Protocol::Message] The wire protocol message.
-      # @return [true, false] The equality of the messages.
-      def ==(other)
-        return false if self.class != other.class
-        fields.all? do |field|
-          name = field[:name]
-          instance_variable_get(name) ==
-            other.instance_variable_get(name)
-        end
-      end
-      alias_method :eql?, :==
+      # The number of request ids a thread reserves at a time, so that the
+      # lock on the id counter is only taken once per block of ids.
+      REQUEST_ID_BLOCK = 1024
 
-      # Creates a hash from the values of the fields of a message.
-      #
-      # @return [ Fixnum ] The hash code for the message.
-      def hash
-        fields.map { |field| instance_variable_get(field[:name]) }.hash
-      end
+      # The largest request id that fits the signed 32 bit header field.
+      MAX_REQUEST_ID = 2**31 - 1
+
+      # The key of the fiber local block of reserved request ids.
+      REQUEST_IDS_KEY = :__mongo_request_ids__
 
       private
 
@@ -113,6 +106,18 @@ module Mongo
         self.class.fields
       end
 
+      # Builds the full namespace of a database and collection. A nil
+      # collection means the database is a full namespace already, like the
+      # frozen namespace a Mongo::Collection keeps, which is used as is so
+      # no string is built per message.
+      #
+      # @param database [String, Symbol] The database, or the full namespace.
+      # @param collection [String, Symbol, nil] The collection.
+      # @return [String] The full namespace.
+      def self.namespace(database, collection)
+        collection.nil? ? database : "#{database}.#{collection}"
+      end
+
       # A class method for getting the fields for a message class
       #
       # @return [Integer] the fields for the message class
@@ -120,31 +125,42 @@ module Mongo
         @fields ||= []
       end
 
-      # Serializes message fields into a buffer
+      # A class method for getting the serialization strategy of each field,
+      # in field order, as referenced by the compiled field methods.
       #
-      # @param buffer [String] buffer to receive the field
-      # @return [String] buffer with serialized field
-      def serialize_fields(buffer)
-        fields.each do |field|
-          value = instance_variable_get(field[:name])
-          if field[:multi]
-            value.each do |item|
-              field[:type].serialize(buffer, item)
-            end
-          else
-            field[:type].serialize(buffer, value)
-          end
-        end
+      # @return [Array] the field types for the message class
+      def self.field_types
+        @field_types ||= []
       end
 
       # Generates a request id for a message
       #
+      # Ids are taken from a block of ids reserved by the current thread,
+      # or fiber, so no lock is needed for most messages. Ids stay unique
+      # across threads, though they are no longer increasing across them.
+      #
       # @return [Fixnum] a request id used for sending a message to the
       #   server. The server will put this id in the response_to field of
       #   a reply.
       def set_request_id
+        ids = Thread.current[REQUEST_IDS_KEY] ||= [0, 0]
+        ids[0], ids[1] = Message.reserve_request_ids if ids[0] == ids[1]
+        @request_id = ids[0]
+        ids[0] += 1
+        @request_id
+      end
+
+      # Reserves the next block of request ids, wrapping around before the
+      # ids outgrow the header field.
+      #
+      # @return [Array<Fixnum>] The first id of the block and the id after
+      #   its last one.
+      def self.reserve_request_ids
         @@id_lock.synchronize do
-          @request_id = @@request_id += 1
+          @@request_id = 0 if @@request_id > MAX_REQUEST_ID - REQUEST_ID_BLOCK
+          first = @@request_id + 1
+          @@request_id += REQUEST_ID_BLOCK
+          [first, @@request_id + 1]
         end
       end
 
@@ -164,12 +180,19 @@ module Mongo
         Header.serialize(buffer, [0, request_id, 0, op_code])
       end
 
+      # Keeps the request id and response to id of a deserialized header
+      #
+      # @param header [Array<Fixnum>] The deserialized header.
+      def set_header(header)
+        @request_id, @response_to = header[1], header[2]
+      end
+
       # Deserializes the header of the message
       #
       # @param io [IO] Stream containing the header.
       # @return [Array<Fixnum>] Deserialized header.
       def self.deserialize_header(io)
-        @length, @request_id, @response_to, @op_code = Header.deserialize(io)
+        Header.deserialize(io)
       end
 
       # A method for declaring a message field
@@ -193,38 +216,89 @@ module Mongo
           :type => type,
           :multi => multi
         }
+        field_types << type
 
         attr_reader name
+        compile_fields
+      end
+
+      # Defines +serialize_fields+, +deserialize_fields+, +==+ and +hash+
+      # for the message class from its declared fields, so that the per
+      # message work is straight line code over instance variables rather
+      # than a walk over the field definitions.
+      #
+      # Called each time a field is declared, which redefines the methods
+      # with the complete set of fields once the class body is read.
+      #
+      # @return [NilClass]
+      def self.compile_fields
+        names = fields.map { |field| field[:name] }
+        class_eval <<-RUBY, __FILE__, __LINE__ + 1
+          def serialize_fields(buffer)
+            types = self.class.field_types
+            #{fields_code { |f, i| serialize_field_code(f, i) }}
+            buffer
+          end
+
+          def deserialize_fields(io)
+            types = self.class.field_types
+            #{fields_code { |f, i| deserialize_field_code(f, i) }}
+            self
+          end
+
+          def ==(other)
+            return false if self.class != other.class
+            #{names.map { |n| "#{n} == other.#{n.to_s[1..-1]}" }.join(' && ')}
+          end
+          alias_method :eql?, :==
+
+          def hash
+            [#{names.join(', ')}].hash
+          end
+        RUBY
+        private :serialize_fields, :deserialize_fields
+        nil
       end
 
-      # Deserializes an array of fields in a message
+      # Generates the code for every field, one statement per line.
       #
-      # The number of items in the array must be described by a previously
-      # deserialized field specified in the class by the field dsl under
-      # the key +:multi+
+      # @return [String] The generated code.
+      def self.fields_code
+        code = []
+        fields.each_with_index { |field, index| code << yield(field, index) }
+        code.join("\n")
+      end
+
+      # Generates the code serializing a single field into +buffer+.
       #
-      # @param message [Message] Message to contain the deserialized array.
-      # @param io [IO] Stream containing the array to deserialize.
       # @param field [Hash] Hash representing a field.
-      # @return [Message] Message with deserialized array.
-      def self.deserialize_array(message, io, field)
-        elements = []
-        count = message.instance_variable_get(field[:multi])
-        count.times { elements << field[:type].deserialize(io) }
-        message.instance_variable_set(field[:name], elements)
+      # @param index [Integer] Position of the field type in +field_types+.
+      # @return [String] The generated code.
+      def self.serialize_field_code(field, index)
+        if field[:multi]
+          "#{field[:name]}.each { |item| types[#{index}]" +
+          '.serialize(buffer, item) }'
+        else
+          "types[#{index}].serialize(buffer, #{field[:name]})"
+        end
       end
 
-      # Deserializes a single field in a message
+      # Generates the code deserializing a single field from +io+.
+      #
+      # The number of items in an array field must be described by a
+      # previously deserialized field specified in the class by the field
+      # dsl under the key +:multi+
       #
-      # @param message [Message] Message to contain the deserialized field.
-      # @param io [IO] Stream containing the field to deserialize.
       # @param field [Hash] Hash representing a field.
-      # @return [Message] Message with deserialized field.
-      def self.deserialize_field(message, io, field)
-        message.instance_variable_set(
-          field[:name],
-          field[:type].deserialize(io)
-        )
+      # @param index [Integer] Position of the field type in +field_types+.
+      # @return [String] The generated code.
+      def self.deserialize_field_code(field, index)
+        if field[:multi].is_a?(Symbol)
+          "#{field[:name]} = Array.new(#{field[:multi]}) " +
+          "{ types[#{index}].deserialize(io) }"
+        else
+          "#{field[:name]} = types[#{index}].deserialize(io)"
+        end
       end
     end
   end
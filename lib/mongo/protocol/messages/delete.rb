@@ -33,7 +33,8 @@ module Mongo
       #   Query.new('xgen', 'users', {:name => 'Tyler'})
       #
       # @param database [String, Symbol] The database to query.
-      # @param collection [String, Symbol] The collection to query.
+      # @param collection [String, Symbol, nil] The collection to query,
+      #   or nil when the database is the full namespace.
       # @param selector [Hash] The query selector.
       # @param options [Hash] The additional query options.
       #
@@ -44,7 +45,7 @@ module Mongo
       #
       #   Supported flags: +:single_remove+
       def initialize(database, collection, selector, options = {})
-        @namespace = "#{database}.#{collection}"
+        @namespace = Message.namespace(database, collection)
         @selector  = selector
         @flags     = options[:flags] || []
       end
@@ -33,11 +33,12 @@ module Mongo
       #   GetMore.new('xgen', 'users', 15, 123)
       #
       # @param database [String, Symbol] The database to query.
-      # @param collection [String, Symbol] The collection to query.
+      # @param collection [String, Symbol, nil] The collection to query,
+      #   or nil when the database is the full namespace.
       # @param number_to_return [Integer] The number of documents to return.
       # @param cursor_id [Integer] The cursor id returned in a reply.
       def initialize(database, collection, number_to_return, cursor_id)
-        @namespace = "#{database}.#{collection}"
+        @namespace = Message.namespace(database, collection)
         @number_to_return = number_to_return
         @cursor_id = cursor_id
       end
@@ -41,7 +41,8 @@ module Mongo
       #   Insert.new('xgen', 'users', users, :flags => [:continue_on_error])
       #
       # @param database [String, Symbol]  The database to insert into.
-      # @param collection [String, Symbol] The collection to insert into.
+      # @param collection [String, Symbol, nil] The collection to insert into,
+      #   or nil when the database is the full namespace.
       # @param documents [Array<Hash>] The documents to insert.
       # @param options [Hash] Additional options for the insertion.
       #
@@ -49,13 +50,95 @@ module Mongo
       #
       #   Supported flags: +:continue_on_error+
       def initialize(database, collection, documents, options = {})
-        @namespace = "#{database}.#{collection}"
+        @namespace = Message.namespace(database, collection)
         @documents = documents
         @flags = options[:flags] || []
       end
 
+      # Splits documents into Insert messages that each fit within the
+      # maximum message size. Every document is BSON encoded once, as it is
+      # reached, so only the documents of one message are held at a time and
+      # the documents can come from any enumerable, including a lazy stream.
+      #
+      # @example Insert a stream of documents in size bounded batches.
+      #   Insert.batches('xgen', 'users', users, limits) do |insert|
+      #     connection.send_message(insert)
+      #   end
+      #
+      # @param database [String, Symbol] The database to insert into.
+      # @param collection [String, Symbol, nil] The collection to insert into,
+      #   or nil when the database is the full namespace.
+      # @param documents [Enumerable<Hash, String>] The documents to insert,
+      #   as hashes or BSON bytes.
+      # @param options [Hash] The limits and options for each insertion.
+      #
+      # @option options :max_bson_object_size [Integer] The maximum size in
+      #   bytes of a document.
+      # @option options :max_message_size [Integer] The maximum size in bytes
+      #   of a message.
+      # @option options :flags [Array] The flags for each insertion message.
+      #
+      # @raise [DocumentTooLarge] If a document exceeds the maximum size.
+      #
+      # @yieldparam insert [Insert] Each Insert message.
+      def self.batches(database, collection, documents, options = {})
+        room = options[:max_message_size] - OVERHEAD -
+          Message.namespace(database, collection).bytesize
+        batch, size = [], 0
+        documents.each do |document|
+          bson = encode(document, options[:max_bson_object_size])
+          if size + bson.bytesize > room && !batch.empty?
+            yield new(database, collection, batch, options)
+            batch, size = [], 0
+          end
+          batch << bson
+          size += bson.bytesize
+        end
+        yield new(database, collection, batch, options) unless batch.empty?
+      end
+
+      # BSON encodes a document unless it is already encoded, checking its
+      # size against the maximum size of a document.
+      #
+      # @param document [Hash, String] The document or its BSON bytes.
+      # @param max_size [Integer] The maximum size in bytes of a document.
+      #
+      # @raise [DocumentTooLarge] If the document exceeds the maximum size.
+      #
+      # @return [String] The BSON bytes of the document.
+      def self.encode(document, max_size)
+        buffer = ''.force_encoding('BINARY')
+        bson = document.is_a?(String) ? document : document.to_bson(buffer)
+        if bson.bytesize > max_size
+          raise DocumentTooLarge.new(bson.bytesize, max_size)
+        end
+        bson
+      end
+      private_class_method :encode
+
+      # Exception that is raised when a document is larger than the maximum
+      # size of a document accepted by the server.
+      class DocumentTooLarge < DriverError
+
+        # Instantiate the new exception.
+        #
+        # @example
+        #   DocumentTooLarge.new(16777217, 16777216)
+        #
+        # @param size [Integer] The size in bytes of the document.
+        # @param max_size [Integer] The maximum size in bytes of a document.
+        def initialize(size, max_size)
+          super("Document of #{size} bytes exceeds the maximum document " +
+                "size of #{max_size} bytes.")
+        end
+      end
+
       private
 
+      # The size of the header, flags and namespace terminator of an Insert
+      # message.
+      OVERHEAD = 21
+
       # The operation code required to specify an Insert message.
       # @return [Fixnum] the operation code.
       def op_code
@@ -46,7 +46,8 @@ module Mongo
       #   Query.new('xgen', 'users', {}, :fields => {:id => 1})
       #
       # @param database [String, Symbol] The database to query.
-      # @param collection [String, Symbol] The collection to query.
+      # @param collection [String, Symbol, nil] The collection to query,
+      #   or nil when the database is the full namespace.
       # @param selector [Hash] The query selector.
       # @param options [Hash] The additional query options.
       #
@@ -58,7 +59,7 @@ module Mongo
       #   Supported flags: +:tailable_cursor+, +:slave_ok+, +:oplog_replay+,
       #   +:no_cursor_timeout+, +:await_data+, +:exhaust+, +:partial+
       def initialize(database, collection, selector, options = {})
-        @namespace   = "#{database}.#{collection}"
+        @namespace   = Message.namespace(database, collection)
         @selector    = selector
         @project     = options[:project]
         @skip        = options[:skip]  || 0
@@ -26,8 +26,74 @@ module Mongo
     # @api semipublic
     class Reply < Message
 
+      # Deserializes a reply from an IO stream.
+      #
+      # @example Decode documents only when they are accessed.
+      #   Reply.deserialize(io, :lazy => true)
+      #
+      # @param io [IO] Stream containing a reply.
+      # @param options [Hash] The deserialization options.
+      #
+      # @option options :lazy [true, false] Keep the documents encoded as
+      #   +LazyDocuments+ until they are accessed.
+      # @option options :raw [true, false] Keep the documents encoded and
+      #   return their BSON bytes on access. Implies +:lazy+.
+      #
+      # @return [Reply] The reply.
+      def self.deserialize(io, options = {})
+        return super(io) unless options[:lazy] || options[:raw]
+        header = deserialize_header(io)
+        deserialize_body(header, io.read || ''.force_encoding('BINARY'),
+                         options)
+      end
+
+      # Deserializes a reply from its decoded header and the bytes that
+      # follow the header, as read off a connection. Lazily decoded
+      # documents are kept in the body itself rather than a copy of it.
+      #
+      # @example Decode a reply read off a socket.
+      #   Reply.deserialize_body(header, body, :lazy => true)
+      #
+      # @param header [Array<Integer>] The decoded message header.
+      # @param body [String] The bytes of the message after the header.
+      # @param options [Hash] The deserialization options, as for
+      #   +deserialize+.
+      #
+      # @return [Reply] The reply.
+      def self.deserialize_body(header, body, options = {})
+        reply = allocate
+        reply.send(:set_header, header)
+        if options[:lazy] || options[:raw]
+          reply.send(:deserialize_lazy, body, options[:raw])
+        else
+          reply.send(:deserialize_fields, StringIO.new(body))
+        end
+        reply
+      end
+
       private
 
+      # The size in bytes of the fixed fields that precede the documents.
+      FIXED_SIZE = 20
+
+      # Deserializes the fixed fields of the reply and keeps the rest of
+      # the body as the encoded documents. Slicing the tail of the body
+      # shares its bytes rather than copying them.
+      #
+      # @param body [String] The bytes of the message after the header.
+      # @param raw [true, false] Whether to return documents as BSON bytes.
+      # @return [Reply] The reply.
+      def deserialize_lazy(body, raw)
+        io               = StringIO.new(body)
+        @flags           = FLAG_VECTOR.deserialize(io)
+        @cursor_id       = Int64.deserialize(io)
+        @starting_from   = Int32.deserialize(io)
+        @number_returned = Int32.deserialize(io)
+        bytes = body.byteslice(FIXED_SIZE..-1) || ''.force_encoding('BINARY')
+        @documents       = LazyDocuments.new(bytes, @number_returned, raw)
+        self
+      end
+
       # Available flags for a Reply message.
       FLAGS = [
         :cursor_not_found,
@@ -36,6 +102,9 @@ module Mongo
         :await_capable
       ]
 
+      # The serialization strategy for the reply flags.
+      FLAG_VECTOR = BitVector.new(FLAGS)
+
       public
 
       # @!attribute
@@ -43,7 +112,7 @@ module Mongo
       #
       #   Supported flags: +:cursor_not_found+, +:query_failure+,
       #   +:shard_config_stale+, +:await_capable+
-      field :flags, BitVector.new(FLAGS)
+      field :flags, FLAG_VECTOR
 
       # @!attribute
       # @return [Fixnum] The cursor id for this response. Will be zero
@@ -43,7 +43,8 @@ module Mongo
       #   Update.new('xgen', 'users', {:name => 'Tyler'}, :flags => [:upsert])
       #
       # @param database [String, Symbol]  The database to update.
-      # @param collection [String, Symbol] The collection to update.
+      # @param collection [String, Symbol, nil] The collection to update,
+      #   or nil when the database is the full namespace.
       # @param selector [Hash] The update selector.
       # @param update [Hash] The update to perform.
       # @param options [Hash] The additional query options.
@@ -52,7 +53,7 @@ module Mongo
       #
       #   Supported flags: +:upsert+, +:multi+
       def initialize(database, collection, selector, update, options = {})
-        @namespace   = "#{database}.#{collection}"
+        @namespace   = Message.namespace(database, collection)
         @selector    = selector
         @update      = update
         @flags       = options[:flags] || []
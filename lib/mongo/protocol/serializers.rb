@@ -108,6 +108,21 @@ module Mongo
           buffer << [value].pack(INT32_PACK)
         end
 
+        # Overwrites the 4 bytes at +offset+ in the buffer with a 32-bit
+        # integer, without allocating an intermediate string.
+        #
+        # @param buffer [String] Buffer holding the bytes to overwrite.
+        # @param offset [Fixnum] Byte offset of the integer in the buffer.
+        # @param value [Fixnum] 32-bit integer to be serialized.
+        # @return [String] Buffer with serialized value.
+        def self.serialize_at(buffer, offset, value)
+          buffer.setbyte(offset, value & 0xFF)
+          buffer.setbyte(offset + 1, (value >> 8) & 0xFF)
+          buffer.setbyte(offset + 2, (value >> 16) & 0xFF)
+          buffer.setbyte(offset + 3, (value >> 24) & 0xFF)
+          buffer
+        end
+
         # Deserializes a 32-bit Fixnum from the IO stream
         #
         # @param io [IO] IO stream containing the 32-bit integer
@@ -145,13 +160,17 @@ module Mongo
       # Serializes and de-serializes a single document.
       module Document
 
-        # Serializes a document into the buffer
+        # Serializes a document into the buffer. A document that is already
+        # BSON encoded is appended as is, or spliced in when the buffer is a
+        # +WriteBuffer+.
         #
         # @param buffer [String] Buffer to receive the BSON encoded document.
-        # @param value [Hash] Document to serialize as BSON.
+        # @param value [Hash, String] Document to serialize as BSON, or its
+        #   BSON bytes.
         # @return [String] Buffer with serialized value.
         def self.serialize(buffer, value)
-          value.to_bson(buffer)
+          return value.to_bson(buffer) unless value.is_a?(String)
+          buffer.respond_to?(:splice) ? buffer.splice(value) : buffer << value
         end
 
         # Deserializes a document from the IO stream
@@ -0,0 +1,102 @@
+# Copyright (C) 2013 MongoDB, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+module Mongo
+  module Protocol
+
+    # A buffer that messages are serialized into before being written to a
+    # socket. Large documents that are already BSON encoded are not copied
+    # into the buffer but spliced in at their position, so the buffer can be
+    # written as a list of segments with a single vectored write.
+    #
+    # The buffer itself only holds the bytes that were copied in, so the
+    # serializers can keep treating it as a string.
+    #
+    # @example
+    #   buffer = WriteBuffer.new
+    #   insert.serialize(buffer)
+    #   socket.write(*buffer.segments)
+    #
+    # @api semiprivate
+    class WriteBuffer < String
+
+      # The size in bytes from which an encoded document is spliced in
+      # rather than copied into the buffer.
+      MIN_SPLICE_SIZE = 4096
+
+      # Creates a new empty binary write buffer.
+      #
+      # @return [WriteBuffer] The buffer.
+      def initialize
+        super('')
+        force_encoding('BINARY')
+        @splices = []
+      end
+
+      # Adds encoded bytes at the current end of the buffer. Bytes smaller
+      # than +MIN_SPLICE_SIZE+ are cheaper to copy and are appended.
+      #
+      # @param bytes [String] The encoded bytes.
+      #
+      # @return [WriteBuffer] self.
+      def splice(bytes)
+        return self << bytes if bytes.bytesize < MIN_SPLICE_SIZE
+        @splices << [bytesize, bytes]
+        self
+      end
+
+      # Get the number of spliced bytes after an offset of the buffer. Bytes
+      # spliced right at the offset are not counted: at the start of a
+      # message they end the message before it.
+      #
+      # @param offset [Integer] The offset in the buffer, or -1 to count
+      #   every splice.
+      #
+      # @return [Integer] The number of bytes spliced after it.
+      def spliced_bytesize(offset = -1)
+        @splices.reduce(0) do |size, (at, bytes)|
+          at > offset ? size + bytes.bytesize : size
+        end
+      end
+
+      # Get the segments to write, in order. Without splices the buffer is
+      # the only segment.
+      #
+      # @return [Array<String>] The segments of the buffer.
+      def segments
+        return [self] if @splices.empty?
+        offset = 0
+        segments = @splices.reduce([]) do |parts, (at, bytes)|
+          parts << byteslice(offset, at - offset) if at > offset
+          offset = at
+          parts << bytes
+        end
+        segments << byteslice(offset, bytesize - offset) if bytesize > offset
+        segments
+      end
+
+      # Empties the buffer while keeping its allocated capacity. String#clear
+      # releases the memory, so the buffer is truncated to a single byte,
+      # which keeps the allocation, and that byte is then chopped off.
+      #
+      # @return [WriteBuffer] self.
+      def reset
+        self[1, bytesize] = '' if bytesize > 1
+        chop!
+        @splices.clear
+        self
+      end
+    end
+  end
+end
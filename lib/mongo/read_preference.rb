@@ -0,0 +1,246 @@
+# Copyright (C) 2013 MongoDB, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+module Mongo
+
+  # Defines which nodes of a replica set an operation may read from, and
+  # selects one of them.
+  #
+  # Of the eligible nodes, only those whose round trip time is within the
+  # local threshold of the fastest one are considered, and one of those is
+  # picked at random to spread the load between them.
+  #
+  # @since 2.0.0
+  class ReadPreference
+
+    # The default time in milliseconds a node may be slower than the
+    # fastest eligible node and still be selected.
+    #
+    # @since 2.0.0
+    DEFAULT_LOCAL_THRESHOLD = 15
+
+    # The read preference modes, with their names on the server.
+    #
+    # @since 2.0.0
+    MODES = {
+      :primary => 'primary',
+      :primary_preferred => 'primaryPreferred',
+      :secondary => 'secondary',
+      :secondary_preferred => 'secondaryPreferred',
+      :nearest => 'nearest'
+    }.freeze
+
+    # @return [ Symbol ] The read preference mode.
+    attr_reader :mode
+    # @return [ Array<Hash> ] The tag sets, in order of preference.
+    attr_reader :tags
+
+    # Instantiate a new read preference.
+    #
+    # @example Instantiate a read preference.
+    #   Mongo::ReadPreference.new(:secondary, [{ 'dc' => 'ny' }])
+    #
+    # @param [ Symbol ] mode The read preference mode.
+    # @param [ Array<Hash> ] tags The tag sets, in order of preference.
+    #
+    # @raise [ ArgumentError ] If the mode is not a read preference mode.
+    #
+    # @since 2.0.0
+    def initialize(mode = :primary, tags = [])
+      unless MODES.key?(mode)
+        raise ArgumentError, "Unknown read preference mode #{mode.inspect}."
+      end
+      @mode = mode
+      @tags = tags
+    end
+
+    # Determine if this read preference is equal to another object.
+    #
+    # @example Check read preference equality.
+    #   read_preference == other
+    #
+    # @param [ Object ] other The object to compare to.
+    #
+    # @return [ true, false ] If the objects are equal.
+    #
+    # @since 2.0.0
+    def ==(other)
+      return false unless other.is_a?(ReadPreference)
+      mode == other.mode && tags == other.tags
+    end
+    alias_method :eql?, :==
+
+    # Get the hash value of the read preference.
+    #
+    # @return [ Integer ] The hash value.
+    #
+    # @since 2.0.0
+    def hash
+      [mode, tags].hash
+    end
+
+    MODES.each_key do |name|
+      define_method("#{name}?") { mode == name }
+    end
+
+    # Whether any tag sets were provided.
+    #
+    # @return [ true, false ] If there are tag sets.
+    #
+    # @since 2.0.0
+    def tags_set?
+      !tags.empty?
+    end
+
+    # Get the read preference to send to a mongos along with a query. A
+    # primary read preference is the default and is not sent.
+    #
+    # @example Get the read preference for a mongos.
+    #   read_preference.mongos
+    #
+    # @return [ Hash, nil ] The $readPreference document.
+    #
+    # @since 2.0.0
+    def mongos
+      return nil if primary?
+      document = { :mode => MODES[mode] }
+      document[:tags] = tags if tags_set?
+      document
+    end
+
+    # Select a node to read from.
+    #
+    # A standalone or mongos node is not a replica set member and serves
+    # every read preference.
+    #
+    # @example Select a node.
+    #   read_preference.select_node(cluster.nodes, 15)
+    #
+    # @param [ Array<Mongo::Node, Mongo::Cluster::Topology::Member> ] nodes
+    #   The operable nodes, or their snapshots in a topology.
+    # @param [ Numeric ] local_threshold The latency window in milliseconds.
+    #
+    # @return [ Mongo::Node, nil ] The selected node, if any is eligible.
+    #
+    # @since 2.0.0
+    def select_node(nodes, local_threshold = DEFAULT_LOCAL_THRESHOLD)
+      select_nodes(nodes, local_threshold).sample
+    end
+
+    # Select every node that may be read from, to spread many reads over.
+    #
+    # @example Select the nodes.
+    #   read_preference.select_nodes(cluster.nodes, 15)
+    #
+    # @param [ Array<Mongo::Node, Mongo::Cluster::Topology::Member> ] nodes
+    #   The operable nodes, or their snapshots in a topology.
+    # @param [ Numeric ] local_threshold The latency window in milliseconds.
+    #
+    # @return [ Array<Mongo::Node> ] The eligible nodes within the latency
+    #   window.
+    #
+    # @since 2.0.0
+    def select_nodes(nodes, local_threshold = DEFAULT_LOCAL_THRESHOLD)
+      members, others = nodes.partition(&:replica_set_name)
+      eligible = others.select(&:primary?)
+      eligible = candidates(members) if eligible.empty?
+      nearest(eligible, local_threshold / 1000.0)
+    end
+
+    class << self
+
+      # Get a read preference for the provided read option.
+      #
+      # @example Get a read preference.
+      #   Mongo::ReadPreference.get(:mode => :secondary, :tags => [])
+      #
+      # @param [ Mongo::ReadPreference, Hash, Symbol, nil ] read The read
+      #   preference, a hash of its +:mode+ and +:tags+, like the URI read
+      #   options, or a mode. Nil gets a primary read preference.
+      #
+      # @return [ Mongo::ReadPreference ] The read preference.
+      #
+      # @since 2.0.0
+      def get(read)
+        case read
+        when nil then new
+        when Symbol, String then new(read.to_sym)
+        when Hash then new((read[:mode] || :primary).to_sym, read[:tags] || [])
+        else read
+        end
+      end
+    end
+
+    private
+
+    # Get the replica set members the mode allows reading from.
+    #
+    # @api private
+    #
+    # @param [ Array<Mongo::Node> ] members The replica set members.
+    #
+    # @return [ Array<Mongo::Node> ] The eligible members.
+    #
+    # @since 2.0.0
+    def candidates(members)
+      primary = members.select(&:primary?)
+      secondaries = matching(members.select(&:secondary?))
+      case mode
+      when :primary then primary
+      when :primary_preferred then primary.empty? ? secondaries : primary
+      when :secondary then secondaries
+      when :secondary_preferred then secondaries.empty? ? primary : secondaries
+      when :nearest then matching(primary + members.select(&:secondary?))
+      end
+    end
+
+    # Get the nodes matching the first tag set that any node matches.
+    #
+    # @api private
+    #
+    # @param [ Array<Mongo::Node> ] nodes The nodes to match.
+    #
+    # @return [ Array<Mongo::Node> ] The matching nodes.
+    #
+    # @since 2.0.0
+    def matching(nodes)
+      return nodes unless tags_set?
+      tags.each do |set|
+        matched = nodes.select do |node|
+          set.all? { |key, value| node.tags[key.to_s] == value.to_s }
+        end
+        return matched unless matched.empty?
+      end
+      []
+    end
+
+    # Get the nodes within the latency window of the fastest one. Nodes
+    # whose round trip time is not known yet are only kept when no round
+    # trip time is known.
+    #
+    # @api private
+    #
+    # @param [ Array<Mongo::Node> ] nodes The eligible nodes.
+    # @param [ Float ] window The latency window in seconds.
+    #
+    # @return [ Array<Mongo::Node> ] The nearest nodes.
+    #
+    # @since 2.0.0
+    def nearest(nodes, window)
+      times = nodes.map { |node| node.round_trip_time || Float::INFINITY }
+      limit = (times.min || 0) + window
+      nodes.select.with_index { |_, index| times[index] <= limit }
+    end
+  end
+end
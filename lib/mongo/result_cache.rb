@@ -0,0 +1,174 @@
+# Copyright (C) 2013 MongoDB, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+module Mongo
+
+  # A least recently used cache of query results, bounded by the size of
+  # the documents it holds. Results are kept as the BSON bytes of their
+  # documents, which take far less memory than decoded documents.
+  #
+  # Results are only cached for scopes that ask for it, for as long as
+  # they ask. Any write through a collection of the client invalidates the
+  # results cached for its namespace.
+  #
+  # @example Cache the results of a read-mostly query for 5 seconds.
+  #   client = Mongo::Client.new([ '127.0.0.1:27017' ],
+  #                              :result_cache_size => 16 * 1024 * 1024)
+  #   Mongo::Scope.new(client[:flags], :app => 'web').cache(5).each do |doc|
+  #     enable(doc)
+  #   end
+  #
+  # @since 2.0.0
+  class ResultCache
+
+    # A cached result, with the copy of the scope it is cached under.
+    #
+    # @since 2.0.0
+    Entry = Struct.new(:scope, :documents, :bytes, :generation, :expires_at)
+
+    # @return [ Integer ] The maximum size in bytes of the cached documents.
+    attr_reader :max_size
+    # @return [ Integer ] The size in bytes of the cached documents.
+    attr_reader :size
+
+    # Instantiate a new result cache.
+    #
+    # @example Instantiate a cache of at most 16MB.
+    #   Mongo::ResultCache.new(16 * 1024 * 1024)
+    #
+    # @param [ Integer ] max_size The maximum size in bytes of the cached
+    #   documents.
+    #
+    # @since 2.0.0
+    def initialize(max_size)
+      @max_size = max_size
+      @size = 0
+      @entries = {}
+      @generations = Hash.new(0)
+      @mutex = Mutex.new
+    end
+
+    # Get the cached documents of a scope, or else get them from the block
+    # and cache them for the time to live. Results larger than the cache
+    # are not cached, nor are results read while a write invalidated the
+    # namespace.
+    #
+    # @example Fetch the documents of a scope.
+    #   cache.fetch(scope, 5) { query(scope) }
+    #
+    # @param [ Mongo::Scope ] scope The scope.
+    # @param [ Numeric ] ttl The time in seconds to keep the documents.
+    #
+    # @yieldreturn [ Array<String> ] The BSON bytes of the documents.
+    #
+    # @return [ Array<String> ] The frozen BSON bytes of the documents.
+    #
+    # @since 2.0.0
+    def fetch(scope, ttl)
+      namespace = scope.collection.full_namespace
+      now = Pool::Socket::Base.monotonic_time
+      generation = @mutex.synchronize do
+        entry = take(scope)
+        if entry && entry.generation == @generations[namespace] &&
+            entry.expires_at > now
+          @entries[entry.scope] = entry
+          @size += entry.bytes
+          return entry.documents
+        end
+        @generations[namespace]
+      end
+      documents = yield.each(&:freeze).freeze
+      store(Entry.new(scope.dup, documents, bytesize(documents), generation,
+                      now + ttl))
+      documents
+    end
+
+    # Invalidate the results cached for a namespace, such as after a write
+    # to its collection.
+    #
+    # @example Invalidate the results of a collection.
+    #   cache.invalidate(collection.full_namespace)
+    #
+    # @param [ String ] namespace The namespace of the collection.
+    #
+    # @since 2.0.0
+    def invalidate(namespace)
+      @mutex.synchronize { @generations[namespace] += 1 }
+    end
+
+    # Drop every cached result.
+    #
+    # @example Clear the cache.
+    #   cache.clear
+    #
+    # @since 2.0.0
+    def clear
+      @mutex.synchronize do
+        @entries.clear
+        @size = 0
+      end
+    end
+
+    private
+
+    # Cache an entry unless its namespace was invalidated since its
+    # documents were read, evicting the least recently used entries until
+    # it fits.
+    #
+    # @api private
+    #
+    # @param [ Entry ] entry The entry.
+    #
+    # @since 2.0.0
+    def store(entry)
+      return if entry.bytes > max_size
+      namespace = entry.scope.collection.full_namespace
+      @mutex.synchronize do
+        return unless entry.generation == @generations[namespace]
+        take(entry.scope)
+        take(@entries.first[0]) while @size + entry.bytes > max_size
+        @entries[entry.scope] = entry
+        @size += entry.bytes
+      end
+    end
+
+    # Remove the entry of a scope. Must be called while holding the lock.
+    #
+    # @api private
+    #
+    # @param [ Mongo::Scope ] scope The scope.
+    #
+    # @return [ Entry, nil ] The removed entry.
+    #
+    # @since 2.0.0
+    def take(scope)
+      entry = @entries.delete(scope)
+      @size -= entry.bytes if entry
+      entry
+    end
+
+    # Get the total size of documents.
+    #
+    # @api private
+    #
+    # @param [ Array<String> ] documents The BSON bytes of the documents.
+    #
+    # @return [ Integer ] The size in bytes.
+    #
+    # @since 2.0.0
+    def bytesize(documents)
+      documents.reduce(0) { |sum, document| sum + document.bytesize }
+    end
+  end
+end
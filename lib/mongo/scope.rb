@@ -12,6 +12,9 @@
 # See the License for the specific language governing permissions and
 # limitations under the License.
 
+require 'stringio'
+require 'mongo/scope/parallel_scan'
+
 module Mongo
 
   # Representation of a query and options producing a result set of documents.
@@ -54,9 +57,15 @@ module Mongo
     # @param selector [Hash] The query selector.
     # @param opts [Hash] The additional query options.
     #
+    # @option opts :await_data [true, false] Let a tailable cursor wait on
+    #   the server for new data.
     # @option opts :comment [String] Associate a comment with the query.
     # @option opts :batch_size [Integer] The number of docs to return in
     #   each response from MongoDB.
+    # @option opts :cache [Numeric] The time in seconds to serve the docs
+    #   from the result cache of the client, if it has one.
+    # @option opts :exhaust [true, false] Stream every batch back from the
+    #   server without sending +GetMore+ messages.
     # @option opts :fields [Hash] The fields to include or exclude in
     #   returned docs.
     # @option opts :hint [Hash] Override default index selection and force
@@ -64,6 +73,12 @@ module Mongo
     # @option opts :limit [Integer] Max number of docs to return.
     # @option opts :max_scan [Integer] Constrain the query to only scan the
     #   specified number of docs. Use to prevent queries from running too long.
+    # @option opts :oplog_replay [true, false] Let the server skip ahead to
+    #   the +ts+ given in the selector of an oplog query.
+    # @option opts :prefetch [Integer] The number of batches to request
+    #   ahead of the docs being iterated.
+    # @option opts :raw [true, false] Return each doc as its BSON bytes
+    #   instead of decoding it.
     # @option opts :read [Symbol] The read preference to use for the query.
     #   If none is provided, the collection's default read preference is used.
     # @option opts :show_disk_loc [true, false] Return disk location info as
@@ -73,6 +88,11 @@ module Mongo
     #   once.
     # @option opts :sort [Hash] The key and direction pairs used to sort the
     #   results.
+    # @option opts :tailable [true, false] Keep the cursor open on a capped
+    #   collection to wait for new docs.
+    # @option opts :tail_retries [Integer] The number of times in a row a
+    #   tailable cursor is resumed after its connection failed before the
+    #   error is raised.
     def initialize(collection, selector = {}, opts = {})
       @collection = collection
       @selector = selector.dup
@@ -154,6 +174,49 @@ module Mongo
       mutate(:batch_size, batch_size)
     end
 
+    # Whether a +GetMore+ on a tailable cursor waits on the server for a
+    # while for new data rather than returning an empty batch at once.
+    #
+    # @param await_data [true, false] Whether to wait for data.
+    #
+    # @return [true, false, nil, Scope] Either the await data setting or a
+    #   new +Scope+.
+    def await_data(await_data = nil)
+      set_option(:await_data, await_data)
+    end
+
+    # Modify this +Scope+ to define whether a +GetMore+ on a tailable cursor
+    # waits on the server for new data.
+    #
+    # @param await_data [true, false] Whether to wait for data.
+    #
+    # @return [Scope] self.
+    def await_data!(await_data = nil)
+      mutate(:await_data, await_data)
+    end
+
+    # Whether the server streams every batch of results back on the same
+    # connection, without waiting for a +GetMore+ message for each batch.
+    # The connection stays checked out until the last batch has been read.
+    #
+    # @param exhaust [true, false] Whether to use an exhaust cursor.
+    #
+    # @return [true, false, nil, Scope] Either the exhaust setting or a new
+    #   +Scope+.
+    def exhaust(exhaust = nil)
+      set_option(:exhaust, exhaust)
+    end
+
+    # Modify this +Scope+ to define whether the server streams every batch
+    # of results back without +GetMore+ messages.
+    #
+    # @param exhaust [true, false] Whether to use an exhaust cursor.
+    #
+    # @return [Scope] self.
+    def exhaust!(exhaust = nil)
+      mutate(:exhaust, exhaust)
+    end
+
     # The fields to include or exclude from each doc in the result set.
     # A value of 0 excludes a field from the doc. A value of 1 includes it.
     # Values must all be 0 or all be 1, with the exception of the _id value.
@@ -214,6 +277,95 @@ module Mongo
       mutate(:limit, limit)
     end
 
+    # Whether the server may skip ahead to the +ts+ given in the selector
+    # when querying the oplog. A resumed tailable cursor then continues
+    # from the +ts+ of the last doc seen rather than its +_id+.
+    #
+    # @param oplog_replay [true, false] Whether to replay the oplog.
+    #
+    # @return [true, false, nil, Scope] Either the oplog replay setting or a
+    #   new +Scope+.
+    def oplog_replay(oplog_replay = nil)
+      set_option(:oplog_replay, oplog_replay)
+    end
+
+    # Modify this +Scope+ to define whether the server may skip ahead to the
+    # +ts+ given in the selector when querying the oplog.
+    #
+    # @param oplog_replay [true, false] Whether to replay the oplog.
+    #
+    # @return [Scope] self.
+    def oplog_replay!(oplog_replay = nil)
+      mutate(:oplog_replay, oplog_replay)
+    end
+
+    # The number of batches to request from MongoDB ahead of the docs
+    # being iterated. The next batch is requested on the same connection
+    # once half of the current batch has been iterated, so it is already
+    # buffered when needed. Queries with a limit are not prefetched.
+    #
+    # @param prefetch [Integer] The number of batches to request ahead.
+    #
+    # @return [Integer, Scope] Either the prefetch value or a new +Scope+.
+    def prefetch(prefetch = nil)
+      set_option(:prefetch, prefetch)
+    end
+
+    # Modify this +Scope+ to define the number of batches to request from
+    # MongoDB ahead of the docs being iterated.
+    #
+    # @param prefetch [Integer] The number of batches to request ahead.
+    #
+    # @return [Scope] self.
+    def prefetch!(prefetch = nil)
+      mutate(:prefetch, prefetch)
+    end
+
+    # Whether docs are returned as BSON encoded strings rather than decoded
+    # into hashes. Useful when the docs are passed on without being read.
+    #
+    # @param raw [true, false] Whether to return raw BSON docs.
+    #
+    # @return [true, false, nil, Scope] Either the raw setting or a new
+    #   +Scope+.
+    def raw(raw = nil)
+      set_option(:raw, raw)
+    end
+
+    # Modify this +Scope+ to define whether docs are returned as BSON
+    # encoded strings.
+    #
+    # @param raw [true, false] Whether to return raw BSON docs.
+    #
+    # @return [Scope] self.
+    def raw!(raw = nil)
+      mutate(:raw, raw)
+    end
+
+    # The time in seconds the docs may be served from the result cache of
+    # the client rather than queried again. Writes through the collection
+    # drop the cached docs before they expire. Only worth it for small,
+    # read-mostly result sets, as every doc is read before the first one
+    # is returned.
+    #
+    # @param ttl [Numeric] The time to cache the docs for.
+    #
+    # @return [Numeric, nil, Scope] Either the cache setting or a new
+    #   +Scope+.
+    def cache(ttl = nil)
+      set_option(:cache, ttl)
+    end
+
+    # Modify this +Scope+ to serve its docs from the result cache of the
+    # client.
+    #
+    # @param ttl [Numeric] The time to cache the docs for.
+    #
+    # @return [Scope] self.
+    def cache!(ttl = nil)
+      mutate(:cache, ttl)
+    end
+
     # The read preference to use for the query.
     # If none is specified for the query, the read preference of the
     # collection will be used.
@@ -273,6 +425,51 @@ module Mongo
       mutate(:sort, sort)
     end
 
+    # Whether the cursor stays open on a capped collection once the last
+    # doc has been returned, waiting for docs inserted afterwards. The
+    # cursor is queried again from the last doc seen if it dies on the
+    # server or its connection fails.
+    #
+    # @param tailable [true, false] Whether to use a tailable cursor.
+    #
+    # @return [true, false, nil, Scope] Either the tailable setting or a new
+    #   +Scope+.
+    def tailable(tailable = nil)
+      set_option(:tailable, tailable)
+    end
+
+    # Modify this +Scope+ to define whether the cursor stays open on a
+    # capped collection once the last doc has been returned.
+    #
+    # @param tailable [true, false] Whether to use a tailable cursor.
+    #
+    # @return [Scope] self.
+    def tailable!(tailable = nil)
+      mutate(:tailable, tailable)
+    end
+
+    # The number of times in a row a tailable cursor is resumed after its
+    # connection failed before the error is raised. Defaults to
+    # +Cursor::DEFAULT_TAIL_RETRIES+.
+    #
+    # @param tail_retries [Integer] The number of retries.
+    #
+    # @return [Integer, nil, Scope] Either the retries setting or a new
+    #   +Scope+.
+    def tail_retries(tail_retries = nil)
+      set_option(:tail_retries, tail_retries)
+    end
+
+    # Modify this +Scope+ to define the number of times in a row a tailable
+    # cursor is resumed after its connection failed.
+    #
+    # @param tail_retries [Integer] The number of retries.
+    #
+    # @return [Scope] self.
+    def tail_retries!(tail_retries = nil)
+      mutate(:tail_retries, tail_retries)
+    end
+
     # Set options for the query.
     #
     # @param q_opts [Hash] Query options.
@@ -339,13 +536,38 @@ module Mongo
     #
     # @yieldparam doc [Hash] Each matching document.
     def each
-      enum = cursor.to_enum
+      enum = cached || cursor.to_enum
       enum.each do |doc|
         yield doc
       end if block_given?
       enum
     end
 
+    # Iterate through the documents returned by the query with +count+
+    # cursors at once, each scanning its own range of +_id+ values on one
+    # of the nodes the read preference allows reading from.
+    #
+    # Documents are yielded on the calling thread, in no particular order,
+    # and the cursors only fetch ahead of the block by a few batches.
+    #
+    # @example Export a collection with four cursors.
+    #   Scope.new(collection, {}, :read => :secondary).parallel_each(4) do |doc|
+    #     export(doc)
+    #   end
+    #
+    # @param count [Integer] The number of cursors.
+    #
+    # @raise [ArgumentError] If the scope has a skip or limit.
+    #
+    # @yieldparam doc [Hash] Each matching document.
+    #
+    # @return [Enumerator] An enumerator of the documents, when no block is
+    #   given.
+    def parallel_each(count, &block)
+      return to_enum(:parallel_each, count) unless block_given?
+      ParallelScan.new(self, count).each(&block)
+    end
+
     private
 
     # Create a +Cursor+ using this +Scope+.
@@ -355,6 +577,30 @@ module Mongo
       Cursor.new(self)
     end
 
+    # Get an enumerator over the docs in the result cache of the client,
+    # querying them as raw BSON when they are not cached yet. The docs are
+    # cached under the raw version of the scope, so they are shared
+    # whether or not they are decoded. Tailable scopes are never cached.
+    #
+    # @return [Enumerator, nil] The enumerator, or nil when the docs are
+    #   not to be cached.
+    def cached
+      return nil unless @opts[:cache] && !@opts[:tailable]
+      result_cache = @collection.client.result_cache
+      return nil unless result_cache
+      scope = Scope.new(@collection, @selector, @opts.merge(:raw => true))
+      docs = result_cache.fetch(scope, @opts[:cache]) do
+        Cursor.new(scope).to_enum.to_a
+      end
+      return docs.each if raw
+      Enumerator.new do |yielder|
+        docs.each do |doc|
+          yielder << Protocol::Serializers::Document.deserialize(
+            StringIO.new(doc))
+        end
+      end
+    end
+
     # Clone or dup the current +Scope+.
     #
     # The @opt and @selector instance variables are duped and the
@@ -0,0 +1,231 @@
+# Copyright (C) 2013 MongoDB, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+module Mongo
+  class Scope
+
+    # Scans the result set of a +Scope+ with several cursors at once, each
+    # over its own range of +_id+ values and on its own node, while the
+    # documents are yielded on the calling thread.
+    #
+    # The ranges split the interval between the lowest and highest
+    # matching +_id+, by generation time for object ids and by value for
+    # numbers. Every value between two object ids, or between two numbers,
+    # is of the same type in the BSON sort order, so the ranges cover every
+    # matching document. Any other +_id+ is scanned with a single cursor.
+    #
+    # Documents are handed over through a bounded queue of batches, so the
+    # cursors stop fetching while the consumer falls behind and memory use
+    # does not grow with the size of the result set. The order of the
+    # documents is not defined, so a sort on the scope is ignored.
+    #
+    # @example
+    #   ParallelScan.new(scope, 4).each { |doc| export(doc) }
+    #
+    # @api semipublic
+    class ParallelScan
+
+      # The number of documents handed over to the consumer at a time.
+      BATCH_SIZE = 100
+
+      # The number of batches each cursor may have waiting in the queue
+      # for the consumer.
+      QUEUED_BATCHES = 2
+
+      # The marker a cursor puts in the queue once it has been iterated.
+      DONE = Object.new.freeze
+
+      # Creates a parallel scan.
+      #
+      # @param scope [Scope] The +Scope+ defining the query.
+      # @param count [Integer] The number of cursors to scan with.
+      #
+      # @raise [ArgumentError] If the count is not positive or the scope
+      #   has a skip or limit, which cannot be split between cursors.
+      #
+      # @return [ParallelScan] The parallel scan.
+      def initialize(scope, count)
+        unless count.is_a?(Integer) && count > 0
+          raise ArgumentError, "Invalid number of cursors #{count.inspect}."
+        end
+        if scope.skip || scope.limit
+          raise ArgumentError, 'A parallel scan cannot skip or limit.'
+        end
+        @scope   = scope
+        @count   = count
+        @queue   = SizedQueue.new(count * QUEUED_BATCHES)
+        @stopped = false
+      end
+
+      # Iterate through the result set with a cursor per partition, spread
+      # over the nodes the read preference of the scope may read from.
+      #
+      # @raise [Client::NoNode] If no node may be read from.
+      #
+      # @yieldparam doc [Hash] Each matching document.
+      def each
+        threads = partitions.each_with_index.map do |scope, index|
+          node = nodes[index % nodes.size]
+          Thread.new { scan(scope, node) }
+        end
+        consume(threads.size) { |doc| yield doc }
+      ensure
+        stop(threads) if threads
+      end
+
+      private
+
+      # Pop the batches off the queue and yield their documents until every
+      # cursor is done, raising the error a cursor failed with.
+      #
+      # @param remaining [Integer] The number of cursors running.
+      def consume(remaining)
+        while remaining > 0
+          batch = @queue.pop
+          if batch.equal?(DONE)
+            remaining -= 1
+          elsif batch.is_a?(Exception)
+            raise batch
+          else
+            batch.each { |doc| yield doc }
+          end
+        end
+      end
+
+      # Iterate a partition on its node, putting its documents in the queue
+      # in batches until the consumer stops.
+      #
+      # @param scope [Scope] The partition.
+      # @param node [Node] The node to query.
+      def scan(scope, node)
+        cursor = Cursor.new(scope, node)
+        cursor.to_enum.each_slice(BATCH_SIZE) do |batch|
+          break if @stopped
+          @queue.push(batch)
+        end
+        @queue.push(DONE)
+      rescue StandardError => e
+        @queue.push(e)
+      ensure
+        cursor.close if cursor
+      end
+
+      # Stop the cursors once the consumer is done or failed, emptying the
+      # queue until no cursor is left waiting on it.
+      #
+      # @param threads [Array<Thread>] The threads of the cursors.
+      def stop(threads)
+        @stopped = true
+        threads.each do |thread|
+          @queue.clear until thread.join(0.01)
+        end
+      end
+
+      # Get the nodes to spread the cursors over.
+      #
+      # @return [Array<Node>] The nodes the scope may read from.
+      def nodes
+        @nodes ||= begin
+          read = ReadPreference.get(@scope.read)
+          selected = @scope.collection.client.cluster.select_nodes(read)
+          raise Client::NoNode.new if selected.empty?
+          selected.shuffle
+        end
+      end
+
+      # Split the scope into a scope for each range of +_id+ values.
+      #
+      # @return [Array<Scope>] The partitions.
+      def partitions
+        low, high = bound(1), bound(-1)
+        bounds = split(low, high)
+        return [partition(nil)] unless bounds
+        bounds.each_cons(2).each_with_index.map do |(from, to), index|
+          last = index == bounds.size - 2
+          range = { '$gte' => from, (last ? '$lte' : '$lt') => to }
+          partition(range)
+        end
+      end
+
+      # Get the lowest or highest +_id+ matching the scope.
+      #
+      # @param direction [Integer] 1 for the lowest, -1 for the highest.
+      #
+      # @return [Object, nil] The +_id+, or nil if nothing matches.
+      def bound(direction)
+        doc = Scope.new(@scope.collection, @scope.selector,
+                        :read => @scope.read, :sort => { '_id' => direction },
+                        :fields => { '_id' => 1 }, :limit => -1).first
+        doc && doc['_id']
+      end
+
+      # Get the boundaries of the ranges between the lowest and the highest
+      # +_id+.
+      #
+      # @param low [Object] The lowest +_id+.
+      # @param high [Object] The highest +_id+.
+      #
+      # @return [Array, nil] The boundaries, or nil if the ids cannot be
+      #   split.
+      def split(low, high)
+        if low.is_a?(Numeric) && high.is_a?(Numeric)
+          interpolate(low, high, low, high) { |value| value }
+        elsif low.is_a?(BSON::ObjectId) && high.is_a?(BSON::ObjectId)
+          interpolate(low, high, low.generation_time.to_i,
+                      high.generation_time.to_i) do |time|
+            BSON::ObjectId.from_time(Time.at(time))
+          end
+        end
+      end
+
+      # Split the interval between two values into at most +@count+ ranges
+      # of equal width, dropping the ranges that would be empty.
+      #
+      # @param low [Object] The lowest +_id+.
+      # @param high [Object] The highest +_id+.
+      # @param from [Numeric] The position of the lowest +_id+.
+      # @param to [Numeric] The position of the highest +_id+.
+      # @yieldparam position [Numeric] The position of a boundary.
+      # @yieldreturn [Object] The +_id+ at the position.
+      #
+      # @return [Array] The boundaries, the lowest and highest +_id+ included.
+      def interpolate(low, high, from, to)
+        width = (to - from) / @count.to_f
+        width = width.ceil if from.is_a?(Integer) && to.is_a?(Integer)
+        return [low, high] unless width > 0
+        inner = (1...@count).map { |i| from + width * i }
+        inner = inner.select { |position| position > from && position < to }
+        [low] + inner.uniq.map { |position| yield position } + [high]
+      end
+
+      # Get the scope of the documents of the partition.
+      #
+      # @param range [Hash, nil] The range of the +_id+ values, or nil for
+      #   every value.
+      #
+      # @return [Scope] The partition.
+      def partition(range)
+        selector = if range.nil?
+          @scope.selector
+        elsif @scope.selector.empty?
+          { '_id' => range }
+        else
+          { '$and' => [@scope.selector, { '_id' => range }] }
+        end
+        Scope.new(@scope.collection, selector,
+                  @scope.opts.reject { |key, _| key == :sort })
+      end
+    end
+  end
+end
@@ -81,7 +81,12 @@ module Mongo
     #   * :replica_set [String] replica set name
     #   * :connect_timeout [Fixnum] connect timeout
     #   * :socket_timeout [Fixnum] socket timeout
+    #   * :local_threshold [Fixnum] node selection latency window
+    #   * :server_selection_timeout [Fixnum] node selection timeout
+    #   * :heartbeat_frequency [Fixnum] time between cluster scans
     #   * :ssl [true, false] ssl enabled?
+    #   * :compressors [Array<String>] compressors, in order of preference
+    #   * :zlib_compression_level [Fixnum] zlib compression level
     #
     #   Write Options (returned in a hash under the :write key)
     #   * :w [String, Fixnum] write concern value
@@ -189,6 +194,11 @@ module Mongo
     option 'connectTimeoutMS', :connect_timeout
     option 'socketTimeoutMS', :socket_timeout
 
+    # Node Selection Options
+    option 'localThresholdMS', :local_threshold
+    option 'serverSelectionTimeoutMS', :server_selection_timeout
+    option 'heartbeatFrequencyMS', :heartbeat_frequency
+
     # Write Options
     option 'w', :w, :group => :write
     option 'j', :j, :group => :write
@@ -202,6 +212,10 @@ module Mongo
     # Security Options
     option 'ssl', :ssl
 
+    # Compression Options
+    option 'compressors', :compressors, :type => :compressors
+    option 'zlibCompressionLevel', :zlib_compression_level
+
     # Auth Options
     option 'authSource', :source, :group => :auth, :type => :auth_source
     option 'authMechanism', :mechanism, :group => :auth, :type => :auth_mech
@@ -352,6 +366,15 @@ module Mongo
       READ_MODE_MAP[value]
     end
 
+    # Compressors transformation.
+    #
+    # @param value [String] The comma separated compressor names.
+    #
+    # @return [Array<String>] The compressor names.
+    def compressors(value)
+      value.split(',')
+    end
+
     # Read preference tags transformation.
     #
     # @param value [String] The string representing tag set.
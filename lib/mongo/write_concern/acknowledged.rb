@@ -32,6 +32,19 @@ module Mongo
       def get_last_error
         @get_last_error ||= { :getlasterror => 1 }.merge(normalize(options))
       end
+
+      # Get the BSON bytes of the get last error command, encoded once for
+      # every write made with the concern.
+      #
+      # @example Get the encoded gle command.
+      #   acknowledged.encoded_get_last_error
+      #
+      # @return [ String ] The frozen BSON bytes of the gle command.
+      #
+      # @since 2.0.0
+      def encoded_get_last_error
+        @encoded_get_last_error ||= get_last_error.to_bson.freeze
+      end
     end
   end
 end
@@ -37,6 +37,18 @@ module Mongo
       def get_last_error
         NOOP
       end
+
+      # Get the encoded gle command for an unacknowledged write.
+      #
+      # @example Get the encoded gle command.
+      #   unacknowledged.encoded_get_last_error
+      #
+      # @return [ nil ] The noop.
+      #
+      # @since 2.0.0
+      def encoded_get_last_error
+        NOOP
+      end
     end
   end
 end
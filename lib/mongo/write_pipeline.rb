@@ -0,0 +1,159 @@
+# Copyright (C) 2013 MongoDB, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+module Mongo
+
+  # Queues insert, update and delete messages for a collection and sends
+  # them in a single write on one connection. Under an acknowledged write
+  # concern each write is followed by its get last error query, and the
+  # replies are read once every message has been written, then matched to
+  # their writes by request id.
+  #
+  # A +WritePipeline+ is not created directly by a user. Rather,
+  # +Collection#pipeline+ yields one.
+  #
+  # @since 2.0.0
+  class WritePipeline
+
+    # @return [ Mongo::Collection ] The collection written to.
+    attr_reader :collection
+    # @return [ Array<Mongo::Protocol::Message> ] The queued writes.
+    attr_reader :writes
+
+    # Instantiate a new write pipeline.
+    #
+    # @example Instantiate the pipeline.
+    #   Mongo::WritePipeline.new(collection)
+    #
+    # @param [ Mongo::Collection ] collection The collection to write to.
+    #
+    # @since 2.0.0
+    def initialize(collection)
+      @collection = collection
+      @writes = []
+    end
+
+    # Queue an insert of the documents.
+    #
+    # @example Queue an insert.
+    #   writes.insert([{ :name => 'Emily' }])
+    #
+    # @param [ Array<Hash> ] documents The documents to insert.
+    # @param [ Hash ] options The options for the Insert message.
+    #
+    # @return [ Mongo::WritePipeline ] The pipeline.
+    #
+    # @since 2.0.0
+    def insert(documents, options = {})
+      push(Protocol::Insert.new(namespace, nil, documents, options))
+    end
+
+    # Queue an update of the documents matching the selector.
+    #
+    # @example Queue a multi update.
+    #   writes.update({ :age => 20 }, { '$inc' => { :age => 1 } },
+    #                 :flags => [:multi_update])
+    #
+    # @param [ Hash ] selector The update selector.
+    # @param [ Hash ] update The update to perform.
+    # @param [ Hash ] options The options for the Update message.
+    #
+    # @return [ Mongo::WritePipeline ] The pipeline.
+    #
+    # @since 2.0.0
+    def update(selector, update, options = {})
+      push(Protocol::Update.new(namespace, nil, selector, update, options))
+    end
+
+    # Queue a delete of the documents matching the selector.
+    #
+    # @example Queue a delete.
+    #   writes.delete({ :name => 'Durran' })
+    #
+    # @param [ Hash ] selector The delete selector.
+    # @param [ Hash ] options The options for the Delete message.
+    #
+    # @return [ Mongo::WritePipeline ] The pipeline.
+    #
+    # @since 2.0.0
+    def delete(selector, options = {})
+      push(Protocol::Delete.new(namespace, nil, selector, options))
+    end
+
+    # Send every queued write and collect the result of each one.
+    #
+    # @example Execute the pipeline.
+    #   writes.execute
+    #
+    # @return [ Array<Hash, nil> ] The last error document of each write, in
+    #   the order the writes were queued, or nil for every write under an
+    #   unacknowledged write concern.
+    #
+    # @since 2.0.0
+    def execute
+      return [] if writes.empty?
+      get_last_error = client.write_concern.encoded_get_last_error
+      return send_writes if get_last_error.nil?
+      client.with_node do |connection|
+        queries = writes.map { database.last_error_query(get_last_error) }
+        connection.write(writes.zip(queries).flatten)
+        replies = connection.receive_replies(queries.map(&:request_id))
+        replies.map { |reply| reply.documents[0] }
+      end
+    end
+
+    private
+
+    # Send the writes without acknowledgement.
+    #
+    # @api private
+    #
+    # @return [ Array<nil> ] No result for each write.
+    #
+    # @since 2.0.0
+    def send_writes
+      client.with_node { |connection| connection.write(writes) }
+      Array.new(writes.size)
+    end
+
+    # Queue a write message.
+    #
+    # @api private
+    #
+    # @param [ Mongo::Protocol::Message ] message The write message.
+    #
+    # @return [ Mongo::WritePipeline ] The pipeline.
+    #
+    # @since 2.0.0
+    def push(message)
+      writes.push(message)
+      self
+    end
+
+    # @return [ Mongo::Client ] The client of the collection.
+    def client
+      collection.client
+    end
+
+    # @return [ Mongo::Database ] The database of the collection.
+    def database
+      collection.database
+    end
+
+    # @return [ String ] The frozen namespace of the collection.
+    def namespace
+      collection.full_namespace
+    end
+  end
+end
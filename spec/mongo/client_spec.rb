@@ -131,6 +131,19 @@ describe Mongo::Client do
         expect(client.options).to eq(:write => { :w => 3 })
       end
     end
+
+    context 'when client options are provided' do
+
+      let(:client) do
+        described_class.connect('mongodb://127.0.0.1:27017/testdb?w=3',
+                                :read => :secondary)
+      end
+
+      it 'merges them over the uri options' do
+        expect(client.options).to eq(:write => { :w => 3 },
+                                     :read => :secondary)
+      end
+    end
   end
 
   describe '#eql' do
@@ -247,6 +260,78 @@ describe Mongo::Client do
           expect(client[:users].name).to eq('users')
         end
       end
+
+      context 'when a result cache size is provided' do
+
+        let(:client) do
+          described_class.new(['127.0.0.1:27017'], :result_cache_size => 1024)
+        end
+
+        it 'creates a result cache of that size' do
+          expect(client.result_cache.max_size).to eq(1024)
+        end
+
+        it 'shares the result cache with clients derived from it' do
+          new_client = client.with(:read => :secondary)
+          expect(new_client.result_cache).to be(client.result_cache)
+        end
+      end
+
+      context 'when no result cache size is provided' do
+
+        let(:client) do
+          described_class.new(['127.0.0.1:27017'], :read => :secondary)
+        end
+
+        it 'does not create a result cache' do
+          expect(client.result_cache).to be_nil
+        end
+      end
+    end
+  end
+
+  describe '#bootstrap' do
+
+    let(:client) { described_class.new(['127.0.0.1:27017']) }
+
+    it 'bootstraps the cluster' do
+      expect(client.cluster).to receive(:bootstrap)
+      expect(client.bootstrap).to be(client)
+    end
+
+    context 'when the bootstrap option is set' do
+
+      it 'bootstraps the cluster on instantiation' do
+        expect_any_instance_of(Mongo::Cluster).to receive(:bootstrap)
+        described_class.new(['127.0.0.1:27017'], :bootstrap => true)
+      end
+    end
+  end
+
+  describe '#after_fork' do
+
+    let(:client) { described_class.new(['127.0.0.1:27017'], options) }
+    let(:options) { {} }
+
+    it 'resets the cluster' do
+      expect(client.cluster).to receive(:after_fork)
+      expect(client.cluster).not_to receive(:bootstrap)
+      expect(client.after_fork).to be(client)
+    end
+
+    context 'when the bootstrap option is set' do
+
+      let(:options) { { :bootstrap => true } }
+
+      before do
+        allow_any_instance_of(Mongo::Cluster).to receive(:bootstrap)
+      end
+
+      it 'bootstraps the cluster again' do
+        expect(client.cluster).to receive(:after_fork).ordered
+        expect(client.cluster).to receive(:bootstrap).ordered
+        client.after_fork
+      end
     end
   end
 
@@ -322,10 +407,35 @@ describe Mongo::Client do
         )
       end
 
+      it 'shares the cluster' do
+        expect(new_client.cluster).to be(client.cluster)
+      end
+
+      it 'keeps the database in use' do
+        client.use(:test)
+        new_client = client.with(:read => :primary)
+        expect(new_client[:users].database.name).to eq('test')
+      end
+    end
+
+    context 'when a cluster option is changed' do
+
+      let(:client) do
+        described_class.new(['127.0.0.1:27017'], :read => :secondary)
+      end
+
+      let!(:new_client) do
+        client.with(:local_threshold => 50)
+      end
+
+      it 'gets a cluster of its own' do
+        expect(new_client.cluster).not_to be(client.cluster)
+      end
+
       it 'clones the cluster addresses' do
-        expect do
-          new_client.cluster.addresses
-        end.not_to equal(client.cluster.addresses)
+        expect(new_client.cluster.addresses).to eq(client.cluster.addresses)
+        expect(new_client.cluster.addresses).not_to be(
+          client.cluster.addresses)
       end
     end
 
@@ -420,4 +530,55 @@ describe Mongo::Client do
       end
     end
   end
+
+  describe '#read_preference' do
+
+    context 'when no option is provided' do
+
+      let(:client) { described_class.new(['127.0.0.1:27017']) }
+
+      it 'reads from the primary' do
+        expect(client.read_preference).to be_primary
+      end
+    end
+
+    context 'when the option is provided' do
+
+      let(:client) do
+        described_class.new(
+          ['127.0.0.1:27017'],
+          :read => { :mode => :nearest, :tags => [{ 'dc' => 'ny' }] }
+        )
+      end
+
+      it 'returns the read preference of the option' do
+        expect(client.read_preference).to eq(
+          Mongo::ReadPreference.new(:nearest, [{ 'dc' => 'ny' }])
+        )
+      end
+    end
+  end
+
+  describe '#select_node' do
+
+    let(:client) { described_class.new(['127.0.0.1:27017']) }
+    let(:node) { double('node') }
+
+    it 'selects a primary when no read preference is provided' do
+      expect(client.cluster).to receive(:select_node).with(
+        Mongo::ReadPreference.new(:primary)).and_return(node)
+      expect(client.select_node).to be(node)
+    end
+
+    it 'selects with the provided read preference' do
+      expect(client.cluster).to receive(:select_node).with(
+        Mongo::ReadPreference.new(:secondary)).and_return(node)
+      expect(client.select_node(:secondary)).to be(node)
+    end
+
+    it 'raises an error when no node is eligible' do
+      allow(client.cluster).to receive(:select_node).and_return(nil)
+      expect { client.select_node }.to raise_error(Mongo::Client::NoNode)
+    end
+  end
 end
@@ -0,0 +1,102 @@
+require 'spec_helper'
+
+describe Mongo::Cluster::Monitor do
+
+  let(:node) do
+    double('node').tap do |node|
+      allow(node).to receive(:description).and_return('ismaster' => true)
+      allow(node).to receive(:round_trip_time).and_return(0.001)
+    end
+  end
+
+  let(:cluster) { double('cluster') }
+  let(:monitor) { described_class.new(cluster, :heartbeat_frequency => 500) }
+
+  before do
+    allow(cluster).to receive(:scan!).and_return([node])
+  end
+
+  after do
+    monitor.stop
+  end
+
+  describe '#scan!' do
+
+    it 'publishes the topology of the cluster' do
+      monitor.scan!
+      expect(monitor.topology.nodes).to eq([node])
+      expect(monitor.topology.primary).to be(node)
+    end
+
+    it 'increments the generation' do
+      expect { monitor.scan! }.to change { monitor.topology.generation }.by(1)
+    end
+  end
+
+  describe '#start' do
+
+    it 'scans the cluster in the background' do
+      monitor.start
+      expect(monitor.wait_for_scan(0, 1).generation).to be >= 1
+    end
+
+    it 'keeps scanning every heartbeat' do
+      monitor.start
+      sleep(1.2)
+      expect(monitor.topology.generation).to be >= 2
+    end
+
+    it 'keeps scanning after a scan fails' do
+      scans = 0
+      allow(cluster).to receive(:scan!) do
+        scans += 1
+        raise ArgumentError, 'bad reply' if scans == 1
+        [node]
+      end
+      allow(monitor).to receive(:warn)
+      monitor.start
+      expect(monitor.wait_for_scan(0, 2).generation).to eq(1)
+      expect(monitor).to be_running
+    end
+
+    it 'starts one thread only' do
+      monitor.start
+      expect(Thread).to_not receive(:new)
+      monitor.start
+    end
+  end
+
+  describe '#wait_for_scan' do
+
+    it 'returns a newer topology at once' do
+      monitor.scan!
+      expect(monitor.wait_for_scan(0, 5).generation).to eq(1)
+    end
+
+    it 'times out without a scan' do
+      expect(monitor.wait_for_scan(0, 0.01).generation).to eq(0)
+    end
+  end
+
+  describe '#wait_for_topology' do
+
+    it 'waits for the first scan' do
+      expect(monitor.wait_for_topology(1).generation).to eq(1)
+    end
+
+    it 'returns a scanned topology at once' do
+      monitor.scan!
+      expect(cluster).not_to receive(:scan!)
+      expect(monitor.wait_for_topology(0).generation).to eq(1)
+    end
+  end
+
+  describe '#invalidate' do
+
+    it 'publishes the topology without the node' do
+      monitor.scan!
+      monitor.invalidate(node)
+      expect(monitor.topology.nodes).to be_empty
+    end
+  end
+end
@@ -0,0 +1,64 @@
+require 'spec_helper'
+
+describe Mongo::Cluster::Topology do
+
+  def node(description)
+    double('node').tap do |node|
+      allow(node).to receive(:description) { description }
+      allow(node).to receive(:round_trip_time) { 0.001 }
+    end
+  end
+
+  let(:primary) { node('ismaster' => true) }
+  let(:secondary) { node('secondary' => true) }
+  let(:topology) { described_class.new([secondary, primary], 3) }
+
+  it 'is frozen' do
+    expect(topology).to be_frozen
+    expect(topology.nodes).to be_frozen
+  end
+
+  it 'finds the primary' do
+    expect(topology.primary).to be(primary)
+  end
+
+  it 'is not sharded without a mongos' do
+    expect(topology).to_not be_mongos
+  end
+
+  describe '#members' do
+
+    it 'keeps a frozen snapshot of each node' do
+      member = topology.members.last
+      expect(member).to be_frozen
+      expect(member.description).to be_frozen
+      expect(member.node).to be(primary)
+    end
+
+    it 'keeps the state the nodes had when it was found' do
+      member = topology.members.last
+      allow(primary).to receive(:description) { { 'secondary' => true } }
+      allow(primary).to receive(:round_trip_time) { 0.5 }
+      expect(member).to be_primary
+      expect(member.round_trip_time).to eq(0.001)
+    end
+  end
+
+  describe '#without' do
+
+    let(:without) { topology.without(primary) }
+
+    it 'leaves the node out' do
+      expect(without.nodes).to eq([secondary])
+      expect(without.primary).to be_nil
+    end
+
+    it 'keeps the generation' do
+      expect(without.generation).to eq(3)
+    end
+
+    it 'keeps the snapshots of the other nodes' do
+      expect(without.members).to eq([topology.members.first])
+    end
+  end
+end
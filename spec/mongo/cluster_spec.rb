@@ -147,4 +147,184 @@ describe Mongo::Cluster do
       end
     end
   end
+
+  describe '#select_node' do
+
+    let(:addresses) do
+      ['127.0.0.1:27017', '127.0.0.1:27019']
+    end
+
+    let(:cluster) do
+      described_class.new(addresses, :local_threshold => 30,
+                                     :server_selection_timeout => 100)
+    end
+
+    let(:nodes_internal) do
+      cluster.instance_variable_get(:@nodes)
+    end
+
+    let(:topology) do
+      Mongo::Cluster::Topology.new(nodes_internal, 1)
+    end
+
+    let(:read) { Mongo::ReadPreference.new(:nearest) }
+
+    before do
+      allow(cluster.monitor).to receive(:start).and_return(cluster.monitor)
+      allow(cluster.monitor).to receive(:topology).and_return(topology)
+    end
+
+    it 'selects from the topology within the local threshold' do
+      expect(read).to receive(:select_node).with(
+        topology.members, 30).and_return(topology.members.last)
+      expect(cluster.select_node(read)).to be(nodes_internal.last)
+    end
+
+    it 'does not refresh any node' do
+      nodes_internal.each { |node| expect(node).to_not receive(:refresh!) }
+      cluster.select_node(read)
+    end
+
+    context 'when no node is eligible' do
+
+      let(:rescanned) do
+        Mongo::Cluster::Topology.new(nodes_internal.take(1), 2)
+      end
+
+      it 'waits for the monitor to rescan' do
+        allow(read).to receive(:select_node) do |nodes, _|
+          nodes.first if nodes.size == 1
+        end
+        expect(cluster.monitor).to receive(:wait_for_scan).with(
+          1, kind_of(Float)).and_return(rescanned)
+        expect(cluster.select_node(read)).to be(nodes_internal.first)
+      end
+
+      it 'returns nil after the server selection timeout' do
+        allow(read).to receive(:select_node)
+        allow(cluster.monitor).to receive(:wait_for_scan) do |_, timeout|
+          sleep(timeout)
+          topology
+        end
+        expect(cluster.select_node(read)).to be_nil
+      end
+    end
+  end
+
+  describe '#select_nodes' do
+
+    let(:cluster) do
+      described_class.new(['127.0.0.1:27017', '127.0.0.1:27019'],
+                          :server_selection_timeout => 100)
+    end
+
+    let(:nodes_internal) do
+      cluster.instance_variable_get(:@nodes)
+    end
+
+    let(:topology) do
+      Mongo::Cluster::Topology.new(nodes_internal, 1)
+    end
+
+    let(:read) { Mongo::ReadPreference.new(:secondary) }
+
+    before do
+      allow(cluster.monitor).to receive(:start).and_return(cluster.monitor)
+      allow(cluster.monitor).to receive(:topology).and_return(topology)
+    end
+
+    it 'selects every eligible node from the topology' do
+      expect(read).to receive(:select_nodes).with(
+        topology.members, 15).and_return(topology.members)
+      expect(cluster.select_nodes(read)).to eq(nodes_internal)
+    end
+
+    context 'when no node is eligible' do
+
+      before do
+        allow(read).to receive(:select_nodes).and_return([])
+        allow(cluster.monitor).to receive(:wait_for_scan) do |_, timeout|
+          sleep(timeout)
+          topology
+        end
+      end
+
+      it 'returns no nodes after the server selection timeout' do
+        expect(cluster.select_nodes(read)).to eq([])
+      end
+    end
+  end
+
+  describe '#scan!' do
+
+    let(:cluster) do
+      described_class.new(['127.0.0.1:27017'])
+    end
+
+    let(:seed) do
+      cluster.instance_variable_get(:@nodes).first
+    end
+
+    before do
+      allow_any_instance_of(Mongo::Node).to receive(:refresh!).and_return(true)
+      allow(seed).to receive(:refresh!).and_return(true)
+      allow(seed).to receive(:description).and_return(
+        'hosts' => ['127.0.0.1:27017', '127.0.0.1:27018'],
+        'passives' => ['127.0.0.1:27019'])
+    end
+
+    it 'adds the hosts and passives the nodes report' do
+      cluster.scan!
+      expect(cluster.addresses).to eq(
+        ['127.0.0.1:27017', '127.0.0.1:27018', '127.0.0.1:27019'])
+    end
+
+    it 'refreshes the discovered nodes' do
+      expect(cluster.scan!.size).to eq(3)
+    end
+  end
+
+  describe '#bootstrap' do
+
+    let(:cluster) do
+      described_class.new(['127.0.0.1:27017', '127.0.0.1:27018'])
+    end
+
+    it 'waits for the first topology and warms every node' do
+      expect(cluster.monitor).to receive(:wait_for_topology)
+      cluster.nodes.each { |node| expect(node).to receive(:warm) }
+      expect(cluster.bootstrap).to be(cluster)
+    end
+  end
+
+  describe '#after_fork' do
+
+    let(:cluster) do
+      described_class.new(['127.0.0.1:27017'], :ssl => true)
+    end
+
+    it 'resets every node' do
+      expect(cluster.nodes.first).to receive(:after_fork)
+      cluster.after_fork
+    end
+
+    it 'forgets the kept ssl sessions' do
+      context = cluster.nodes.first.options[:ssl_context]
+      expect(context).to receive(:clear)
+      cluster.after_fork
+    end
+  end
+
+  describe '#invalidate' do
+
+    let(:cluster) do
+      described_class.new(['127.0.0.1:27017'])
+    end
+
+    it 'takes the node out of the topology' do
+      node = cluster.nodes.first
+      expect(cluster.monitor).to receive(:invalidate).with(node)
+      cluster.invalidate(node)
+    end
+  end
 end
@@ -46,4 +46,105 @@ describe Mongo::Collection do
       end
     end
   end
+
+  describe '#full_namespace' do
+
+    let(:client) { Mongo::Client.new(['127.0.0.1:27017']) }
+    let(:database) { Mongo::Database.new(client, :test) }
+    let(:collection) { described_class.new(database, :users) }
+
+    it 'returns the frozen namespace of the collection' do
+      expect(collection.full_namespace).to eq('test.users')
+      expect(collection.full_namespace).to be_frozen
+    end
+  end
+
+  describe '#bulk_insert' do
+
+    let(:client) { Mongo::Client.new(['127.0.0.1:27017']) }
+    let(:database) { Mongo::Database.new(client, :test) }
+    let(:collection) { described_class.new(database, :users) }
+    let(:node) { Mongo::Node.new(double('cluster'), '127.0.0.1:27017') }
+    let(:connection) { double('connection') }
+    let(:documents) { [{ :name => 'Tyler' }, { :name => 'Brandon' }] }
+    let(:ok) { [double('reply', :documents => [{ 'err' => nil }])] }
+    let(:failed) { [double('reply', :documents => [{ 'err' => 'E11000' }])] }
+    let(:writes) { [] }
+
+    before do
+      allow(client).to receive(:select_node).and_return(node)
+      allow(node).to receive(:with_connection).and_yield(connection)
+      allow(connection).to receive(:write) { |messages| writes << messages }
+      allow(node).to receive(:max_message_size).and_return(60)
+    end
+
+    it 'sends the documents in size bounded messages' do
+      allow(connection).to receive(:receive_replies).and_return(ok)
+      expect(collection.bulk_insert(documents)).to eq(2)
+      expect(writes.size).to eq(2)
+    end
+
+    it 'sends each message with its get last error in one write' do
+      allow(connection).to receive(:receive_replies) do |request_ids|
+        expect(request_ids).to eq([writes.last.last.request_id])
+        ok
+      end
+      collection.bulk_insert(documents)
+      expect(writes.map { |messages| messages.map(&:class) }).to eq(
+        [[Mongo::Protocol::Insert, Mongo::Protocol::Query]] * 2)
+    end
+
+    context 'when an insert fails' do
+
+      before do
+        allow(connection).to receive(:receive_replies).and_return(failed, ok)
+      end
+
+      it 'stops inserting' do
+        expect do
+          collection.bulk_insert(documents)
+        end.to raise_error(described_class::WriteError, 'E11000')
+        expect(writes.size).to eq(1)
+      end
+
+      context 'when continuing on error' do
+
+        it 'sends every message before raising' do
+          expect do
+            collection.bulk_insert(documents, :continue_on_error => true)
+          end.to raise_error(described_class::WriteError)
+          expect(writes.size).to eq(2)
+        end
+      end
+    end
+
+    context 'when the write concern is unacknowledged' do
+
+      let(:client) do
+        Mongo::Client.new(['127.0.0.1:27017'], :write => { :w => 0 })
+      end
+
+      it 'does not check the last error' do
+        expect(connection).not_to receive(:receive_replies)
+        collection.bulk_insert(documents)
+        expect(writes.map(&:class)).to eq([Mongo::Protocol::Insert] * 2)
+      end
+    end
+
+    context 'when the client has a result cache' do
+
+      let(:client) do
+        Mongo::Client.new(['127.0.0.1:27017'], :result_cache_size => 1024)
+      end
+
+      it 'invalidates the results of the collection' do
+        allow(connection).to receive(:receive_replies).and_return(failed)
+        expect(client.result_cache).to receive(:invalidate).with(
+          collection.full_namespace)
+        expect do
+          collection.bulk_insert(documents)
+        end.to raise_error(described_class::WriteError)
+      end
+    end
+  end
 end
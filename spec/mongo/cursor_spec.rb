@@ -80,9 +80,9 @@ describe Mongo::Cursor do
           end.to yield_control.exactly(limit).times
         end
 
-        it 'does not send a kill cursors message' do
+        it 'does not queue the cursor to be killed' do
           allow(connection).to receive(:send_and_receive).and_return(results)
-          expect(Mongo::Protocol::KillCursors).not_to receive(:new)
+          expect(node).not_to receive(:kill_cursor)
           cursor.each(&b)
         end
       end
@@ -114,8 +114,8 @@ describe Mongo::Cursor do
           end.to yield_control.exactly(limit).times
         end
 
-        it 'sends a kill cursors message' do
-          expect(Mongo::Protocol::KillCursors).to receive(:new)
+        it 'queues the cursor to be killed' do
+          expect(node).to receive(:kill_cursor).with(nonzero)
           cursor.each(&b)
         end
       end
@@ -141,8 +141,8 @@ describe Mongo::Cursor do
           end.to yield_control.exactly(total_docs).times
         end
 
-        it 'does not send a kill cursors message' do
-          expect(Mongo::Protocol::KillCursors).not_to receive(:new)
+        it 'does not queue the cursor to be killed' do
+          expect(node).not_to receive(:kill_cursor)
           cursor.each(&b)
         end
       end
@@ -172,8 +172,8 @@ describe Mongo::Cursor do
           end.to yield_control.exactly(total_docs).times
         end
 
-        it 'does not send a kill cursors message' do
-          expect(Mongo::Protocol::KillCursors).not_to receive(:new)
+        it 'does not queue the cursor to be killed' do
+          expect(node).not_to receive(:kill_cursor)
           cursor.each(&b)
         end
       end
@@ -204,8 +204,8 @@ describe Mongo::Cursor do
           cursor.each(&b)
         end
 
-        it 'does not send a kill cursors message' do
-          expect(Mongo::Protocol::KillCursors).not_to receive(:new)
+        it 'does not queue the cursor to be killed' do
+          expect(node).not_to receive(:kill_cursor)
           cursor.each(&b)
         end
       end
@@ -247,8 +247,8 @@ describe Mongo::Cursor do
           end.to yield_control.exactly(limit).times
         end
 
-        it 'does not send a kill cursors message' do
-          expect(Mongo::Protocol::KillCursors).not_to receive(:new)
+        it 'does not queue the cursor to be killed' do
+          expect(node).not_to receive(:kill_cursor)
           cursor.each(&b)
         end
       end
@@ -280,8 +280,8 @@ describe Mongo::Cursor do
           end.to yield_control.exactly(limit).times
         end
 
-        it 'sends a kill cursors message' do
-          expect(Mongo::Protocol::KillCursors).to receive(:new)
+        it 'queues the cursor to be killed' do
+          expect(node).to receive(:kill_cursor).with(nonzero)
           cursor.each(&b)
         end
       end
@@ -316,8 +316,8 @@ describe Mongo::Cursor do
         end.to yield_control.exactly(limit).times
       end
 
-      it 'sends a kill cursors message' do
-        expect(Mongo::Protocol::KillCursors).to receive(:new)
+      it 'queues the cursor to be killed' do
+        expect(node).to receive(:kill_cursor).with(nonzero)
         cursor.each(&b)
       end
     end
@@ -347,8 +347,8 @@ describe Mongo::Cursor do
           end.to yield_control.exactly(batch_size).times
         end
 
-        it 'does not send a kill cursors message' do
-          expect(Mongo::Protocol::KillCursors).not_to receive(:new)
+        it 'does not queue the cursor to be killed' do
+          expect(node).not_to receive(:kill_cursor)
           cursor.each(&b)
         end
       end
@@ -380,11 +380,315 @@ describe Mongo::Cursor do
           end.to yield_control.exactly(batch_size + remaining).times
         end
 
-        it 'sends a kill cursors message' do
-          expect(Mongo::Protocol::KillCursors).not_to receive(:new)
+        it 'does not queue the cursor to be killed' do
+          expect(node).not_to receive(:kill_cursor)
           cursor.each(&b)
         end
       end
     end
+
+    context 'when the query returns no documents' do
+      let(:responses) { results(0, 0) }
+
+      it 'does not yield' do
+        expect { |b| cursor.each(&b) }.not_to yield_control
+      end
+    end
+
+    context 'when a batch has been consumed' do
+      let(:responses) { [results(nonzero, 2), results(0, 2)] }
+
+      it 'releases the batch' do
+        cursor.each { |doc| doc }
+        expect(cursor.instance_variable_get(:@batch)).to be_empty
+      end
+
+      it 'returns the documents of every batch' do
+        expect(cursor.to_enum.to_a).to eq([0, 1, 0, 1])
+      end
+    end
+
+    context 'when prefetching' do
+      let(:scope_opts) { { :prefetch => 1 } }
+      let(:pool) { double('pool') }
+      let(:responses) { results(nonzero, 4) }
+
+      before do
+        allow(node).to receive(:pool).and_return(pool)
+        allow(pool).to receive(:checkout).and_return(connection)
+        allow(pool).to receive(:checkin)
+        allow(connection).to receive(:receive).and_return(results(0, 2))
+        allow(connection).to receive(:read_reply)
+      end
+
+      it 'sends the get more before the batch is consumed' do
+        expect(connection).to receive(:send_message).once
+        expect(cursor.to_enum.take(2)).to eq([0, 1])
+      end
+
+      it 'returns the documents of every batch' do
+        expect(cursor.to_enum.to_a).to eq([0, 1, 2, 3, 0, 1])
+      end
+
+      it 'returns the connection to the pool' do
+        expect(pool).to receive(:checkin).with(connection)
+        cursor.each(&b)
+      end
+
+      context 'when iteration stops early' do
+
+        it 'drains the prefetched reply' do
+          expect(connection).to receive(:read_reply)
+          cursor.each { |doc| break if doc == 2 }
+        end
+
+        it 'queues the cursor to be killed by its node' do
+          expect(node).to receive(:kill_cursor).with(nonzero)
+          cursor.each { |doc| break if doc == 2 }
+        end
+
+        context 'when the prefetched reply closed the cursor' do
+
+          let(:reply) { double('reply', :cursor_id => 0) }
+
+          before do
+            allow(connection).to receive(:read_reply).and_return(reply)
+          end
+
+          it 'does not kill the cursor' do
+            expect(node).not_to receive(:kill_cursor)
+            cursor.each { |doc| break if doc == 2 }
+          end
+        end
+      end
+    end
+
+    context 'when the query is an exhaust query' do
+      let(:scope_opts) { { :exhaust => true } }
+      let(:pool) { double('pool') }
+      let(:responses) { results(nonzero, 2) }
+
+      before do
+        allow(client).to receive(:select_node).and_return(node)
+        allow(node).to receive(:pool).and_return(pool)
+        allow(pool).to receive(:checkout).and_return(connection)
+        allow(pool).to receive(:checkin)
+        allow(connection).to receive(:receive).and_return(results(nonzero, 2),
+                                                          results(0, 1))
+      end
+
+      it 'sets the exhaust flag on the query' do
+        expect(Mongo::Protocol::Query).to receive(:new) do |a, b, c, opts|
+          expect(opts[:flags]).to include(:exhaust)
+        end
+        cursor.each(&b)
+      end
+
+      it 'reads the streamed batches without sending get mores' do
+        expect(connection).not_to receive(:send_message)
+        expect(cursor.to_enum.to_a).to eq([0, 1, 0, 1, 0])
+      end
+
+      it 'returns the connection to the pool' do
+        expect(pool).to receive(:checkin).with(connection)
+        cursor.each(&b)
+      end
+
+      context 'when iteration stops early' do
+
+        it 'discards the connection' do
+          expect(pool).to receive(:discard).with(connection)
+          cursor.each { |doc| break if doc == 1 }
+        end
+      end
+    end
+
+    context 'when the cursor is tailable' do
+      let(:scope_opts) { { :tailable => true, :await_data => true } }
+
+      def tail_results(cursor_id, ids, flags = [])
+        [{ :cursor_id => cursor_id,
+           :nreturned => ids.size,
+           :docs => ids.map { |id| { '_id' => id } },
+           :flags => flags },
+         node]
+      end
+
+      before do
+        allow(cursor).to receive(:sleep)
+      end
+
+      it 'sets the tailable and await data flags on the query' do
+        expect(Mongo::Protocol::Query).to receive(:new) do |a, b, c, opts|
+          expect(opts[:flags]).to include(:tailable_cursor, :await_data)
+        end
+        cursor.each { break }
+      end
+
+      context 'when the server is await capable' do
+        let(:responses) do
+          [tail_results(nonzero, [1], [:await_capable]),
+           tail_results(nonzero, [], [:await_capable]),
+           tail_results(nonzero, [2], [:await_capable])]
+        end
+
+        it 'waits on the server for new documents' do
+          expect(cursor).not_to receive(:sleep)
+          expect(cursor.to_enum.take(2)).to eq([{ '_id' => 1 },
+                                                 { '_id' => 2 }])
+        end
+      end
+
+      context 'when the server is not await capable' do
+        let(:responses) do
+          [tail_results(nonzero, [1]),
+           tail_results(nonzero, []),
+           tail_results(nonzero, [2])]
+        end
+
+        it 'backs off before asking for more documents' do
+          expect(cursor).to receive(:sleep).with(0.1).once
+          cursor.to_enum.take(2)
+        end
+      end
+
+      context 'when the cursor dies on the server' do
+        let(:responses) do
+          [tail_results(0, [1]), tail_results(nonzero, [2])]
+        end
+
+        it 'queries again from the last document seen' do
+          selectors = []
+          allow(Mongo::Protocol::Query).to receive(:new) do |a, b, c, opts|
+            selectors << c
+          end
+          cursor.to_enum.take(2)
+          expect(selectors.last).to include('_id' => { :$gt => 1 })
+        end
+
+        context 'when the selector has its own condition on _id' do
+          let(:scope) do
+            Mongo::Scope.new(collection, { '_id' => { :$lt => 10 } },
+                             scope_opts)
+          end
+
+          it 'keeps the condition of the selector' do
+            selectors = []
+            allow(Mongo::Protocol::Query).to receive(:new) do |a, b, c, opts|
+              selectors << c
+            end
+            cursor.to_enum.take(2)
+            expect(selectors.last).to eq(
+              :$and => [{ '_id' => { :$lt => 10 } },
+                        { '_id' => { :$gt => 1 } }])
+          end
+        end
+      end
+
+      context 'when the connection fails' do
+        let(:responses) do
+          [tail_results(nonzero, [1]), tail_results(nonzero, [2])]
+        end
+
+        before do
+          allow(node).to receive(:with_connection).and_raise(
+            Mongo::SocketError)
+        end
+
+        it 'resumes the cursor' do
+          expect(cursor.to_enum.take(2)).to eq([{ '_id' => 1 },
+                                                 { '_id' => 2 }])
+        end
+
+        it 'kills the cursor that may still be open on the server' do
+          expect(node).to receive(:kill_cursor).with(nonzero)
+          cursor.to_enum.take(2)
+        end
+
+        context 'when the connection keeps failing' do
+          let(:scope_opts) do
+            { :tailable => true, :await_data => true, :tail_retries => 2 }
+          end
+          before do
+            queries = 0
+            allow(connection).to receive(:send_and_receive) do
+              queries += 1
+              raise Mongo::SocketError if queries > 1
+              tail_results(nonzero, [1])
+            end
+          end
+
+          it 'raises the error once the retries are exhausted' do
+            expect do
+              cursor.to_enum.take(2)
+            end.to raise_error(Mongo::SocketError)
+          end
+        end
+      end
+    end
+  end
+
+  context 'when created for a node' do
+
+    let(:cursor) do
+      described_class.new(scope, node).tap do
+        allow(connection).to receive(:send_and_receive).and_return(*responses)
+      end
+    end
+
+    it 'sends the query to that node' do
+      expect(node).to receive(:with_connection).and_yield(connection)
+      expect(client).not_to receive(:with_node)
+      cursor.each(&b)
+    end
+  end
+
+  context 'when neither a limit nor a batch size is set' do
+
+    let(:responses) { [results(nonzero, 5), results(0, 5)] }
+
+    it 'leaves the get more batch size to the server' do
+      expect(Mongo::Protocol::GetMore).to receive(:new).with(
+        anything, anything, 0, nonzero).and_call_original
+      cursor.each(&b)
+    end
+  end
+
+  describe '#close' do
+
+    let(:responses) { [results(nonzero, 5)] }
+
+    before do
+      cursor.send(:request_docs)
+    end
+
+    it 'queues the cursor to be killed by its node' do
+      expect(node).to receive(:kill_cursor).with(nonzero)
+      cursor.close
+    end
+
+    it 'does not send a message on the connection' do
+      expect(connection).not_to receive(:send_message)
+      cursor.close
+    end
+
+    it 'does nothing once closed' do
+      cursor.close
+      expect(node).not_to receive(:kill_cursor)
+      cursor.close
+    end
+  end
+
+  describe '.finalizer' do
+
+    it 'queues an open cursor to be killed' do
+      expect(node).to receive(:kill_cursor).with(nonzero)
+      described_class.finalizer([node, nonzero]).call
+    end
+
+    it 'does nothing for a closed cursor' do
+      expect(node).not_to receive(:kill_cursor)
+      described_class.finalizer([node, 0]).call
+    end
   end
 end
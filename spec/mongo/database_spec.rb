@@ -61,6 +61,35 @@ describe Mongo::Database do
     end
   end
 
+  describe '#command_namespace' do
+
+    let(:database) { described_class.new(client, :test) }
+
+    it 'returns the frozen namespace of the commands' do
+      expect(database.command_namespace).to eq('test.$cmd')
+      expect(database.command_namespace).to be_frozen
+    end
+  end
+
+  describe '#last_error_query' do
+
+    let(:database) { described_class.new(client, :test) }
+    let(:get_last_error) { { :getlasterror => 1, :w => 2 } }
+
+    let(:query) do
+      database.last_error_query(get_last_error.to_bson)
+    end
+
+    it 'shares the namespace of the database' do
+      expect(query.namespace).to be(database.command_namespace)
+    end
+
+    it 'serializes the same query as the command hash' do
+      expected = database.last_error_query(get_last_error)
+      expect(query.serialize[8..-1]).to eq(expected.serialize[8..-1])
+    end
+  end
+
   describe '#collection_names' do
 
     let(:names) do
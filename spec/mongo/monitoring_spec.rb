@@ -0,0 +1,64 @@
+require 'spec_helper'
+
+describe Mongo::Monitoring do
+
+  let(:subscriber) { double('subscriber') }
+  let(:event) { described_class::PoolEvent.new('127.0.0.1:27017', nil, 1) }
+
+  after { described_class.unsubscribe(subscriber) }
+
+  describe '.subscribe' do
+
+    it 'enables the events' do
+      described_class.subscribe(subscriber)
+      expect(described_class).to be_enabled
+    end
+  end
+
+  describe '.unsubscribe' do
+
+    it 'removes the subscriber' do
+      described_class.subscribe(subscriber)
+      described_class.unsubscribe(subscriber)
+      expect(described_class.subscribers).not_to include(subscriber)
+    end
+  end
+
+  describe '.publish' do
+
+    before { described_class.subscribe(subscriber) }
+
+    it 'sends the event to the subscribers that implement it' do
+      expect(subscriber).to receive(:checked_in).with(event)
+      described_class.publish(:checked_in, event)
+    end
+
+    it 'skips the subscribers that do not implement it' do
+      expect { described_class.publish(:checked_in, event) }.not_to raise_error
+    end
+
+    context 'when a subscriber fails' do
+
+      before do
+        allow(subscriber).to receive(:checked_in) { raise ArgumentError }
+        allow(described_class).to receive(:warn)
+      end
+
+      it 'does not raise the error' do
+        expect do
+          described_class.publish(:checked_in, event)
+        end.not_to raise_error
+      end
+    end
+  end
+
+  describe 'OperationEvent' do
+
+    let(:event) { described_class::OperationEvent.new }
+
+    it 'sums the pool wait, write and read times into the duration' do
+      event.pool_wait, event.write_time, event.read_time = 0.25, 0.5, 1.0
+      expect(event.duration).to eq(1.75)
+    end
+  end
+end
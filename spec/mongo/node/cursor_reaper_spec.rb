@@ -0,0 +1,59 @@
+require 'spec_helper'
+
+describe Mongo::Node::CursorReaper do
+
+  let(:connection) { double('connection') }
+  let(:sent) { Queue.new }
+  let(:reaper) { described_class.new(node) }
+
+  let(:node) do
+    double('node').tap do |node|
+      allow(node).to receive(:with_connection).and_yield(connection)
+    end
+  end
+
+  before do
+    allow(connection).to receive(:send_message) do |message|
+      sent.push(message)
+    end
+  end
+
+  def cursor_ids(message)
+    message.instance_variable_get(:@cursor_ids)
+  end
+
+  describe '#schedule' do
+
+    it 'does not wait for the cursor to be killed' do
+      allow(node).to receive(:with_connection) { sleep(1) }
+      start = Time.now
+      reaper.schedule(1)
+      expect(Time.now - start).to be < 0.5
+    end
+
+    it 'kills the cursor in the background' do
+      reaper.schedule(1)
+      expect(cursor_ids(sent.pop)).to eq([1])
+    end
+
+    it 'kills the cursors queued together in one message' do
+      [1, 2, 3].each { |cursor_id| reaper.schedule(cursor_id) }
+      expect(cursor_ids(sent.pop)).to eq([1, 2, 3])
+    end
+  end
+
+  describe '#flush' do
+
+    it 'sends at most the maximum batch size per message' do
+      ids = (1..described_class::MAX_BATCH_SIZE + 1).to_a
+      reaper.send(:flush, ids)
+      expect(cursor_ids(sent.pop).size).to eq(described_class::MAX_BATCH_SIZE)
+      expect(cursor_ids(sent.pop)).to eq([ids.last])
+    end
+
+    it 'gives up on the cursors when the node cannot be reached' do
+      allow(node).to receive(:with_connection).and_raise(Mongo::SocketError)
+      expect { reaper.send(:flush, [1]) }.to_not raise_error
+    end
+  end
+end
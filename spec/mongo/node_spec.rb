@@ -0,0 +1,301 @@
+require 'spec_helper'
+
+describe Mongo::Node do
+
+  let(:cluster) { double('cluster') }
+
+  describe '#initialize' do
+
+    let(:node) { described_class.new(cluster, address) }
+
+    context 'when the address has a host and port' do
+
+      let(:address) { '127.0.0.1:27018' }
+
+      it 'sets the host' do
+        expect(node.host).to eq('127.0.0.1')
+      end
+
+      it 'sets the port' do
+        expect(node.port).to eq(27018)
+      end
+    end
+
+    context 'when the address has no port' do
+
+      let(:address) { '127.0.0.1' }
+
+      it 'sets the default port' do
+        expect(node.port).to eq(described_class::DEFAULT_PORT)
+      end
+    end
+
+    context 'when the address is an ipv6 address' do
+
+      let(:address) { '[::1]:27018' }
+
+      it 'sets the host' do
+        expect(node.host).to eq('::1')
+      end
+
+      it 'sets the port' do
+        expect(node.port).to eq(27018)
+      end
+    end
+
+    context 'when the address is a unix socket' do
+
+      let(:address) { '/tmp/mongodb-27017.sock' }
+
+      it 'sets the host to the path' do
+        expect(node.host).to eq(address)
+      end
+
+      it 'does not set a port' do
+        expect(node.port).to be_nil
+      end
+    end
+
+    context 'when pool options are provided' do
+
+      let(:node) do
+        described_class.new(cluster, '127.0.0.1:27017', :max_pool_size => 32)
+      end
+
+      it 'configures the pool' do
+        expect(node.pool.max_size).to eq(32)
+      end
+    end
+
+    context 'when no size limits are provided' do
+
+      let(:node) { described_class.new(cluster, '127.0.0.1:27017') }
+
+      it 'sets the default maximum document size' do
+        expect(node.max_bson_object_size).to eq(
+          described_class::DEFAULT_MAX_BSON_OBJECT_SIZE
+        )
+      end
+
+      it 'sets the default maximum message size' do
+        expect(node.max_message_size).to eq(
+          described_class::DEFAULT_MAX_MESSAGE_SIZE
+        )
+      end
+    end
+  end
+
+  describe '#with_connection' do
+
+    let(:node) { described_class.new(cluster, '127.0.0.1:27017') }
+
+    it 'yields a connection from the pool' do
+      expect(node.pool).to receive(:with_connection).and_yield(:connection)
+      expect { |b| node.with_connection(&b) }.to yield_with_args(:connection)
+    end
+
+    context 'when a shared connection is asked for' do
+
+      let(:options) { { :shared => true } }
+
+      context 'when the node has no shared connections' do
+
+        it 'yields a connection from the pool' do
+          expect(node.pool).to receive(:with_connection).and_yield(:connection)
+          expect do |b|
+            node.with_connection(options, &b)
+          end.to yield_with_args(:connection)
+        end
+      end
+
+      context 'when the node has shared connections' do
+
+        let(:node) do
+          described_class.new(cluster, '127.0.0.1:27017', :multiplex => 2)
+        end
+
+        let(:yielded) do
+          Array.new(3) { node.with_connection(options) { |c| c } }
+        end
+
+        it 'does not use the pool' do
+          expect(node.pool).to_not receive(:with_connection)
+          node.with_connection(options) {}
+        end
+
+        it 'yields the shared connections in turn' do
+          expect(yielded.map(&:class).uniq).to eq([Mongo::Pool::Multiplexer])
+          expect(yielded[0]).to_not be(yielded[1])
+          expect(yielded[2]).to be(yielded[0])
+        end
+      end
+    end
+
+    context 'when the connection fails' do
+
+      before do
+        allow(node.pool).to receive(:with_connection).and_raise(
+          Mongo::SocketError)
+      end
+
+      it 'invalidates the node in the cluster' do
+        expect(cluster).to receive(:invalidate).with(node)
+        expect do
+          node.with_connection {}
+        end.to raise_error(Mongo::SocketError)
+      end
+    end
+
+    context 'when the connection times out' do
+
+      before do
+        allow(node.pool).to receive(:with_connection).and_raise(
+          Mongo::SocketTimeoutError)
+      end
+
+      it 'does not invalidate the node' do
+        expect(cluster).to_not receive(:invalidate)
+        expect do
+          node.with_connection {}
+        end.to raise_error(Mongo::SocketTimeoutError)
+      end
+    end
+  end
+
+  describe '#refresh!' do
+
+    let(:node) { described_class.new(cluster, '127.0.0.1:27017') }
+
+    let(:description) do
+      { 'ismaster' => false, 'secondary' => true, 'setName' => 'rs',
+        'tags' => { 'dc' => 'ny' }, 'maxBsonObjectSize' => 1024,
+        'maxMessageSizeBytes' => 4096 }
+    end
+
+    let(:connection) { double('connection') }
+
+    before do
+      allow(node).to receive(:create_connection).and_return(connection)
+      allow(connection).to receive(:send_and_receive) do
+        [{ :docs => [description] }, node]
+      end
+    end
+
+    it 'returns whether the node is operable' do
+      expect(node.refresh!).to be(true)
+    end
+
+    it 'keeps the ismaster reply' do
+      node.refresh!
+      expect(node).to be_secondary
+      expect(node.replica_set_name).to eq('rs')
+      expect(node.tags).to eq('dc' => 'ny')
+    end
+
+    it 'takes the size limits from the ismaster reply' do
+      node.refresh!
+      expect(node.max_bson_object_size).to eq(1024)
+      expect(node.max_message_size).to eq(4096)
+    end
+
+    context 'when size limits are provided' do
+
+      let(:node) do
+        described_class.new(cluster, '127.0.0.1:27017',
+                            :max_bson_object_size => 512)
+      end
+
+      it 'keeps the provided limits' do
+        node.refresh!
+        expect(node.max_bson_object_size).to eq(512)
+      end
+    end
+
+    it 'measures the round trip time' do
+      node.refresh!
+      expect(node.round_trip_time).to be_a(Float)
+    end
+
+    it 'smooths the round trip time' do
+      allow(Mongo::Pool::Socket::Base).to receive(:monotonic_time).and_return(
+        0.0, 1.0, 1.0, 1.5)
+      node.refresh!
+      node.refresh!
+      expect(node.round_trip_time).to be_within(0.001).of(0.9)
+    end
+
+    context 'when the node cannot be reached' do
+
+      before do
+        allow(connection).to receive(:send_and_receive).and_raise(
+          Mongo::SocketError)
+        allow(connection).to receive(:disconnect)
+      end
+
+      it 'is no longer operable' do
+        node.refresh!
+        expect(node).to_not be_operable
+      end
+
+      it 'disconnects the monitoring connection' do
+        expect(connection).to receive(:disconnect)
+        node.refresh!
+      end
+    end
+  end
+
+  describe '#warm' do
+
+    let(:node) { described_class.new(cluster, '127.0.0.1:27017') }
+
+    it 'opens the minimum connections of the pool' do
+      expect(node.pool).to receive(:warm)
+      expect(node.warm).to be(node)
+    end
+
+    context 'when the node cannot be reached' do
+
+      before do
+        allow(node.pool).to receive(:warm).and_raise(Errno::ECONNREFUSED)
+      end
+
+      it 'leaves the node as it is' do
+        expect(node.warm).to be(node)
+      end
+    end
+  end
+
+  describe '#after_fork' do
+
+    let(:node) do
+      described_class.new(cluster, '127.0.0.1:27017', :multiplex => 1)
+    end
+
+    it 'forgets the connections of the pool' do
+      expect(node.pool).to receive(:after_fork)
+      node.after_fork
+    end
+
+    it 'drops the cursors queued to be killed' do
+      reaper = node.reaper
+      node.after_fork
+      expect(node.reaper).not_to be(reaper)
+    end
+
+    it 'creates new shared connections' do
+      shared = node.send(:next_multiplexer)
+      node.after_fork
+      expect(node.send(:next_multiplexer)).not_to be(shared)
+    end
+  end
+
+  describe '#kill_cursor' do
+
+    let(:node) { described_class.new(cluster, '127.0.0.1:27017') }
+
+    it 'queues the cursor on the reaper' do
+      expect(node.reaper).to receive(:schedule).with(42)
+      node.kill_cursor(42)
+    end
+  end
+end
@@ -0,0 +1,310 @@
+require 'spec_helper'
+
+describe Mongo::Pool::ConnectionPool do
+
+  let(:opts) { { :max_pool_size => 2, :wait_queue_timeout => 0.1 } }
+  let(:args) { ['localhost', 27017, nil, { :connect => false }] }
+
+  let(:pool) do
+    described_class.new(opts) { Mongo::Pool::Connection.new(*args) }
+  end
+
+  describe '#initialize' do
+
+    let(:pool) { described_class.new {} }
+
+    it 'sets the default max size' do
+      expect(pool.max_size).to eq(described_class::DEFAULT_MAX_SIZE)
+    end
+
+    it 'sets the default min size' do
+      expect(pool.min_size).to eq(described_class::DEFAULT_MIN_SIZE)
+    end
+
+    it 'sets the default wait timeout' do
+      expect(pool.wait_timeout).to eq(described_class::DEFAULT_WAIT_TIMEOUT)
+    end
+
+    it 'does not create any connections' do
+      expect(pool.size).to eq(0)
+    end
+  end
+
+  describe '#checkout' do
+
+    it 'leases the connection' do
+      expect(pool.checkout.expired?).to be false
+    end
+
+    context 'when a connection is available' do
+
+      let!(:first)  { pool.checkout }
+      let!(:second) { pool.checkout }
+
+      before do
+        pool.checkin(first)
+        pool.checkin(second)
+      end
+
+      it 'returns the most recently checked in connection' do
+        expect(pool.checkout).to equal(second)
+      end
+
+      it 'does not create a new connection' do
+        pool.checkout
+        expect(pool.size).to eq(2)
+      end
+    end
+
+    context 'when the pool is at its maximum size' do
+
+      before { 2.times { pool.checkout } }
+
+      it 'raises an error after the wait timeout' do
+        expect do
+          pool.checkout
+        end.to raise_error(described_class::WaitTimeout)
+      end
+    end
+
+    context 'when a connection cannot be created' do
+
+      let(:pool) { described_class.new(opts) { raise Mongo::SocketError } }
+
+      it 'releases the reserved slot' do
+        expect { pool.checkout }.to raise_error(Mongo::SocketError)
+        expect(pool.size).to eq(0)
+      end
+    end
+
+    context 'when connections have been idle too long' do
+
+      let(:opts) { { :max_idle_time => 60, :min_pool_size => 1 } }
+
+      before do
+        connections = 2.times.map { pool.checkout }
+        connections.each do |connection|
+          allow(connection).to receive(:last_use) { Time.now - 120 }
+          pool.checkin(connection)
+        end
+      end
+
+      it 'reaps idle connections down to the minimum size' do
+        pool.checkout
+        expect(pool.size).to eq(1)
+      end
+    end
+  end
+
+  describe '#with_connection' do
+
+    it 'checks the connection back in' do
+      pool.with_connection { |connection| connection }
+      expect(pool.available).to eq(1)
+    end
+
+    it 'returns the result of the block' do
+      expect(pool.with_connection { 1 }).to eq(1)
+    end
+
+    context 'when a socket error occurs' do
+
+      it 'discards the connection' do
+        expect do
+          pool.with_connection { raise Mongo::SocketError }
+        end.to raise_error(Mongo::SocketError)
+        expect(pool.size).to eq(0)
+      end
+    end
+
+    context 'when any other error occurs mid-operation' do
+
+      it 'discards the connection' do
+        expect do
+          pool.with_connection { raise Timeout::Error }
+        end.to raise_error(Timeout::Error)
+        expect(pool.size).to eq(0)
+        expect(pool.available).to eq(0)
+      end
+    end
+  end
+
+  describe '#warm' do
+
+    let(:opts) { { :max_pool_size => 4, :min_pool_size => 2 } }
+
+    it 'opens the minimum number of connections' do
+      pool.warm
+      expect(pool.size).to eq(2)
+      expect(pool.available).to eq(2)
+    end
+
+    it 'does not open more connections when warm' do
+      pool.warm
+      expect(Mongo::Pool::Connection).not_to receive(:new)
+      pool.warm
+    end
+
+    it 'keeps the connections from being reaped as idle' do
+      pool.warm
+      expect(pool.checkout.expired?).to be false
+    end
+
+    context 'when a connection cannot be created' do
+
+      let(:pool) { described_class.new(opts) { raise Mongo::SocketError } }
+
+      it 'releases the reserved room' do
+        expect { pool.warm }.to raise_error(Mongo::SocketError)
+        expect(pool.size).to eq(0)
+      end
+    end
+  end
+
+  context 'when running under a fiber scheduler' do
+
+    let(:opts) { { :max_pool_size => 1, :wait_queue_timeout => 1 } }
+    let(:events) { [] }
+
+    it 'only blocks the fiber waiting for a connection' do
+      connection = checked_out = nil
+      FiberScheduler.run do
+        Fiber.schedule { connection = pool.checkout }
+        Fiber.schedule do
+          events << :waiting
+          checked_out = pool.checkout
+          events << :checked_out
+        end
+        Fiber.schedule do
+          events << :checking_in
+          pool.checkin(connection)
+        end
+      end
+      expect(events).to eq([:waiting, :checking_in, :checked_out])
+      expect(checked_out).to equal(connection)
+    end
+  end
+
+  describe '#after_fork' do
+
+    let!(:connection) { pool.checkout }
+
+    before do
+      pool.checkin(connection)
+    end
+
+    it 'forgets the connections without closing them' do
+      expect(connection).not_to receive(:disconnect)
+      pool.after_fork
+      expect(pool.size).to eq(0)
+      expect(pool.available).to eq(0)
+    end
+
+    it 'creates new connections on checkout' do
+      pool.after_fork
+      expect(pool.checkout).not_to equal(connection)
+    end
+
+    context 'when a connection made before the fork is checked in' do
+
+      let(:leased) { pool.checkout }
+
+      before do
+        leased
+        pool.after_fork
+      end
+
+      it 'drops the connection without closing it' do
+        expect(leased).not_to receive(:disconnect)
+        pool.checkin(leased)
+        expect(pool.available).to eq(0)
+        expect(pool.size).to eq(0)
+      end
+
+      it 'does not hand the connection out again' do
+        pool.checkin(leased)
+        expect(pool.checkout).not_to equal(leased)
+      end
+    end
+
+    context 'when a connection made before the fork is discarded' do
+
+      let(:leased) { pool.checkout }
+
+      before do
+        leased
+        pool.after_fork
+        pool.checkout
+      end
+
+      it 'does not close the connection' do
+        expect(leased).not_to receive(:disconnect)
+        pool.discard(leased)
+      end
+
+      it 'does not release room in the pool' do
+        pool.discard(leased)
+        expect(pool.size).to eq(1)
+      end
+    end
+  end
+
+  context 'when monitoring is enabled' do
+
+    let(:events) { [] }
+
+    let(:subscriber) do
+      double('subscriber').tap do |subscriber|
+        [:checked_out, :checked_in, :connection_created,
+         :connection_closed].each do |name|
+          allow(subscriber).to receive(name) { |event| events << [name, event] }
+        end
+      end
+    end
+
+    before { Mongo::Monitoring.subscribe(subscriber) }
+    after { Mongo::Monitoring.unsubscribe(subscriber) }
+
+    it 'publishes the creation, checkout and checkin of connections' do
+      pool.with_connection {}
+      names = events.map(&:first)
+      expect(names).to eq([:connection_created, :checked_out, :checked_in])
+    end
+
+    it 'publishes the address and size of the pool' do
+      pool.with_connection {}
+      expect(events.first[1].address).to eq('localhost:27017')
+      expect(events.first[1].size).to eq(1)
+    end
+
+    it 'records the checkout wait on the connection' do
+      connection = pool.checkout
+      expect(connection.pool_wait).to be_a(Float)
+      expect(events.last[1].wait).to eq(connection.pool_wait)
+    end
+
+    it 'publishes the closing of discarded connections' do
+      pool.discard(pool.checkout)
+      expect(events.last[0]).to eq(:connection_closed)
+    end
+
+    context 'when idle connections are reaped' do
+
+      let(:opts) { { :max_idle_time => 60 } }
+
+      before do
+        connection = pool.checkout
+        allow(connection).to receive(:last_use) { Time.now - 120 }
+        pool.checkin(connection)
+      end
+
+      it 'publishes their closing without holding the pool lock' do
+        allow(subscriber).to receive(:connection_closed) do |event|
+          events << [:connection_closed, pool.available]
+        end
+        pool.checkout
+        expect(events).to include([:connection_closed, 0])
+      end
+    end
+  end
+end
@@ -187,6 +187,18 @@ describe Mongo::Pool::Connection do
 
     end
 
+    context 'when ssl is disabled' do
+
+      let(:opts) { { :ssl => false, :ssl_verify => true } }
+
+      it 'creates a tcp socket instance' do
+        allow(Socket::TCP).to receive(:new)
+        expect(Socket::TCP).to receive(:new)
+        described_class.new(host, port, nil, opts)
+      end
+
+    end
+
     it 'creates a tcp socket instance by default' do
       allow(Socket::TCP).to receive(:new)
       expect(Socket::TCP).to receive(:new)
@@ -230,13 +242,425 @@ describe Mongo::Pool::Connection do
   end
 
   describe '#read' do
-    # TODO: definite Operation and OperationResult so that we can figure out
-    # what needs to happen here.
+
+    let(:documents) { [{ 'name' => 'Tyler' }, { 'name' => 'Emily' }] }
+
+    let(:reply) do
+      data = [0, 0, 0, 0, documents.size].pack('l<q<l<l<')
+      data << documents.map(&:to_bson).join
+      [data.bytesize + 16, 0, 0, 1].pack('l<l<l<l<') + data
+    end
+
+    before do
+      connection.instance_variable_set(:@socket, StringIO.new(reply * 2))
+    end
+
+    it 'returns the documents from the reply' do
+      expect(connection.read).to eq(documents)
+    end
+
+    it 'reads consecutive replies' do
+      connection.read
+      expect(connection.read).to eq(documents)
+    end
+
+    it 'keeps the header buffer to the size of a header' do
+      2.times { connection.read }
+      expect(connection.instance_variable_get(:@header).bytesize).to eq(16)
+    end
+
+    context 'when the socket closes mid reply' do
+
+      before do
+        socket = StringIO.new(reply[0, reply.bytesize - 1])
+        connection.instance_variable_set(:@socket, socket)
+      end
+
+      it 'raises a socket error' do
+        expect { connection.read }.to raise_error(Mongo::SocketError)
+      end
+    end
+  end
+
+  describe '#send_and_receive' do
+
+    let(:socket) { double('socket') }
+    let(:message) { Mongo::Protocol::Query.new('xgen', 'users', {}) }
+    let(:documents) { [{ 'name' => 'Tyler' }] }
+    let(:opts) { { :connect => false, :node => node } }
+    let(:node) { double('node') }
+
+    let(:reply) do
+      data = [0, 10, 0, documents.size].pack('l<q<l<l<')
+      data << documents.map(&:to_bson).join
+      StringIO.new([data.bytesize + 16, 0, 0, 1].pack('l<l<l<l<') + data)
+    end
+
+    before do
+      allow(socket).to receive(:write)
+      allow(socket).to receive(:read) { |*args| reply.read(*args) }
+      allow(socket).to receive(:deadline=)
+      connection.instance_variable_set(:@socket, socket)
+    end
+
+    it 'returns the results and the node' do
+      results, from = connection.send_and_receive(1, message)
+      expect(results[:cursor_id]).to eq(10)
+      expect(results[:nreturned]).to eq(1)
+      expect(results[:docs].to_a).to eq(documents)
+      expect(from).to be(node)
+    end
+
+    it 'sets a deadline for the attempt on the socket' do
+      expect(socket).to receive(:deadline=).with(kind_of(Float)).ordered
+      expect(socket).to receive(:deadline=).with(nil).ordered
+      connection.send_and_receive(1, message)
+    end
+
+    context 'when a socket error occurs' do
+
+      before do
+        attempts = 0
+        allow(socket).to receive(:write) do
+          attempts += 1
+          raise Mongo::SocketError if attempts == 1
+        end
+        allow(socket).to receive(:close)
+        allow(connection).to receive(:connect) do
+          connection.instance_variable_set(:@socket, socket)
+        end
+      end
+
+      it 'reconnects and retries' do
+        results, _ = connection.send_and_receive(2, message)
+        expect(results[:nreturned]).to eq(1)
+      end
+
+      it 'raises the error when out of tries' do
+        expect do
+          connection.send_and_receive(1, message)
+        end.to raise_error(Mongo::SocketError)
+      end
+    end
   end
 
   describe '#write' do
-    # TODO: definite Operation and OperationResult so that we can figure out
-    # what needs to happen here.
+
+    let(:socket) { double('socket') }
+    let(:written) { [] }
+    let(:message) { Mongo::Protocol::Query.new('xgen', 'users', {}) }
+
+    before do
+      allow(socket).to receive(:write) { |data| written << data.dup }
+      connection.instance_variable_set(:@socket, socket)
+    end
+
+    it 'writes the serialized message' do
+      connection.write(message)
+      expect(written.first.bytesize).to eq(message.serialize.bytesize)
+    end
+
+    it 'reuses the write buffer' do
+      buffer = connection.instance_variable_get(:@buffer)
+      connection.write(message)
+      connection.write(message)
+      expect(connection.instance_variable_get(:@buffer)).to equal(buffer)
+    end
+
+    it 'empties the buffer between messages' do
+      2.times { connection.write(message) }
+      expect(written.last.bytesize).to eq(written.first.bytesize)
+    end
+
+    context 'when the message has large encoded documents' do
+
+      let(:document) { { 'pad' => 'x' * 8192 }.to_bson }
+      let(:message) do
+        Mongo::Protocol::Insert.new('xgen', 'users', [document])
+      end
+
+      before do
+        allow(socket).to receive(:write) { |*data| written << data }
+      end
+
+      it 'writes the documents as separate segments' do
+        connection.write(message)
+        expect(written.first[1]).to equal(document)
+      end
+
+      it 'includes the documents in the message length' do
+        connection.write(message)
+        length = written.first.join.unpack('l<').first
+        expect(length).to eq(message.serialize.bytesize)
+      end
+    end
+
+    context 'when several messages are provided' do
+
+      it 'writes the messages with a single write' do
+        connection.write([message, message])
+        expect(written.size).to eq(1)
+        expect(written.first.bytesize).to eq(message.serialize.bytesize * 2)
+      end
+    end
+
+    context 'when a compressor was negotiated' do
+
+      let(:compressor) { Mongo::Protocol::Compression.get('zlib') }
+      let(:document) { { 'pad' => 'x' * 8192 }.to_bson }
+      let(:message) do
+        Mongo::Protocol::Insert.new('xgen', 'users', [document])
+      end
+
+      before do
+        compression = Mongo::Protocol::Compression.new(compressor)
+        connection.instance_variable_set(:@compression, compression)
+      end
+
+      it 'writes a compressed message' do
+        connection.write(message)
+        compressed = Mongo::Protocol::Compression.compressed?(written.first)
+        expect(compressed).to be_true
+        expect(written.first.bytesize).to be < document.bytesize
+      end
+    end
+  end
+
+  describe 'monitoring' do
+
+    let(:socket) { double('socket') }
+    let(:opts) { { :connect => false } }
+    let(:events) { [] }
+    let(:query) { Mongo::Protocol::Query.new('xgen', 'users', {}) }
+    let(:kill_cursors) { Mongo::Protocol::KillCursors.new([1]) }
+
+    let(:subscriber) do
+      double('subscriber').tap do |subscriber|
+        [:started, :succeeded, :failed].each do |name|
+          allow(subscriber).to receive(name) { |event| events << [name, event] }
+        end
+      end
+    end
+
+    let(:reply) do
+      data = [0, 0, 0, 1].pack('l<q<l<l<') << { 'ok' => 1 }.to_bson
+      [data.bytesize + 16, 0, query.request_id, 1].pack('l<l<l<l<') + data
+    end
+    let(:io) { StringIO.new(reply) }
+
+    before do
+      allow(socket).to receive(:write) { 0 }
+      allow(socket).to receive(:read) { |*args| io.read(*args) }
+      connection.instance_variable_set(:@socket, socket)
+      Mongo::Monitoring.subscribe(subscriber)
+    end
+
+    after { Mongo::Monitoring.unsubscribe(subscriber) }
+
+    it 'publishes a started operation for each message written' do
+      connection.write([query, kill_cursors])
+      started = events.select { |name, _| name == :started }.map(&:last)
+      expect(started.map(&:op_code)).to eq([2004, 2007])
+      expect(started[0].namespace).to eq('xgen.users')
+      expect(started[0].bytes_written).to eq(query.serialize.bytesize)
+    end
+
+    context 'when a compressor was negotiated' do
+
+      let(:document) { { 'pad' => 'x' * 8192 }.to_bson }
+      let(:insert) { Mongo::Protocol::Insert.new('xgen', 'users', [document]) }
+      let(:written) { [] }
+
+      before do
+        compressor = Mongo::Protocol::Compression.get('zlib')
+        compression = Mongo::Protocol::Compression.new(compressor)
+        connection.instance_variable_set(:@compression, compression)
+        allow(socket).to receive(:write) do |*data|
+          written << data.join
+          written.last.bytesize
+        end
+      end
+
+      it 'reports the bytes written to the socket' do
+        connection.write(insert)
+        started = events.find { |name, _| name == :started }.last
+        expect(started.bytes_written).to eq(written.first.bytesize)
+        expect(started.bytes_written).to be < document.bytesize
+      end
+    end
+
+    it 'publishes messages without replies as succeeded once written' do
+      connection.write(kill_cursors)
+      expect(events.map(&:first)).to eq([:started, :succeeded])
+    end
+
+    it 'publishes the operation as succeeded once its reply is read' do
+      connection.write(query)
+      connection.read_reply
+      name, event = events.last
+      expect(name).to eq(:succeeded)
+      expect(event.request_id).to eq(query.request_id)
+      expect(event.bytes_read).to eq(reply.bytesize)
+      expect(event.duration).to be >= event.read_time
+    end
+
+    it 'reports the pool wait with the next operation only' do
+      connection.pool_wait = 0.5
+      connection.write([kill_cursors, kill_cursors])
+      waits = events.select { |name, _| name == :succeeded }
+      expect(waits.map { |_, event| event.pool_wait }).to eq([0.5, 0.0])
+    end
+
+    context 'when reading the reply fails' do
+
+      before do
+        allow(socket).to receive(:read) { raise Mongo::SocketError }
+      end
+
+      it 'publishes the operations in flight as failed' do
+        connection.write(query)
+        expect { connection.read_reply }.to raise_error(Mongo::SocketError)
+        name, event = events.last
+        expect(name).to eq(:failed)
+        expect(event.error).to be_a(Mongo::SocketError)
+      end
+    end
+
+    context 'when decoding the reply fails' do
+
+      before do
+        allow(Mongo::Protocol::Reply).to receive(:deserialize_body) do
+          raise EOFError
+        end
+      end
+
+      it 'publishes the operations in flight as failed' do
+        connection.write(query)
+        expect { connection.read_reply }.to raise_error(EOFError)
+        expect(events.last[0]).to eq(:failed)
+      end
+
+      it 'forgets the operations in flight' do
+        connection.write(query)
+        expect { connection.read_reply }.to raise_error(EOFError)
+        expect(connection.instance_variable_get(:@in_flight)).to be_empty
+      end
+    end
+
+    context 'when nothing is subscribed' do
+
+      before { Mongo::Monitoring.unsubscribe(subscriber) }
+
+      it 'publishes no events' do
+        connection.write(query)
+        connection.read_reply
+        expect(events).to be_empty
+      end
+    end
+  end
+
+  describe 'compression' do
+
+    let(:socket) { double('socket') }
+    let(:opts) { { :connect => false, :compressors => %w(snappy zlib) } }
+    let(:written) { [] }
+    let(:supported) { ['zlib'] }
+    let(:document) { { 'pad' => 'x' * 8192 } }
+
+    def reply(documents)
+      data = [0, 0, 0, documents.size].pack('l<q<l<l<')
+      data << documents.map(&:to_bson).join
+      [data.bytesize + 16, 0, 0, 1].pack('l<l<l<l<') + data
+    end
+
+    let(:io) do
+      handshake = reply([{ 'ok' => 1, 'compression' => supported }])
+      compression = Mongo::Protocol::Compression.new(
+        Mongo::Protocol::Compression.get('zlib'))
+      StringIO.new(handshake + compression.compress(reply([document])))
+    end
+
+    before do
+      allow(socket).to receive(:write) { |*data| written << data.join }
+      allow(socket).to receive(:read) { |*args| io.read(*args) }
+      allow(Mongo::Pool::Socket::TCP).to receive(:new) { socket }
+    end
+
+    it 'offers the compressors in the handshake' do
+      connection.connect
+      expect(written.first).to include('compression')
+    end
+
+    it 'selects the first compressor the server supports' do
+      connection.connect
+      expect(connection.compressor).to eq('zlib')
+    end
+
+    it 'decompresses compressed replies' do
+      connection.connect
+      expect(connection.read).to eq([document])
+    end
+
+    context 'when the server supports none of the compressors' do
+
+      let(:supported) { [] }
+
+      it 'sends messages uncompressed' do
+        connection.connect
+        expect(connection.compressor).to be_nil
+      end
+
+      it 'raises a socket error on a compressed reply' do
+        connection.connect
+        expect { connection.read }.to raise_error(Mongo::SocketError)
+      end
+    end
+  end
+
+  describe '#receive_replies' do
+
+    let(:socket) { double('socket') }
+
+    def reply_to(request_id, document)
+      data = [0, 0, 0, 1].pack('l<q<l<l<') << document.to_bson
+      [data.bytesize + 16, 0, request_id, 1].pack('l<l<l<l<') + data
+    end
+
+    let(:io) { StringIO.new(replies) }
+
+    before do
+      allow(socket).to receive(:read) { |*args| io.read(*args) }
+      connection.instance_variable_set(:@socket, socket)
+    end
+
+    context 'when the replies are in the request order' do
+      let(:replies) { reply_to(1, { 'n' => 1 }) + reply_to(2, { 'n' => 2 }) }
+
+      it 'returns the reply to each request' do
+        replies = connection.receive_replies([1, 2])
+        expect(replies.map { |r| r.documents[0] }).to eq([{ 'n' => 1 },
+                                                          { 'n' => 2 }])
+      end
+    end
+
+    context 'when the replies are out of order' do
+      let(:replies) { reply_to(2, { 'n' => 2 }) + reply_to(1, { 'n' => 1 }) }
+
+      it 'returns the replies in the request order' do
+        replies = connection.receive_replies([1, 2])
+        expect(replies.map(&:response_to)).to eq([1, 2])
+      end
+    end
+
+    context 'when a reply answers another request' do
+      let(:replies) { reply_to(3, { 'n' => 3 }) }
+
+      it 'raises a socket error' do
+        expect do
+          connection.receive_replies([1])
+        end.to raise_error(Mongo::SocketError)
+      end
+    end
   end
 
 end
@@ -0,0 +1,114 @@
+require 'spec_helper'
+
+describe Mongo::Pool::Multiplexer do
+
+  let(:node) { double('node') }
+  let(:written) { [] }
+  let(:replies) { Queue.new }
+  let(:multiplexer) { described_class.new(connection) }
+
+  let(:connection) do
+    double('connection').tap do |connection|
+      allow(connection).to receive(:connect)
+      allow(connection).to receive(:disconnect)
+      allow(connection).to receive(:node) { node }
+      allow(connection).to receive(:write) { |message| written << message }
+      allow(connection).to receive(:read_reply) { replies.pop }
+      allow(connection).to receive(:results) do |reply|
+        { :docs => reply.documents }
+      end
+    end
+  end
+
+  def message(request_id)
+    double('message').tap do |message|
+      allow(message).to receive(:request_id) { request_id }
+    end
+  end
+
+  def reply_to(message)
+    double('reply').tap do |reply|
+      allow(reply).to receive(:response_to) { message.request_id }
+      allow(reply).to receive(:documents) { [message.request_id] }
+    end
+  end
+
+  def send_in_threads(messages)
+    threads = messages.map do |message|
+      Thread.new { multiplexer.send_and_receive(1, message) }
+    end
+    sleep(0.01) until written.size == messages.size
+    threads
+  end
+
+  describe '#send_and_receive' do
+
+    let(:messages) { [message(1), message(2), message(3)] }
+
+    it 'connects before the first write' do
+      expect(connection).to receive(:connect).once.ordered
+      expect(connection).to receive(:write).once.ordered
+      replies.push(reply_to(messages[0]))
+      multiplexer.send_and_receive(1, messages[0])
+    end
+
+    it 'returns the results and the node' do
+      replies.push(reply_to(messages[0]))
+      results, from = multiplexer.send_and_receive(1, messages[0])
+      expect(results[:docs]).to eq([1])
+      expect(from).to be(node)
+    end
+
+    it 'routes each reply to the thread that sent the request' do
+      threads = send_in_threads(messages)
+      messages.reverse.each { |message| replies.push(reply_to(message)) }
+      results = threads.map { |thread| thread.value[0][:docs] }
+      expect(results).to eq([[1], [2], [3]])
+    end
+
+    context 'when a waiting thread is interrupted' do
+
+      it 'drops the reply to its request' do
+        threads = send_in_threads(messages.take(2))
+        sleep(0.01) until threads.all? { |thread| thread.status == 'sleep' }
+        waiter = threads.find do |thread|
+          thread.backtrace.any? { |line| line =~ /[`'#]wait'/ }
+        end
+        waiter.raise(Timeout::Error)
+        expect { waiter.join }.to raise_error(Timeout::Error)
+        reader = (threads - [waiter]).first
+        replies.push(reply_to(messages[threads.index(waiter)]))
+        replies.push(reply_to(messages[threads.index(reader)]))
+        reader.join
+        expect(multiplexer.instance_variable_get(:@replies)).to be_empty
+        expect(multiplexer.instance_variable_get(:@abandoned)).to be_empty
+      end
+    end
+
+    context 'when reading a reply fails' do
+
+      before do
+        allow(connection).to receive(:read_reply) do
+          raise Mongo::SocketError if replies.pop == :error
+        end
+      end
+
+      it 'fails every request in flight' do
+        threads = send_in_threads(messages)
+        replies.push(:error)
+        threads.each do |thread|
+          expect { thread.join }.to raise_error(Mongo::SocketError)
+        end
+      end
+
+      it 'disconnects and reconnects on the next write' do
+        threads = send_in_threads(messages.take(1))
+        replies.push(:error)
+        expect { threads[0].join }.to raise_error(Mongo::SocketError)
+        expect(connection).to have_received(:disconnect)
+        expect(connection).to receive(:connect)
+        multiplexer.send(:dispatch, messages[1])
+      end
+    end
+  end
+end
@@ -0,0 +1,49 @@
+require 'spec_helper'
+
+describe Mongo::Pool::Socket::Resolver do
+
+  let(:addresses) do
+    [['AF_INET', 0, '127.0.0.1', '127.0.0.1', ::Socket::AF_INET, 1, 6]]
+  end
+
+  before do
+    described_class.clear
+    allow(::Socket).to receive(:getaddrinfo).and_return(addresses)
+  end
+
+  describe '.resolve' do
+
+    it 'resolves the host' do
+      expect(described_class.resolve('localhost')).to eq(addresses)
+    end
+
+    it 'reuses the addresses of a resolved host' do
+      described_class.resolve('localhost')
+      expect(::Socket).not_to receive(:getaddrinfo)
+      described_class.resolve('localhost')
+    end
+
+    context 'when the addresses have expired' do
+
+      it 'resolves the host again' do
+        described_class.resolve('localhost')
+        allow(Mongo::Pool::Socket::Base).to receive(:monotonic_time) do
+          Process.clock_gettime(Process::CLOCK_MONOTONIC) +
+            described_class::TTL
+        end
+        expect(::Socket).to receive(:getaddrinfo).and_return(addresses)
+        described_class.resolve('localhost')
+      end
+    end
+  end
+
+  describe '.forget' do
+
+    it 'resolves the host again on the next connection' do
+      described_class.resolve('localhost')
+      described_class.forget('localhost')
+      expect(::Socket).to receive(:getaddrinfo).and_return(addresses)
+      described_class.resolve('localhost')
+    end
+  end
+end
@@ -0,0 +1,139 @@
+require 'spec_helper'
+
+describe Mongo::Pool::Socket::SSLContext do
+
+  let(:context) { described_class.new(opts) }
+  let(:opts) { {} }
+
+  def ssl_socket(server, reused = false, version = 'TLSv1.2')
+    double(OpenSSL::SSL::SSLSocket).tap do |ssl_socket|
+      address = double(Addrinfo, :inspect_sockaddr => server)
+      allow(ssl_socket).to receive(:io) do
+        double(::Socket, :remote_address => address)
+      end
+      allow(ssl_socket).to receive(:session_reused?) { reused }
+      allow(ssl_socket).to receive(:ssl_version) { version }
+      allow(ssl_socket).to receive(:session=)
+    end
+  end
+
+  def negotiate(ssl_socket, session)
+    context.context.session_new_cb.call([ssl_socket, session])
+  end
+
+  describe '.get' do
+
+    it 'returns nil without ssl options' do
+      expect(described_class.get(:max_pool_size => 5)).to be_nil
+    end
+
+    it 'builds a context from the ssl options' do
+      expect(described_class.get(:ssl => true)).to be_a(described_class)
+    end
+
+    it 'returns nil when ssl is disabled' do
+      expect(described_class.get(:ssl => false, :ssl_verify => true)).to be_nil
+    end
+
+    it 'returns a provided context' do
+      shared = described_class.new
+      expect(described_class.get(:ssl_context => shared)).to be(shared)
+    end
+  end
+
+  describe '#initialize' do
+
+    it 'freezes the openssl context' do
+      expect(context.context).to be_frozen
+    end
+
+    it 'caches sessions on the client side' do
+      expect(context.context.session_cache_mode).to eq(
+        OpenSSL::SSL::SSLContext::SESSION_CACHE_CLIENT)
+    end
+
+    context 'when :ssl_cert is not nil' do
+
+      let(:opts) { { :ssl_cert => '/path/to/cert' } }
+
+      it 'reads the certificate file once' do
+        expect(File).to receive(:read).once.with('/path/to/cert') { '' }
+        expect(OpenSSL::X509::Certificate).to receive(:new).once
+        context
+      end
+    end
+
+    context 'when :ssl_ca_cert is not nil' do
+
+      let(:opts) { { :ssl_ca_cert => '/path/to/ca/file' } }
+
+      before do
+        allow_any_instance_of(OpenSSL::SSL::SSLContext).to receive(:setup)
+      end
+
+      it 'verifies the peer certificates against the ca file' do
+        expect(context).to be_verify
+        expect(context.context.ca_file).to eq('/path/to/ca/file')
+      end
+    end
+  end
+
+  describe '#resume' do
+
+    let(:session) { double(OpenSSL::SSL::Session) }
+
+    it 'offers the session negotiated with the same server' do
+      negotiate(ssl_socket('127.0.0.1:27017'), session)
+      resuming = ssl_socket('127.0.0.1:27017')
+      expect(resuming).to receive(:session=).with(session)
+      context.resume(resuming)
+    end
+
+    it 'does not offer the sessions of other servers' do
+      negotiate(ssl_socket('127.0.0.1:27017'), session)
+      resuming = ssl_socket('127.0.0.1:27018')
+      expect(resuming).to_not receive(:session=)
+      context.resume(resuming)
+    end
+
+    it 'offers each session once' do
+      negotiate(ssl_socket('127.0.0.1:27017'), session)
+      context.resume(ssl_socket('127.0.0.1:27017'))
+      resuming = ssl_socket('127.0.0.1:27017')
+      expect(resuming).to_not receive(:session=)
+      context.resume(resuming)
+    end
+  end
+
+  describe '#resumed' do
+
+    let(:session) { double(OpenSSL::SSL::Session) }
+
+    it 'keeps a resumed tls 1.2 session' do
+      resumed = ssl_socket('127.0.0.1:27017', true)
+      allow(resumed).to receive(:session) { session }
+      context.resumed(resumed)
+      resuming = ssl_socket('127.0.0.1:27017')
+      expect(resuming).to receive(:session=).with(session)
+      context.resume(resuming)
+    end
+
+    it 'drops a resumed tls 1.3 session' do
+      context.resumed(ssl_socket('127.0.0.1:27017', true, 'TLSv1.3'))
+      resuming = ssl_socket('127.0.0.1:27017')
+      expect(resuming).to_not receive(:session=)
+      context.resume(resuming)
+    end
+  end
+
+  describe '#clear' do
+
+    it 'forgets the kept sessions' do
+      negotiate(ssl_socket('127.0.0.1:27017'), double(OpenSSL::SSL::Session))
+      context.clear
+      resuming = ssl_socket('127.0.0.1:27017')
+      expect(resuming).to_not receive(:session=)
+      context.resume(resuming)
+    end
+  end
+end
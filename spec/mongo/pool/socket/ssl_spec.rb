@@ -9,9 +9,10 @@ describe Mongo::Pool::Socket::SSL do
   before do
     allow_any_instance_of(
       described_class).to receive(:connect).and_call_original
-    allow_any_instance_of(::Socket).to receive(:connect) { 0 }
-    allow_any_instance_of(OpenSSL::SSL::SSLSocket).to receive(:connect) { 0 }
-    allow(File).to receive(:open) { double(File) }
+    allow_any_instance_of(::Socket).to receive(:connect_nonblock) { 0 }
+    allow_any_instance_of(
+      OpenSSL::SSL::SSLSocket).to receive(:connect_nonblock) { 0 }
+    allow(File).to receive(:read) { '' }
   end
 
   describe '#initialize' do
@@ -90,18 +91,39 @@ describe Mongo::Pool::Socket::SSL do
 
         it 'sets SSL context the verify mode' do
           ssl_socket = described_class.new(host, port, timeout, opts)
-          ssl_context = ssl_socket.instance_variable_get(:@context)
+          ssl_context = ssl_socket.instance_variable_get(:@context).context
           expect(ssl_context.verify_mode).to eq(OpenSSL::SSL::VERIFY_PEER)
         end
 
       end
 
+      context 'when :ssl_context is provided' do
+
+        let(:context) { Mongo::Pool::Socket::SSLContext.new }
+        let(:opts) { { :ssl_context => context, :ssl_cert => '/path/to/cert' } }
+
+        it 'uses the shared context' do
+          expect(OpenSSL::X509::Certificate).to_not receive(:new)
+          ssl_socket = described_class.new(host, port, timeout, opts)
+          expect(ssl_socket.instance_variable_get(:@context)).to be(context)
+        end
+
+        it 'offers the sessions of the context for resumption' do
+          expect(context).to receive(:resume)
+          described_class.new(host, port, timeout, opts)
+        end
+      end
+
       context 'when :ssl_ca_cert is not nil' do
 
         let(:opts) do
           { :ssl_ca_cert => '/path/to/ca/file', :connect => false }
         end
 
+        before do
+          allow_any_instance_of(OpenSSL::SSL::SSLContext).to receive(:setup)
+        end
+
         it 'implies :ssl_verify => true' do
           ssl_socket = described_class.new(host, port, timeout, opts)
           ssl_verify = ssl_socket.instance_variable_get(:@ssl_verify)
@@ -119,12 +141,18 @@ describe Mongo::Pool::Socket::SSL do
     let(:ssl_socket) { described_class.new(host, port, 0.1) }
 
     it 'raises a Mongo::SocketTimeoutError on timeout' do
-      allow(ssl_socket).to receive(:handle_connect) { sleep 0.2 }
+      allow_any_instance_of(
+        OpenSSL::SSL::SSLSocket).to receive(:connect_nonblock) do
+        raise Errno::EAGAIN.new.extend(IO::WaitReadable)
+      end
+      allow_any_instance_of(::Socket).to receive(:wait_readable) { nil }
       expect { ssl_socket.connect }.to raise_error(Mongo::SocketTimeoutError)
     end
 
     it 're-raises exception after unsuccessful connect attempt' do
-      allow_any_instance_of(::Socket).to receive(:connect) { raise IOError }
+      allow_any_instance_of(::Socket).to receive(:connect_nonblock) do
+        raise IOError
+      end
       expect { ssl_socket.connect }.to raise_error(IOError)
     end
 
@@ -151,6 +179,47 @@ describe Mongo::Pool::Socket::SSL do
   let(:socket) { double(::Socket) }
   let(:object) { described_class.new(host, port, timeout) }
 
-  include_examples 'shared socket behavior'
+  context 'when the ssl socket is connected' do
+
+    let(:raw_socket) { double('socket') }
+    let(:ssl_socket) { double('ssl socket') }
+
+    before do
+      object.instance_variable_set(:@socket, raw_socket)
+      object.instance_variable_set(:@ssl_socket, ssl_socket)
+    end
+
+    it 'reads from the ssl socket' do
+      expect(ssl_socket).to receive(:read_nonblock) do |length, buffer|
+        buffer << 'data'
+      end
+      expect(raw_socket).not_to receive(:read_nonblock)
+      expect(object.read(4)).to eq('data')
+    end
+
+    it 'writes to the ssl socket' do
+      expect(ssl_socket).to receive(:write_nonblock).with('data') { 4 }
+      expect(raw_socket).not_to receive(:write_nonblock)
+      object.write('data')
+    end
+
+    it 'writes segments to the ssl socket' do
+      allow(raw_socket).to receive(:timeout=)
+      method =
+        Mongo::Pool::Socket::Base::VECTORED_WRITE ? :write : :write_nonblock
+      expect(ssl_socket).to receive(method) { 8 }
+      expect(raw_socket).not_to receive(method)
+      object.write('head', 'body')
+    end
+  end
+
+  context 'when the ssl socket passes the data through' do
+
+    before do
+      allow(object).to receive(:io) { object.instance_variable_get(:@socket) }
+    end
+
+    include_examples 'shared socket behavior'
+  end
 
 end
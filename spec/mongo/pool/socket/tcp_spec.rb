@@ -9,7 +9,7 @@ describe Mongo::Pool::Socket::TCP do
   before do
     allow_any_instance_of(
       described_class).to receive(:connect).and_call_original
-    allow_any_instance_of(::Socket).to receive(:connect) { 0 }
+    allow_any_instance_of(::Socket).to receive(:connect_nonblock) { 0 }
   end
 
   describe '#initialize' do
@@ -60,15 +60,80 @@ describe Mongo::Pool::Socket::TCP do
     end
 
     it 'raises a Mongo::SocketTimeoutError on timeout' do
-      allow(tcp_socket).to receive(:handle_connect) { sleep 0.2 }
-      expect { tcp_socket.connect }.to raise_error
+      allow_any_instance_of(::Socket).to receive(:connect_nonblock) do
+        raise Errno::EINPROGRESS.new.extend(IO::WaitWritable)
+      end
+      allow(IO).to receive(:select).and_return(nil)
+      expect { tcp_socket.connect }.to raise_error(Mongo::SocketTimeoutError)
     end
 
     it 're-raises exception after unsuccessful connect attempt' do
-      allow_any_instance_of(::Socket).to receive(:connect) { raise IOError }
+      allow_any_instance_of(::Socket).to receive(:connect_nonblock) do
+        raise IOError
+      end
       expect { tcp_socket.connect }.to raise_error(IOError)
     end
 
+    context 'when the host resolves to several addresses' do
+
+      let(:addresses) do
+        [
+          ['AF_INET6', 0, '::1', '::1', ::Socket::AF_INET6, 1, 6],
+          ['AF_INET6', 0, '::2', '::2', ::Socket::AF_INET6, 1, 6],
+          ['AF_INET', 0, '127.0.0.1', '127.0.0.1', ::Socket::AF_INET, 1, 6]
+        ]
+      end
+
+      let(:attempts) { [] }
+      let(:tcp_socket) do
+        described_class.new(host, port, 0.1, :connect => false)
+      end
+
+      before do
+        Mongo::Pool::Socket::Resolver.clear
+        allow(::Socket).to receive(:getaddrinfo).and_return(addresses)
+        allow(::Socket).to receive(:pack_sockaddr_in) { |_, ip| ip }
+        allow_any_instance_of(::Socket).to receive(:connect_nonblock) do |_, ip|
+          attempts << ip
+          raise Errno::ECONNREFUSED if ip == '::1'
+          0
+        end
+      end
+
+      it 'alternates between address families' do
+        tcp_socket.connect
+        expect(attempts).to eq(['::1', '127.0.0.1'])
+      end
+    end
+
+  end
+
+  describe '#write' do
+
+    context 'when the socket takes no IO timeout' do
+
+      let(:tcp_socket) { described_class.new(host, port, 0.1) }
+      let(:raw_socket) { double('socket') }
+
+      before do
+        tcp_socket.instance_variable_set(:@socket, raw_socket)
+      end
+
+      it 'writes the segments without blocking' do
+        expect(raw_socket).to receive(:write_nonblock).with('headbody') { 8 }
+        expect(raw_socket).not_to receive(:write)
+        expect(tcp_socket.write('head', 'body')).to eq(8)
+      end
+
+      it 'waits for a full send buffer within the timeout' do
+        allow(raw_socket).to receive(:write_nonblock) do
+          raise IO::EAGAINWaitWritable
+        end
+        expect(raw_socket).to receive(:wait_writable) { nil }
+        expect { tcp_socket.write('head', 'body') }.to raise_error(
+          Mongo::SocketTimeoutError)
+      end
+    end
   end
 
   let(:socket) { double(::Socket) }
@@ -8,7 +8,7 @@ describe Mongo::Pool::Socket::Unix do
   before do
     allow_any_instance_of(
       described_class).to receive(:connect).and_call_original
-    allow_any_instance_of(::Socket).to receive(:connect) { 0 }
+    allow_any_instance_of(::Socket).to receive(:connect_nonblock) { 0 }
     allow(File).to receive(:open) { double(File) }
   end
 
@@ -55,17 +55,80 @@ describe Mongo::Pool::Socket::Unix do
     let(:unix_socket) { described_class.new(path, 0.1) }
 
     it 'raises a Mongo::SocketTimeoutError on timeout' do
-      allow(unix_socket).to receive(:create_socket) { sleep 0.2 }
+      allow_any_instance_of(::Socket).to receive(:connect_nonblock) do
+        raise IO::EAGAINWaitWritable
+      end
+      allow_any_instance_of(::Socket).to receive(:wait_writable) { nil }
+      expect { unix_socket.connect }.to raise_error(Mongo::SocketTimeoutError)
+    end
+
+    it 'connects once the socket becomes writable' do
+      attempts = 0
+      allow_any_instance_of(::Socket).to receive(:connect_nonblock) do
+        attempts += 1
+        raise IO::EAGAINWaitWritable if attempts == 1
+        raise Errno::EISCONN
+      end
+      allow_any_instance_of(::Socket).to receive(:wait_writable) { true }
+      expect(unix_socket.connect).to be_a(::Socket)
+    end
+
+    it 'waits within the deadline of the operation' do
+      unix_socket.deadline = Mongo::Pool::Socket::Base.monotonic_time - 1
+      allow_any_instance_of(::Socket).to receive(:connect_nonblock) do
+        raise IO::EAGAINWaitWritable
+      end
+      expect_any_instance_of(::Socket).not_to receive(:wait_writable)
       expect { unix_socket.connect }.to raise_error(Mongo::SocketTimeoutError)
     end
 
     it 're-raises exception after unsuccessful connect attempt' do
-      allow_any_instance_of(::Socket).to receive(:connect) { raise IOError }
+      allow_any_instance_of(::Socket).to receive(:connect_nonblock) do
+        raise IOError
+      end
       expect { unix_socket.connect }.to raise_error(IOError)
     end
 
   end
 
+  describe '#read' do
+
+    context 'when running under a fiber scheduler' do
+
+      let(:pair) { UNIXSocket.pair }
+      let(:unix_socket) { described_class.new(path, timeout) }
+      let(:events) { [] }
+
+      before do
+        unix_socket.instance_variable_set(:@socket, pair.first)
+      end
+
+      after do
+        pair.each(&:close)
+      end
+
+      it 'lets other fibers run while waiting for data' do
+        data = nil
+        FiberScheduler.run do
+          Fiber.schedule { data = unix_socket.read(4); events << :read }
+          Fiber.schedule { events << :written; pair.last.write('pong') }
+        end
+        expect(data).to eq('pong')
+        expect(events).to eq([:written, :read])
+      end
+
+      it 'hands the wait over to the scheduler' do
+        waits = nil
+        FiberScheduler.run do |scheduler|
+          Fiber.schedule { unix_socket.read(4) }
+          Fiber.schedule { pair.last.write('pong') }
+          waits = scheduler.io_waits
+        end
+        expect(waits).to eq([:read])
+      end
+    end
+  end
+
   let(:socket) { double(::Socket) }
   let(:object) { described_class.new(path, timeout) }
 
@@ -0,0 +1,76 @@
+require 'spec_helper'
+
+describe Mongo::Protocol::Serializers::BitVector do
+
+  let(:vector) { described_class.new([:first, :second, :third]) }
+  let(:buffer) { ''.force_encoding('BINARY') }
+
+  def decode(bits)
+    vector.deserialize(StringIO.new([bits].pack('l<')))
+  end
+
+  describe '#serialize' do
+
+    it 'encodes a list of flags' do
+      vector.serialize(buffer, [:first, :third])
+      expect(buffer).to eq([5].pack('l<'))
+    end
+
+    it 'encodes no flag' do
+      vector.serialize(buffer, [])
+      expect(buffer).to eq([0].pack('l<'))
+    end
+
+    it 'encodes flags' do
+      vector.serialize(buffer, vector.flags([:second]))
+      expect(buffer).to eq([2].pack('l<'))
+    end
+
+    it 'raises an error for an unknown flag' do
+      expect { vector.serialize(buffer, [:fourth]) }.to raise_error(KeyError)
+    end
+  end
+
+  describe '#deserialize' do
+
+    let(:flags) { decode(6) }
+
+    it 'decodes the flags that are set' do
+      expect(flags).to eq([:second, :third])
+    end
+
+    it 'defines a predicate for each flag' do
+      expect(flags.second?).to be_true
+      expect(flags.first?).to be_false
+    end
+
+    it 'returns the same frozen flags for the same vector' do
+      expect(flags).to be(decode(6))
+      expect(flags).to be_frozen
+    end
+
+    it 'ignores bits outside the layout' do
+      expect(decode(-1)).to eq([:first, :second, :third])
+    end
+
+    it 'is equal to the array of the flags either way' do
+      expect([:second, :third] == flags).to be_true
+      expect(flags).to eql([:second, :third])
+    end
+
+    it 'hashes like the array of the flags' do
+      expect(flags.hash).to eq([:second, :third].hash)
+    end
+  end
+
+  describe '#flags' do
+
+    it 'returns the flags of a list of flags' do
+      expect(vector.flags([:first]).bits).to eq(1)
+    end
+
+    it 'returns empty flags for no flag' do
+      expect(vector.flags([])).to be_empty
+    end
+  end
+end
@@ -0,0 +1,159 @@
+require 'spec_helper'
+
+describe Mongo::Protocol::Compression do
+
+  let(:compressor) { described_class.get('zlib') }
+  let(:compression) { described_class.new(compressor, 64) }
+  let(:document) { { 'pad' => 'x' * 1024 } }
+  let(:message) do
+    Mongo::Protocol::Insert.new('xgen', 'users', [document]).serialize
+  end
+  let(:small) { Mongo::Protocol::Query.new('xgen', 'users', {}).serialize }
+
+  describe '.get' do
+
+    it 'returns a new compressor for a registered name' do
+      expect(described_class.get('zlib')).to be_a(described_class::Zlib)
+    end
+
+    it 'returns nil for an unknown name' do
+      expect(described_class.get('lz4')).to be_nil
+    end
+  end
+
+  describe '.available' do
+
+    it 'keeps the registered compressors in order' do
+      expect(described_class.available([:lz4, 'zlib'])).to eq(['zlib'])
+    end
+  end
+
+  describe '.register' do
+
+    let(:custom) { double('compressor') }
+
+    before do
+      described_class.register('custom') { custom }
+    end
+
+    it 'makes the compressor available' do
+      expect(described_class.get('custom')).to be(custom)
+    end
+  end
+
+  describe '#compress' do
+
+    let(:compressed) { compression.compress(message) }
+
+    it 'wraps the message in a compressed message' do
+      expect(described_class.compressed?(compressed)).to be_true
+      expect(compressed.bytesize).to be < message.bytesize
+    end
+
+    it 'sets the length of the compressed message' do
+      expect(compressed.unpack('l<').first).to eq(compressed.bytesize)
+    end
+
+    it 'keeps the original op code and request id' do
+      fields = compressed.unpack('l<l<l<l<l<l<C')
+      expect(fields[1]).to eq(message.unpack('l<l<').last)
+      expect(fields[4]).to eq(2002)
+      expect(fields[5]).to eq(message.bytesize - 16)
+      expect(fields[6]).to eq(described_class::Zlib::ID)
+    end
+
+    context 'when the message is below the threshold' do
+
+      it 'returns the message uncompressed' do
+        expect(compression.compress(small)).to equal(small)
+      end
+    end
+
+    context 'when several messages are provided' do
+
+      let(:compressed) { compression.compress(message + small + message) }
+
+      it 'only compresses the messages above the threshold' do
+        first = compressed.unpack('l<').first
+        rest = compressed.byteslice(first..-1)
+        expect(rest.byteslice(0, small.bytesize)).to eq(small)
+        tail = rest.byteslice(small.bytesize..-1)
+        expect(compression.decompress(tail)).to eq(message)
+      end
+    end
+  end
+
+  describe '#compress_segments' do
+
+    let(:large) { { 'pad' => 'x' * 8192 }.to_bson }
+    let(:buffer) { Mongo::Protocol::WriteBuffer.new }
+    let(:insert) { Mongo::Protocol::Insert.new('xgen', 'users', [large]) }
+    let(:query) { Mongo::Protocol::Query.new('xgen', 'users', {}) }
+    let(:sizes) { [] }
+    let(:compressed) { compression.compress_segments(buffer.segments, sizes) }
+
+    before do
+      insert.serialize(buffer)
+      query.serialize(buffer)
+    end
+
+    def messages(data)
+      offset = 0
+      messages = []
+      while offset < data.bytesize
+        length = data.byteslice(offset, 4).unpack('l<').first
+        messages << compression.decompress(data.byteslice(offset, length))
+        offset += length
+      end
+      messages
+    end
+
+    it 'compresses the messages above the threshold' do
+      expect(described_class.compressed?(compressed.first)).to be_true
+      expect(messages(compressed.join).join).to eq(buffer.segments.join)
+    end
+
+    it 'streams the spliced documents through the compressor' do
+      parts = []
+      allow(compressor).to receive(:compress_parts) do |message_parts|
+        parts.concat(message_parts)
+        Zlib::Deflate.deflate(message_parts.join)
+      end
+      compressed
+      expect(parts.any? { |part| part.equal?(large) }).to be_true
+    end
+
+    it 'reports the size each message is written with' do
+      compressed
+      expect(sizes).to eq(
+        [compressed.first.bytesize, query.serialize.bytesize])
+    end
+  end
+
+  describe '#decompress' do
+
+    it 'restores the original message' do
+      compressed = compression.compress(message)
+      expect(compression.decompress(compressed)).to eq(message)
+    end
+
+    it 'returns an uncompressed message unchanged' do
+      expect(compression.decompress(small)).to equal(small)
+    end
+
+    context 'when the compressor id does not match' do
+
+      let(:compressed) do
+        data = compression.compress(message)
+        data.setbyte(24, 1)
+        data
+      end
+
+      it 'raises a socket error' do
+        expect do
+          compression.decompress(compressed)
+        end.to raise_error(Mongo::SocketError)
+      end
+    end
+  end
+end
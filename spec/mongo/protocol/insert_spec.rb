@@ -37,6 +37,57 @@ describe Mongo::Protocol::Insert do
     end
   end
 
+  describe '.batches' do
+    let(:bson) { doc1.to_bson }
+    let(:limits) do
+      { :max_bson_object_size => bson.bytesize,
+        :max_message_size => 21 + ns.bytesize + bson.bytesize * 2 }
+    end
+    let(:batches) do
+      [].tap do |inserts|
+        described_class.batches(db, coll, [doc1] * 5, limits) do |insert|
+          inserts << insert
+        end
+      end
+    end
+
+    it 'splits the documents into messages within the maximum size' do
+      expect(batches.map { |insert| insert.documents.size }).to eq([2, 2, 1])
+    end
+
+    it 'encodes each document' do
+      expect(batches.first.documents).to eq([bson, bson])
+    end
+
+    context 'when a document is already encoded' do
+
+      it 'inserts the document bytes' do
+        described_class.batches(db, coll, [bson], limits) do |insert|
+          expect(insert.documents).to eq([bson])
+        end
+      end
+    end
+
+    context 'when flags are provided' do
+
+      it 'sets the flags on each message' do
+        opts = limits.merge(:flags => [:continue_on_error])
+        described_class.batches(db, coll, [doc1], opts) do |insert|
+          expect(insert.flags).to eq([:continue_on_error])
+        end
+      end
+    end
+
+    context 'when a document exceeds the maximum document size' do
+
+      it 'raises an error' do
+        expect do
+          described_class.batches(db, coll, [doc2], limits) {}
+        end.to raise_error(described_class::DocumentTooLarge)
+      end
+    end
+  end
+
   describe '#==' do
 
     context 'when the other is an insert' do
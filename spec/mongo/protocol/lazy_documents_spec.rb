@@ -0,0 +1,74 @@
+require 'spec_helper'
+
+describe Mongo::Protocol::LazyDocuments do
+
+  let(:documents) { [{ 'name' => 'Tyler' }, { 'name' => 'Emily' }] }
+  let(:bytes) { documents.map(&:to_bson).join }
+  let(:raw) { false }
+  let(:lazy) { described_class.new(bytes, documents.size, raw) }
+
+  describe '#[]' do
+
+    it 'decodes the document at the index' do
+      expect(lazy[1]).to eq(documents[1])
+    end
+
+    it 'returns nil past the last document' do
+      expect(lazy[2]).to be_nil
+    end
+
+    context 'when raw' do
+      let(:raw) { true }
+
+      it 'returns the bson for the document' do
+        expect(lazy[1]).to be_bson(documents[1])
+      end
+    end
+  end
+
+  describe '#raw' do
+
+    it 'returns the bson for the document' do
+      expect(lazy.raw(0)).to be_bson(documents[0])
+    end
+  end
+
+  describe '#raw!' do
+
+    it 'returns the bson for documents from then on' do
+      expect(lazy.raw![1]).to be_bson(documents[1])
+    end
+  end
+
+  describe '#shift' do
+
+    it 'returns the next document' do
+      expect(lazy.shift).to eq(documents[0])
+      expect(lazy.shift).to eq(documents[1])
+    end
+
+    it 'removes the document' do
+      lazy.shift
+      expect(lazy.size).to eq(1)
+    end
+
+    it 'is empty once all documents are shifted' do
+      2.times { lazy.shift }
+      expect(lazy).to be_empty
+    end
+  end
+
+  describe '#each' do
+
+    it 'yields each document' do
+      expect { |b| lazy.each(&b) }.to yield_successive_args(*documents)
+    end
+  end
+
+  describe '#==' do
+
+    it 'compares the decoded documents' do
+      expect(lazy).to eq(documents)
+    end
+  end
+end
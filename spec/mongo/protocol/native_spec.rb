@@ -0,0 +1,107 @@
+require 'spec_helper'
+
+# The native extension replaces the methods of the serializers when it
+# loads, so the pure Ruby serializers are loaded again into a module of
+# their own to compare against.
+native = Mongo::Protocol::Serializers::Int32.method(:serialize).
+  source_location.nil?
+
+describe 'the native serializers', :if => native do
+
+  let(:pure) do
+    Module.new.tap do |mod|
+      %w(serializers bit_vector).each do |file|
+        path = File.expand_path(
+          "../../../../lib/mongo/protocol/#{file}.rb", __FILE__)
+        mod.module_eval(File.read(path), path)
+      end
+    end
+  end
+
+  let(:native_serializers) { Mongo::Protocol::Serializers }
+  let(:pure_serializers) { pure::Mongo::Protocol::Serializers }
+
+  def buffer
+    'head'.force_encoding('BINARY')
+  end
+
+  def encode(serializers, name, value)
+    serializers.const_get(name).serialize(buffer, value)
+  end
+
+  def decode(serializers, name, bytes)
+    serializers.const_get(name).deserialize(StringIO.new(bytes))
+  end
+
+  def expect_equivalent(name, values)
+    values.each do |value|
+      bytes = encode(pure_serializers, name, value)
+      expect(encode(native_serializers, name, value)).to eq(bytes)
+      next unless pure_serializers.const_get(name).respond_to?(:deserialize)
+      expect(decode(native_serializers, name, bytes[4..-1])).to eq(
+        decode(pure_serializers, name, bytes[4..-1]))
+    end
+  end
+
+  it 'encodes and decodes headers like the Ruby serializers' do
+    expect_equivalent(:Header, [[16, 1, 0, 2004], [2**31 - 1, -1, -2**31, 1]])
+  end
+
+  it 'encodes C strings like the Ruby serializers' do
+    expect_equivalent(:CString, ['', 'test.users', 'test.$cmd'])
+  end
+
+  it 'encodes zeros like the Ruby serializers' do
+    expect_equivalent(:Zero, [nil, 1])
+  end
+
+  it 'encodes and decodes 32-bit integers like the Ruby serializers' do
+    expect_equivalent(:Int32, [0, 1, -1, 2**31 - 1, -2**31])
+  end
+
+  it 'overwrites 32-bit integers like the Ruby serializers' do
+    [0, 1, -1, 2**31 - 1, -2**31].each do |value|
+      expect(native_serializers::Int32.serialize_at(buffer, 0, value)).to eq(
+        pure_serializers::Int32.serialize_at(buffer, 0, value))
+    end
+  end
+
+  it 'encodes and decodes 64-bit integers like the Ruby serializers' do
+    expect_equivalent(:Int64, [0, 1, -1, 2**32, 2**63 - 1, -2**63])
+  end
+
+  context 'when encoding bit vectors' do
+
+    let(:layout) { [:first, :second, :third] }
+    let(:native_vector) { native_serializers::BitVector.new(layout) }
+    let(:pure_vector) { pure_serializers::BitVector.new(layout) }
+
+    let(:values) do
+      [[], [:first], [:third, :first], [:first, :second, :third]]
+    end
+
+    it 'encodes lists of flags like the Ruby serializers' do
+      values.each do |value|
+        expect(native_vector.serialize(buffer, value)).to eq(
+          pure_vector.serialize(buffer, value))
+      end
+    end
+
+    it 'encodes flags like the Ruby serializers' do
+      values.each do |value|
+        expect(native_vector.serialize(buffer, native_vector.flags(value))).
+          to eq(pure_vector.serialize(buffer, pure_vector.flags(value)))
+      end
+    end
+
+    it 'decodes flags like the Ruby serializers' do
+      [0, 1, 5, 7, 8, -1].each do |bits|
+        bytes = [bits].pack('l<')
+        decoded = native_vector.deserialize(StringIO.new(bytes))
+        expected = pure_vector.deserialize(StringIO.new(bytes))
+        expect(decoded.bits).to eq(expected.bits)
+        expect(decoded.to_a).to eq(expected.to_a)
+      end
+    end
+  end
+end
@@ -19,6 +19,17 @@ describe Mongo::Protocol::Query do
       expect(message.namespace).to eq(ns)
     end
 
+    context 'when the namespace is given whole' do
+
+      let(:message) do
+        described_class.new(ns.freeze, nil, selector, opts)
+      end
+
+      it 'uses the namespace as is' do
+        expect(message.namespace).to be(ns)
+      end
+    end
+
     it 'sets the selector' do
       expect(message.selector).to eq(selector)
     end
@@ -127,6 +127,32 @@ describe Mongo::Protocol::Reply do
         it 'sets multiple flags' do
           expect(reply.flags).to include(:query_failure, :await_capable)
         end
+
+        it 'answers the predicate of each flag' do
+          expect(reply.flags.query_failure?).to be_true
+          expect(reply.flags.cursor_not_found?).to be_false
+        end
+      end
+    end
+
+    describe 'response to' do
+      let(:response_to) { 42 }
+
+      it 'sets the response to attribute' do
+        expect(reply.response_to).to eq(response_to)
+      end
+
+      context 'when lazy' do
+        let(:reply) { described_class.deserialize(io, :lazy => true) }
+
+        it 'sets the response to attribute' do
+          expect(reply.response_to).to eq(response_to)
+        end
+      end
+
+      it 'does not keep the header on the class' do
+        reply
+        expect(described_class.instance_variable_get(:@response_to)).to be_nil
       end
     end
 
@@ -153,5 +179,55 @@ describe Mongo::Protocol::Reply do
         expect(reply.documents).to eq(documents)
       end
     end
+
+    context 'when lazy' do
+      let(:reply) { described_class.deserialize(io, :lazy => true) }
+
+      it 'sets the cursor id attribute' do
+        expect(reply.cursor_id).to eq(cursor_id)
+      end
+
+      it 'does not decode the documents' do
+        expect(reply.documents).to be_a(Mongo::Protocol::LazyDocuments)
+      end
+
+      it 'decodes the documents on access' do
+        expect(reply.documents[1]).to eq(doc)
+      end
+    end
+
+    context 'when raw' do
+      let(:reply) { described_class.deserialize(io, :raw => true) }
+
+      it 'returns the documents as bson' do
+        expect(reply.documents[0]).to be_bson(doc)
+      end
+    end
+  end
+
+  describe '.deserialize_body' do
+
+    let(:decoded_header) { header.unpack('l<l<l<l<') }
+
+    it 'deserializes the reply from its header and body' do
+      expect(
+        described_class.deserialize_body(decoded_header, data)).to eq(reply)
+    end
+
+    context 'when lazy' do
+
+      let(:lazy) do
+        described_class.deserialize_body(decoded_header, data, :lazy => true)
+      end
+
+      it 'sets the header fields' do
+        expect(lazy.cursor_id).to eq(cursor_id)
+        expect(lazy.number_returned).to eq(n_returned)
+      end
+
+      it 'decodes the documents from the body' do
+        expect(lazy.documents.to_a).to eq(documents)
+      end
+    end
   end
 end
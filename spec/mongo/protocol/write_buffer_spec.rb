@@ -0,0 +1,133 @@
+require 'spec_helper'
+
+describe Mongo::Protocol::WriteBuffer do
+
+  let(:buffer) { described_class.new }
+  let(:large) { 'x' * described_class::MIN_SPLICE_SIZE }
+
+  describe '#initialize' do
+
+    it 'creates an empty binary buffer' do
+      expect(buffer).to be_empty
+      expect(buffer.encoding).to eq(Encoding::BINARY)
+    end
+  end
+
+  describe '#splice' do
+
+    context 'when the bytes are small' do
+
+      it 'copies the bytes into the buffer' do
+        buffer.splice('abc')
+        expect(buffer).to eq('abc')
+        expect(buffer.spliced_bytesize).to eq(0)
+      end
+    end
+
+    context 'when the bytes are large' do
+
+      it 'does not copy the bytes into the buffer' do
+        buffer.splice(large)
+        expect(buffer).to be_empty
+        expect(buffer.spliced_bytesize).to eq(large.bytesize)
+      end
+    end
+  end
+
+  describe '#spliced_bytesize' do
+
+    before do
+      buffer << 'head'
+      buffer.splice(large)
+    end
+
+    it 'counts every spliced byte by default' do
+      expect(buffer.spliced_bytesize).to eq(large.bytesize)
+    end
+
+    it 'counts the bytes spliced after the offset' do
+      expect(buffer.spliced_bytesize(3)).to eq(large.bytesize)
+    end
+
+    it 'ignores the bytes spliced at the offset' do
+      expect(buffer.spliced_bytesize(4)).to eq(0)
+    end
+
+    it 'ignores the bytes spliced before the offset' do
+      expect(buffer.spliced_bytesize(5)).to eq(0)
+    end
+  end
+
+  context 'when a message follows one ending in a spliced document' do
+
+    let(:document) { { 'x' => large }.to_bson }
+    let(:query) { Mongo::Protocol::Query.new(TEST_DB, TEST_COLL, {}) }
+
+    let(:insert) do
+      Mongo::Protocol::Insert.new(TEST_DB, TEST_COLL, [document])
+    end
+    let(:bytes) { buffer.segments.join }
+
+    before do
+      insert.serialize(buffer)
+      query.serialize(buffer)
+    end
+
+    def length_at(offset)
+      bytes.byteslice(offset, 4).unpack('l<').first
+    end
+
+    it 'counts the spliced document in the first message' do
+      expect(length_at(0)).to eq(bytes.bytesize - query.serialize.bytesize)
+    end
+
+    it 'does not count it in the next message' do
+      expect(length_at(length_at(0))).to eq(query.serialize.bytesize)
+    end
+  end
+
+  describe '#segments' do
+
+    context 'when nothing was spliced' do
+
+      it 'returns the buffer' do
+        buffer << 'abc'
+        expect(buffer.segments).to eq([buffer])
+      end
+    end
+
+    context 'when bytes were spliced' do
+
+      before do
+        buffer << 'head'
+        buffer.splice(large)
+        buffer << 'tail'
+      end
+
+      it 'returns the segments in order' do
+        expect(buffer.segments).to eq(['head', large, 'tail'])
+      end
+
+      it 'returns the spliced bytes without copying them' do
+        expect(buffer.segments[1]).to equal(large)
+      end
+    end
+  end
+
+  describe '#reset' do
+
+    before do
+      buffer << 'head'
+      buffer.splice(large)
+      buffer.reset
+    end
+
+    it 'empties the buffer' do
+      expect(buffer).to be_empty
+    end
+
+    it 'removes the splices' do
+      expect(buffer.segments).to eq([buffer])
+    end
+  end
+end
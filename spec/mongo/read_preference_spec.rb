@@ -0,0 +1,183 @@
+require 'spec_helper'
+
+describe Mongo::ReadPreference do
+
+  def node(description, round_trip_time = 0.001)
+    double('node').tap do |node|
+      allow(node).to receive(:replica_set_name) { description['setName'] }
+      allow(node).to receive(:primary?) { !!description['ismaster'] }
+      allow(node).to receive(:secondary?) { !!description['secondary'] }
+      allow(node).to receive(:tags) { description['tags'] || {} }
+      allow(node).to receive(:round_trip_time) { round_trip_time }
+    end
+  end
+
+  let(:primary) { node('setName' => 'rs', 'ismaster' => true) }
+  let(:near) do
+    node('setName' => 'rs', 'secondary' => true, 'tags' => { 'dc' => 'ny' })
+  end
+  let(:far) do
+    node({ 'setName' => 'rs', 'secondary' => true, 'tags' => { 'dc' => 'sf' } },
+         0.080)
+  end
+  let(:nodes) { [primary, near, far] }
+
+  let(:tags) { [] }
+  let(:read) { described_class.new(mode, tags) }
+
+  describe '.get' do
+
+    it 'returns a primary read preference for nil' do
+      expect(described_class.get(nil)).to be_primary
+    end
+
+    it 'returns a read preference for a mode' do
+      expect(described_class.get(:nearest)).to be_nearest
+    end
+
+    it 'returns a read preference for uri read options' do
+      read = described_class.get(:mode => :secondary, :tags => [{ :dc => 1 }])
+      expect(read).to eq(described_class.new(:secondary, [{ :dc => 1 }]))
+    end
+
+    it 'returns a read preference unchanged' do
+      read = described_class.new(:secondary)
+      expect(described_class.get(read)).to be(read)
+    end
+  end
+
+  describe '#initialize' do
+
+    it 'raises an error for an unknown mode' do
+      expect { described_class.new(:fastest) }.to raise_error(ArgumentError)
+    end
+  end
+
+  describe '#mongos' do
+
+    context 'when the mode is primary' do
+      let(:mode) { :primary }
+
+      it 'returns nil' do
+        expect(read.mongos).to be_nil
+      end
+    end
+
+    context 'when the mode is secondary preferred with tags' do
+      let(:mode) { :secondary_preferred }
+      let(:tags) { [{ 'dc' => 'ny' }] }
+
+      it 'returns the mode and tags' do
+        expect(read.mongos).to eq(:mode => 'secondaryPreferred', :tags => tags)
+      end
+    end
+  end
+
+  describe '#select_node' do
+
+    let(:selected) do
+      Array.new(20) { read.select_node(nodes, 15) }.uniq
+    end
+
+    context 'when the mode is primary' do
+      let(:mode) { :primary }
+
+      it 'selects the primary' do
+        expect(selected).to eq([primary])
+      end
+
+      context 'when there is no primary' do
+        let(:nodes) { [near, far] }
+
+        it 'selects no node' do
+          expect(selected).to eq([nil])
+        end
+      end
+    end
+
+    context 'when the mode is primary preferred' do
+      let(:mode) { :primary_preferred }
+
+      context 'when there is no primary' do
+        let(:nodes) { [near, far] }
+
+        it 'selects the nearest secondary' do
+          expect(selected).to eq([near])
+        end
+      end
+    end
+
+    context 'when the mode is secondary' do
+      let(:mode) { :secondary }
+
+      it 'selects the secondaries within the local threshold' do
+        expect(selected).to eq([near])
+      end
+
+      context 'when tag sets are provided' do
+        let(:tags) { [{ 'dc' => 'la' }, { :dc => 'sf' }] }
+
+        it 'selects from the first tag set that matches' do
+          expect(selected).to eq([far])
+        end
+      end
+
+      context 'when no tag set matches' do
+        let(:tags) { [{ 'dc' => 'la' }] }
+
+        it 'selects no node' do
+          expect(selected).to eq([nil])
+        end
+      end
+    end
+
+    context 'when the mode is secondary preferred' do
+      let(:mode) { :secondary_preferred }
+
+      context 'when there are no secondaries' do
+        let(:nodes) { [primary] }
+
+        it 'selects the primary' do
+          expect(selected).to eq([primary])
+        end
+      end
+    end
+
+    context 'when the mode is nearest' do
+      let(:mode) { :nearest }
+
+      it 'selects randomly within the local threshold' do
+        expect(selected).to match_array([primary, near])
+      end
+    end
+
+    context 'when the node is not a replica set member' do
+      let(:mode) { :secondary }
+      let(:standalone) { node('ismaster' => true) }
+      let(:nodes) { [standalone] }
+
+      it 'selects the node for every mode' do
+        expect(selected).to eq([standalone])
+      end
+    end
+  end
+
+  describe '#select_nodes' do
+
+    context 'when the mode is nearest' do
+      let(:mode) { :nearest }
+
+      it 'selects every node within the local threshold' do
+        expect(read.select_nodes(nodes, 15)).to eq([primary, near])
+      end
+    end
+
+    context 'when the mode is secondary' do
+      let(:mode) { :secondary }
+
+      it 'selects every secondary within a wide enough threshold' do
+        expect(read.select_nodes(nodes, 100)).to eq([near, far])
+      end
+    end
+  end
+end
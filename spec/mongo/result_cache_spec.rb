@@ -0,0 +1,117 @@
+require 'spec_helper'
+
+describe Mongo::ResultCache do
+
+  let(:client) { Mongo::Client.new(['127.0.0.1:27017'], :database => :test) }
+  let(:collection) { client[:users] }
+  let(:cache) { described_class.new(64) }
+  let(:documents) { ['a' * 8, 'b' * 8] }
+
+  def scope(selector = {})
+    Mongo::Scope.new(collection, selector)
+  end
+
+  describe '#fetch' do
+
+    it 'returns the documents from the block' do
+      expect(cache.fetch(scope, 5) { documents }).to eq(documents)
+    end
+
+    it 'freezes the documents' do
+      expect(cache.fetch(scope, 5) { documents }.all?(&:frozen?)).to be_true
+    end
+
+    it 'counts the size of the documents' do
+      cache.fetch(scope, 5) { documents }
+      expect(cache.size).to eq(16)
+    end
+
+    context 'when the documents of an equal scope are cached' do
+
+      before { cache.fetch(scope, 5) { documents } }
+
+      it 'does not call the block' do
+        expect { |b| cache.fetch(scope, 5, &b) }.not_to yield_control
+      end
+
+      it 'returns the cached documents' do
+        expect(cache.fetch(scope, 5) { [] }).to eq(documents)
+      end
+    end
+
+    context 'when the cached documents expired' do
+
+      before do
+        allow(Mongo::Pool::Socket::Base).to receive(:monotonic_time).and_return(
+          0, 10)
+        cache.fetch(scope, 5) { documents }
+      end
+
+      it 'calls the block again' do
+        expect(cache.fetch(scope, 5) { [] }).to eq([])
+      end
+    end
+
+    context 'when the documents do not fit in the cache' do
+
+      it 'evicts the least recently used documents' do
+        cache.fetch(scope(:n => 1), 5) { documents }
+        cache.fetch(scope(:n => 2), 5) { documents }
+        cache.fetch(scope(:n => 1), 5) { [] }
+        cache.fetch(scope(:n => 3), 5) { ['c' * 40] }
+        expect(cache.fetch(scope(:n => 1), 5) { [] }).to eq(documents)
+        expect(cache.fetch(scope(:n => 2), 5) { [] }).to eq([])
+      end
+    end
+
+    context 'when the documents are larger than the cache' do
+
+      it 'does not cache them' do
+        cache.fetch(scope, 5) { ['c' * 80] }
+        expect(cache.size).to eq(0)
+      end
+    end
+
+    context 'when the scope is modified afterwards' do
+
+      it 'keeps the documents under the scope as it was' do
+        cached = scope
+        cache.fetch(cached, 5) { documents }
+        cached.limit!(1)
+        expect(cache.fetch(scope, 5) { [] }).to eq(documents)
+      end
+    end
+  end
+
+  describe '#invalidate' do
+
+    it 'drops the cached documents of the namespace' do
+      cache.fetch(scope, 5) { documents }
+      cache.invalidate(collection.full_namespace)
+      expect(cache.fetch(scope, 5) { [] }).to eq([])
+    end
+
+    it 'keeps the cached documents of other namespaces' do
+      cache.fetch(scope, 5) { documents }
+      cache.invalidate(client[:posts].full_namespace)
+      expect(cache.fetch(scope, 5) { [] }).to eq(documents)
+    end
+
+    it 'does not cache documents read before the invalidation' do
+      cache.fetch(scope, 5) do
+        cache.invalidate(collection.full_namespace)
+        documents
+      end
+      expect(cache.size).to eq(0)
+    end
+  end
+
+  describe '#clear' do
+
+    it 'drops every cached document' do
+      cache.fetch(scope, 5) { documents }
+      cache.clear
+      expect(cache.size).to eq(0)
+    end
+  end
+end
@@ -0,0 +1,130 @@
+require 'spec_helper'
+
+describe Mongo::Scope::ParallelScan do
+
+  include_context 'shared client'
+
+  let(:selector) { {} }
+  let(:scope) { Mongo::Scope.new(collection, selector) }
+  let(:scan) { described_class.new(scope, 4) }
+  let(:nodes) { [double('node'), double('node')] }
+  let(:bounds) { [0, 399] }
+  let(:queried) { [] }
+  let(:cursors) { [] }
+
+  let(:cluster) do
+    double('cluster').tap do |cluster|
+      allow(cluster).to receive(:select_nodes) { nodes }
+    end
+  end
+
+  def cursor_for(partition)
+    range = partition.selector['_id'] || {}
+    first = range['$gte'] || 0
+    last = range['$lt'] ? range['$lt'] - 1 : range['$lte'] || 399
+    docs = (first..last).map { |id| { '_id' => id } }
+    double('cursor').tap do |cursor|
+      allow(cursor).to receive(:to_enum) { docs.each }
+      allow(cursor).to receive(:close)
+      cursors << cursor
+    end
+  end
+
+  before do
+    allow(client).to receive(:cluster) { cluster }
+    allow(scan).to receive(:bound) do |direction|
+      direction == 1 ? bounds.first : bounds.last
+    end
+    allow(Mongo::Cursor).to receive(:new) do |partition, node|
+      queried << [partition.selector, node]
+      cursor_for(partition)
+    end
+  end
+
+  describe '#initialize' do
+
+    it 'raises an error for a count below one' do
+      expect do
+        described_class.new(scope, 0)
+      end.to raise_error(ArgumentError)
+    end
+
+    it 'raises an error for a scope with a limit' do
+      expect do
+        described_class.new(scope.limit(10), 2)
+      end.to raise_error(ArgumentError)
+    end
+  end
+
+  describe '#each' do
+
+    let(:ids) do
+      [].tap { |ids| scan.each { |doc| ids << doc['_id'] } }
+    end
+
+    it 'yields every document once' do
+      expect(ids.sort).to eq((0..399).to_a)
+    end
+
+    it 'runs a cursor per range of ids' do
+      ids
+      ranges = queried.map { |selector, _| selector['_id'] }
+      expect(ranges.first).to eq('$gte' => 0, '$lt' => 100)
+      expect(ranges.last).to eq('$gte' => 300, '$lte' => 399)
+    end
+
+    it 'spreads the cursors over the nodes' do
+      ids
+      expect(queried.map(&:last).uniq).to match_array(nodes)
+    end
+
+    context 'when the scope has a selector' do
+
+      let(:selector) { { 'name' => 'Emily' } }
+
+      it 'queries each range within the selector' do
+        ids
+        expect(queried.first[0]['$and'][0]).to eq(selector)
+      end
+    end
+
+    context 'when the ids cannot be split' do
+
+      let(:bounds) { ['a', 'z'] }
+
+      it 'runs a single cursor' do
+        expect(ids.size).to eq(400)
+        expect(queried.size).to eq(1)
+      end
+    end
+
+    context 'when a cursor fails' do
+
+      before do
+        allow(Mongo::Cursor).to receive(:new) { raise Mongo::SocketError }
+      end
+
+      it 'raises the error' do
+        expect { scan.each {} }.to raise_error(Mongo::SocketError)
+      end
+    end
+
+    context 'when the block breaks out of the scan' do
+
+      it 'closes every cursor' do
+        scan.each { |doc| break doc }
+        expect(cursors.size).to eq(4)
+        cursors.each { |cursor| expect(cursor).to have_received(:close) }
+      end
+    end
+
+    context 'when no node is eligible' do
+
+      let(:nodes) { [] }
+
+      it 'raises a no node error' do
+        expect { scan.each {} }.to raise_error(Mongo::Client::NoNode)
+      end
+    end
+  end
+end
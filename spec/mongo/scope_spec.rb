@@ -131,6 +131,72 @@ describe Mongo::Scope do
     end
   end
 
+  describe '#await_data' do
+    let(:opts) { { :await_data => false } }
+
+    context 'when await data is specified' do
+
+      it 'sets the await data option' do
+        expect(scope.await_data(true).await_data).to be(true)
+      end
+
+      it 'returns a new Scope' do
+        expect(scope.await_data(true)).not_to be(scope)
+      end
+    end
+
+    context 'when await data is not specified' do
+
+      it 'returns the await data option' do
+        expect(scope.await_data).to eq(opts[:await_data])
+      end
+    end
+  end
+
+  describe '#await_data!' do
+
+    context 'when await data is specified' do
+
+      it 'sets the await data option on the same Scope' do
+        scope.await_data!(true)
+        expect(scope.await_data).to be(true)
+      end
+    end
+  end
+
+  describe '#exhaust' do
+    let(:opts) { { :exhaust => false } }
+
+    context 'when exhaust is specified' do
+
+      it 'sets the exhaust option' do
+        expect(scope.exhaust(true).exhaust).to be(true)
+      end
+
+      it 'returns a new Scope' do
+        expect(scope.exhaust(true)).not_to be(scope)
+      end
+    end
+
+    context 'when exhaust is not specified' do
+
+      it 'returns the exhaust option' do
+        expect(scope.exhaust).to eq(opts[:exhaust])
+      end
+    end
+  end
+
+  describe '#exhaust!' do
+
+    context 'when exhaust is specified' do
+
+      it 'sets the exhaust option on the same Scope' do
+        scope.exhaust!(true)
+        expect(scope.exhaust).to be(true)
+      end
+    end
+  end
+
   describe '#fields' do
 
     context 'when fields are specified' do
@@ -283,6 +349,138 @@ describe Mongo::Scope do
     end
   end
 
+  describe '#oplog_replay' do
+    let(:opts) { { :oplog_replay => false } }
+
+    context 'when oplog replay is specified' do
+
+      it 'sets the oplog replay option' do
+        expect(scope.oplog_replay(true).oplog_replay).to be(true)
+      end
+
+      it 'returns a new Scope' do
+        expect(scope.oplog_replay(true)).not_to be(scope)
+      end
+    end
+
+    context 'when oplog replay is not specified' do
+
+      it 'returns the oplog replay option' do
+        expect(scope.oplog_replay).to eq(opts[:oplog_replay])
+      end
+    end
+  end
+
+  describe '#oplog_replay!' do
+
+    context 'when oplog replay is specified' do
+
+      it 'sets the oplog replay option on the same Scope' do
+        scope.oplog_replay!(true)
+        expect(scope.oplog_replay).to be(true)
+      end
+    end
+  end
+
+  describe '#prefetch' do
+    let(:opts) { { :prefetch => 1 } }
+
+    context 'when a prefetch is specified' do
+
+      it 'sets the prefetch' do
+        expect(scope.prefetch(2).prefetch).to eq(2)
+      end
+
+      it 'returns a new Scope' do
+        expect(scope.prefetch(2)).not_to be(scope)
+      end
+    end
+
+    context 'when a prefetch is not specified' do
+
+      it 'returns the prefetch' do
+        expect(scope.prefetch).to eq(opts[:prefetch])
+      end
+    end
+  end
+
+  describe '#prefetch!' do
+
+    context 'when a prefetch is specified' do
+
+      it 'sets the prefetch on the same Scope' do
+        scope.prefetch!(2)
+        expect(scope.prefetch).to eq(2)
+      end
+    end
+  end
+
+  describe '#raw' do
+    let(:opts) { { :raw => false } }
+
+    context 'when raw is specified' do
+
+      it 'sets the raw option' do
+        expect(scope.raw(true).raw).to be(true)
+      end
+
+      it 'returns a new Scope' do
+        expect(scope.raw(true)).not_to be(scope)
+      end
+    end
+
+    context 'when raw is not specified' do
+
+      it 'returns the raw option' do
+        expect(scope.raw).to eq(opts[:raw])
+      end
+    end
+  end
+
+  describe '#raw!' do
+
+    context 'when raw is specified' do
+
+      it 'sets the raw option on the same Scope' do
+        scope.raw!(true)
+        expect(scope.raw).to be(true)
+      end
+    end
+  end
+
+  describe '#cache' do
+    let(:opts) { { :cache => 5 } }
+
+    context 'when a time to live is specified' do
+
+      it 'sets the cache option' do
+        expect(scope.cache(10).cache).to eq(10)
+      end
+
+      it 'returns a new Scope' do
+        expect(scope.cache(10)).not_to be(scope)
+      end
+    end
+
+    context 'when a time to live is not specified' do
+
+      it 'returns the cache option' do
+        expect(scope.cache).to eq(opts[:cache])
+      end
+    end
+  end
+
+  describe '#cache!' do
+
+    context 'when a time to live is specified' do
+
+      it 'sets the cache option on the same Scope' do
+        scope.cache!(10)
+        expect(scope.cache).to eq(10)
+      end
+    end
+  end
+
   describe '#read' do
 
     context 'when a read pref is specified' do
@@ -367,6 +565,39 @@ describe Mongo::Scope do
     end
   end
 
+  describe '#tailable' do
+    let(:opts) { { :tailable => false } }
+
+    context 'when tailable is specified' do
+
+      it 'sets the tailable option' do
+        expect(scope.tailable(true).tailable).to be(true)
+      end
+
+      it 'returns a new Scope' do
+        expect(scope.tailable(true)).not_to be(scope)
+      end
+    end
+
+    context 'when tailable is not specified' do
+
+      it 'returns the tailable option' do
+        expect(scope.tailable).to eq(opts[:tailable])
+      end
+    end
+  end
+
+  describe '#tailable!' do
+
+    context 'when tailable is specified' do
+
+      it 'sets the tailable option on the same Scope' do
+        scope.tailable!(true)
+        expect(scope.tailable).to be(true)
+      end
+    end
+  end
+
   describe '#query_opts' do
 
     context 'when query_opts are specified' do
@@ -585,6 +816,87 @@ describe Mongo::Scope do
           end
         end
       end
+
+      context 'when the docs are cached' do
+        let(:opts) { { :cache => 5 } }
+        let(:docs) { (0...n_docs).map { |i| { 'n' => i } } }
+        let(:results) do
+          { :cursor_id => 0,
+            :nreturned => n_docs,
+            :docs => docs.map(&:to_bson)
+          }
+        end
+        let(:result_cache) { Mongo::ResultCache.new(1024) }
+
+        before do
+          allow(client).to receive(:result_cache) { result_cache }
+        end
+
+        it 'queries the docs once' do
+          expect(connection).to receive(:send_and_receive).once do
+            [results, node]
+          end
+          2.times { scope.each.to_a }
+        end
+
+        it 'decodes the docs' do
+          expect(scope.each.to_a).to eq(docs)
+        end
+
+        context 'when raw docs are requested' do
+          let(:opts) { { :cache => 5, :raw => true } }
+
+          it 'returns the BSON bytes of the docs' do
+            expect(scope.each.to_a).to eq(docs.map(&:to_bson))
+          end
+
+          it 'shares the cached docs with the decoding scope' do
+            expect(connection).to receive(:send_and_receive).once do
+              [results, node]
+            end
+            scope.each.to_a
+            expect(scope.raw(false).each.to_a).to eq(docs)
+          end
+        end
+
+        context 'when the client has no result cache' do
+          let(:result_cache) { nil }
+
+          it 'queries the docs every time' do
+            expect(connection).to receive(:send_and_receive).twice do
+              [results, node]
+            end
+            2.times { scope.each.to_a }
+          end
+        end
+      end
+    end
+  end
+
+  describe '#parallel_each' do
+
+    let(:scan) { double('parallel scan') }
+
+    it 'scans with the provided number of cursors' do
+      expect(Mongo::Scope::ParallelScan).to receive(:new).with(
+        scope, 4).and_return(scan)
+      expect(scan).to receive(:each).and_yield(1)
+      expect { |b| scope.parallel_each(4, &b) }.to yield_with_args(1)
+    end
+
+    context 'when no block is given' do
+
+      it 'returns an enumerator of the documents' do
+        expect(Mongo::Scope::ParallelScan).to receive(:new).with(
+          scope, 4).and_return(scan)
+        expect(scan).to receive(:each).and_yield(1).and_yield(2)
+        expect(scope.parallel_each(4).to_a).to eq([1, 2])
+      end
+
+      it 'does not start the scan' do
+        expect(Mongo::Scope::ParallelScan).not_to receive(:new)
+        scope.parallel_each(4)
+      end
     end
   end
 
@@ -333,6 +333,49 @@ describe Mongo::URI do
       end
     end
 
+    context 'localThresholdMS' do
+      let(:threshold) { 35 }
+      let(:options) { "localThresholdMS=#{threshold}" }
+
+      it 'sets the local threshold' do
+        expect(uri.options[:local_threshold]).to eq(threshold)
+      end
+    end
+
+    context 'serverSelectionTimeoutMS' do
+      let(:timeout) { 5000 }
+      let(:options) { "serverSelectionTimeoutMS=#{timeout}" }
+
+      it 'sets the server selection timeout' do
+        expect(uri.options[:server_selection_timeout]).to eq(timeout)
+      end
+    end
+
+    context 'heartbeatFrequencyMS' do
+      let(:frequency) { 2000 }
+      let(:options) { "heartbeatFrequencyMS=#{frequency}" }
+
+      it 'sets the heartbeat frequency' do
+        expect(uri.options[:heartbeat_frequency]).to eq(frequency)
+      end
+    end
+
+    context 'compressors' do
+      let(:options) { 'compressors=snappy,zlib' }
+
+      it 'sets the compressors in order of preference' do
+        expect(uri.options[:compressors]).to eq(%w(snappy zlib))
+      end
+    end
+
+    context 'zlibCompressionLevel' do
+      let(:options) { 'zlibCompressionLevel=6' }
+
+      it 'sets the zlib compression level' do
+        expect(uri.options[:zlib_compression_level]).to eq(6)
+      end
+    end
+
     context 'ssl' do
       let(:options) { "ssl=#{ssl}" }
 
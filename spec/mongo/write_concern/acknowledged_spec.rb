@@ -41,4 +41,27 @@ describe Mongo::WriteConcern::Acknowledged do
       end
     end
   end
+
+  describe '#encoded_get_last_error' do
+
+    let(:concern) do
+      described_class.new(:w => 2, :j => true)
+    end
+
+    it 'returns the bson bytes of the gle command' do
+      expect(concern.encoded_get_last_error).to eq(
+        concern.get_last_error.to_bson
+      )
+    end
+
+    it 'encodes the command once' do
+      expect(concern.encoded_get_last_error).to be(
+        concern.encoded_get_last_error
+      )
+    end
+
+    it 'freezes the bytes' do
+      expect(concern.encoded_get_last_error).to be_frozen
+    end
+  end
 end
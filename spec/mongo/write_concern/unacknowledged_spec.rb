@@ -12,4 +12,11 @@ describe Mongo::WriteConcern::Unacknowledged do
       expect(concern.get_last_error).to be_nil
     end
   end
+
+  describe '#encoded_get_last_error' do
+
+    it 'returns nil' do
+      expect(concern.encoded_get_last_error).to be_nil
+    end
+  end
 end
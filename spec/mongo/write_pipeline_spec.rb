@@ -0,0 +1,89 @@
+require 'spec_helper'
+
+describe Mongo::WritePipeline do
+
+  let(:client) { Mongo::Client.new(['127.0.0.1:27017']) }
+  let(:database) { Mongo::Database.new(client, :test) }
+  let(:collection) { Mongo::Collection.new(database, :users) }
+  let(:pipeline) { described_class.new(collection) }
+  let(:connection) { double('connection') }
+
+  before do
+    allow(client).to receive(:with_node).and_yield(connection)
+  end
+
+  describe '#insert' do
+
+    it 'queues an insert message' do
+      pipeline.insert([{ :name => 'Emily' }])
+      expect(pipeline.writes.first).to be_a(Mongo::Protocol::Insert)
+    end
+
+    it 'returns the pipeline' do
+      expect(pipeline.insert([{ :name => 'Emily' }])).to be(pipeline)
+    end
+  end
+
+  describe '#update' do
+
+    it 'queues an update message' do
+      pipeline.update({ :name => 'Tyler' }, { :name => 'Bob' })
+      expect(pipeline.writes.first).to be_a(Mongo::Protocol::Update)
+    end
+  end
+
+  describe '#delete' do
+
+    it 'queues a delete message' do
+      pipeline.delete({ :name => 'Durran' })
+      expect(pipeline.writes.first).to be_a(Mongo::Protocol::Delete)
+    end
+  end
+
+  describe '#execute' do
+
+    let(:ok) { double('reply', :documents => [{ 'err' => nil }]) }
+    let(:failed) { double('reply', :documents => [{ 'err' => 'E11000' }]) }
+
+    before do
+      pipeline.insert([{ :name => 'Emily' }])
+      pipeline.delete({ :name => 'Durran' })
+    end
+
+    context 'when the write concern is acknowledged' do
+
+      before do
+        allow(connection).to receive(:receive_replies).and_return([failed, ok])
+      end
+
+      it 'writes each message followed by its get last error' do
+        expect(connection).to receive(:write) do |messages|
+          expect(messages.map(&:class)).to eq([
+            Mongo::Protocol::Insert, Mongo::Protocol::Query,
+            Mongo::Protocol::Delete, Mongo::Protocol::Query
+          ])
+        end
+        pipeline.execute
+      end
+
+      it 'returns the result of each write' do
+        allow(connection).to receive(:write)
+        expect(pipeline.execute).to eq([{ 'err' => 'E11000' },
+                                        { 'err' => nil }])
+      end
+    end
+
+    context 'when the write concern is unacknowledged' do
+
+      let(:client) do
+        Mongo::Client.new(['127.0.0.1:27017'], :write => { :w => 0 })
+      end
+
+      it 'only writes the messages' do
+        expect(connection).to receive(:write).with(pipeline.writes)
+        expect(connection).not_to receive(:receive_replies)
+        expect(pipeline.execute).to eq([nil, nil])
+      end
+    end
+  end
+end
@@ -22,6 +22,7 @@ end
 require 'mongo'
 require 'support/helpers'
 require 'support/matchers'
+require 'support/fiber_scheduler'
 require 'rspec/autorun'
 
 RSpec.configure do |config|
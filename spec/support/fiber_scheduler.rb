@@ -0,0 +1,117 @@
+# A minimal fiber scheduler, to check that the driver's waits hand over to
+# the scheduler rather than blocking the whole thread.
+#
+# @example
+#   FiberScheduler.run do |scheduler|
+#     Fiber.schedule { socket.read(4) }
+#     Fiber.schedule { peer.write('pong') }
+#   end
+class FiberScheduler
+
+  # @return [Array<Symbol>] The modes of the IO waits handed over.
+  attr_reader :io_waits
+
+  # Runs the block in a new thread with a scheduler set, then runs the
+  # scheduled fibers until they all finish.
+  #
+  # @yieldparam scheduler [FiberScheduler] The scheduler.
+  def self.run
+    Thread.new do
+      scheduler = new
+      Fiber.set_scheduler(scheduler)
+      begin
+        yield(scheduler)
+      ensure
+        Fiber.set_scheduler(nil)
+      end
+    end.join
+  end
+
+  def initialize
+    @io_waits = []
+    @readable = {}
+    @writable = {}
+    @sleeping = {}
+    @unblocked = []
+    @lock = Mutex.new
+    @wakeup, @waker = IO.pipe
+  end
+
+  def fiber(&block)
+    Fiber.new(:blocking => false, &block).tap(&:resume)
+  end
+
+  def io_wait(io, events, timeout)
+    readable = events & IO::READABLE != 0
+    @io_waits.push(readable ? :read : :write)
+    (readable ? @readable : @writable)[Fiber.current] = io
+    @sleeping[Fiber.current] = deadline(timeout)
+    Fiber.yield
+  end
+
+  def kernel_sleep(duration = nil)
+    @sleeping[Fiber.current] = deadline(duration)
+    Fiber.yield
+  end
+
+  def block(blocker, timeout = nil)
+    @sleeping[Fiber.current] = deadline(timeout)
+    Fiber.yield
+  end
+
+  def unblock(blocker, fiber)
+    @lock.synchronize { @unblocked.push(fiber) }
+    @waker.write_nonblock('.', :exception => false)
+  end
+
+  def close
+    run
+    @wakeup.close
+    @waker.close
+  end
+
+  private
+
+  def run
+    until @sleeping.empty?
+      readable, writable = IO.select(@readable.values + [@wakeup],
+                                     @writable.values, [], timeout)
+      @wakeup.read_nonblock(64, :exception => false)
+      woken = @lock.synchronize { @unblocked.slice!(0..-1) }
+      woken.each { |fiber| resume(fiber, true) }
+      ready(@readable, readable, IO::READABLE)
+      ready(@writable, writable, IO::WRITABLE)
+      now = monotonic_time
+      @sleeping.select { |_, at| at && at <= now }.each_key do |fiber|
+        resume(fiber, false)
+      end
+    end
+  end
+
+  def ready(waiting, ios, event)
+    waiting.select { |_, io| ios && ios.include?(io) }.each_key do |fiber|
+      resume(fiber, event)
+    end
+  end
+
+  def resume(fiber, result)
+    return unless @sleeping.key?(fiber)
+    @sleeping.delete(fiber)
+    @readable.delete(fiber)
+    @writable.delete(fiber)
+    fiber.resume(result)
+  end
+
+  def timeout
+    deadlines = @sleeping.values.compact
+    deadlines.empty? ? nil : [deadlines.min - monotonic_time, 0].max
+  end
+
+  def deadline(timeout)
+    timeout && monotonic_time + timeout
+  end
+
+  def monotonic_time
+    Process.clock_gettime(Process::CLOCK_MONOTONIC)
+  end
+end
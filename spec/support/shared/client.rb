@@ -26,9 +26,6 @@ shared_context 'shared client' do
 
   let(:collection) do
     db[TEST_COLL].tap do |collection|
-      allow(collection).to receive(:full_namespace) do
-        "#{db.name}.#{collection.name}"
-      end
       allow(collection).to receive(:client) { client }
       allow(collection).to receive(:read) { read_obj }
     end
@@ -43,6 +40,7 @@ shared_context 'shared client' do
   let(:node) do
     double('node').tap do |node|
       allow(node).to receive(:with_connection).and_yield(connection)
+      allow(node).to receive(:kill_cursor)
     end
   end
 end
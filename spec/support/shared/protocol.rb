@@ -14,6 +14,20 @@ shared_examples 'message with a header' do
       end
     end
 
+    describe 'request ids' do
+      let(:ids) do
+        Array.new(4) do
+          Thread.new do
+            Array.new(3) { message.dup.tap(&:serialize).request_id }
+          end
+        end.map(&:value).flatten
+      end
+
+      it 'are unique across threads' do
+        expect(ids.uniq.size).to eq(ids.size)
+      end
+    end
+
     describe 'response to' do
       let(:field) { bytes[8..11] }
       it 'serializes the response to' do
@@ -1,40 +1,74 @@
 shared_examples 'shared socket behavior' do
 
   describe '#read' do
-    before { allow(socket).to receive(:read).and_return(Object.new) }
+    before { allow(socket).to receive(:read_nonblock).and_return(Object.new) }
 
-    context 'when an exception occurs in Socket#read' do
+    context 'when an exception occurs in Socket#read_nonblock' do
       before do
         allow(object).to receive(:alive?).and_return(true)
         object.connect
       end
 
       it 'raises a Mongo::SocketTimeoutError for Errno::ETIMEDOUT' do
-        allow_any_instance_of(::Socket).to receive(:read) do
+        allow_any_instance_of(::Socket).to receive(:read_nonblock) do
           raise Errno::ETIMEDOUT
         end
         expect { object.read(4096) }.to raise_error(Mongo::SocketTimeoutError)
       end
 
       it 'raises a Mongo::SocketError for IOError' do
-        allow_any_instance_of(::Socket).to receive(:read) { raise IOError }
+        allow_any_instance_of(::Socket).to receive(:read_nonblock) do
+          raise IOError
+        end
         expect { object.read(4096) }.to raise_error(Mongo::SocketError)
       end
 
       it 'raises a Mongo::SocketError for SystemCallError' do
-        allow_any_instance_of(::Socket).to receive(:read) do
+        allow_any_instance_of(::Socket).to receive(:read_nonblock) do
           raise SystemCallError, 'Oh god. Everything is ruined.'
         end
         expect { object.read(4096) }.to raise_error(Mongo::SocketError)
       end
 
       it 'raises a Mongo::SocketError for OpenSSL::SSL::SSLError' do
-        allow_any_instance_of(::Socket).to receive(:read) do
+        allow_any_instance_of(::Socket).to receive(:read_nonblock) do
           raise OpenSSL::SSL::SSLError
         end
         expect { object.read(4096) }.to raise_error(Mongo::SocketError)
       end
     end
+
+    context 'when no data arrives before the deadline' do
+      before do
+        allow(object).to receive(:alive?).and_return(true)
+        object.connect
+        object.deadline = Mongo::Pool::Socket::Base.monotonic_time
+        allow_any_instance_of(::Socket).to receive(:read_nonblock) do
+          raise Errno::EAGAIN.new.extend(IO::WaitReadable)
+        end
+      end
+
+      it 'raises a Mongo::SocketTimeoutError' do
+        expect_any_instance_of(::Socket).to receive(:wait_readable).with(
+          0).and_return(nil)
+        expect { object.read(4096) }.to raise_error(Mongo::SocketTimeoutError)
+      end
+    end
+
+    context 'when the data arrives in parts' do
+      before do
+        allow(object).to receive(:alive?).and_return(true)
+        object.connect
+        parts = ['ab', 'cd']
+        allow_any_instance_of(::Socket).to receive(:read_nonblock) do
+          parts.shift
+        end
+      end
+
+      it 'reads until the length is reached' do
+        expect(object.read(4)).to eq('abcd')
+      end
+    end
   end
 
   describe '#write' do
@@ -42,14 +76,14 @@ shared_examples 'shared socket behavior' do
 
     before { allow(socket).to receive(:write).and_return(1024) }
 
-    context 'when an exception occurs in Socket#write' do
+    context 'when an exception occurs in Socket#write_nonblock' do
       before do
         allow(object).to receive(:alive?).and_return(true)
         object.connect
       end
 
       it 'raises a Mongo::SocketTimeoutError for Errno::ETIMEDOUT' do
-        allow_any_instance_of(::Socket).to receive(:write) do
+        allow_any_instance_of(::Socket).to receive(:write_nonblock) do
           raise Errno::ETIMEDOUT
         end
 
@@ -59,24 +93,60 @@ shared_examples 'shared socket behavior' do
       end
 
       it 'raises a Mongo::SocketError for IOError' do
-        allow_any_instance_of(::Socket).to receive(:write) { raise IOError }
+        allow_any_instance_of(::Socket).to receive(:write_nonblock) do
+          raise IOError
+        end
         expect { object.write(payload) }.to raise_error(Mongo::SocketError)
       end
 
       it 'raises a Mongo::SocketError for SystemCallError' do
-        allow_any_instance_of(::Socket).to receive(:write) do
+        allow_any_instance_of(::Socket).to receive(:write_nonblock) do
           raise SystemCallError, 'Oh god. Everything is ruined.'
         end
         expect { object.write(payload) }.to raise_error(Mongo::SocketError)
       end
 
       it 'raises a Mongo::SocketError for OpenSSL::SSL::SSLError' do
-        allow_any_instance_of(::Socket).to receive(:write) do
+        allow_any_instance_of(::Socket).to receive(:write_nonblock) do
           raise OpenSSL::SSL::SSLError
         end
         expect { object.write(payload) }.to raise_error(Mongo::SocketError)
       end
     end
+
+    context 'when several segments are provided' do
+      let(:vectored) do
+        Mongo::Pool::Socket::Base::VECTORED_WRITE &&
+          ::Socket.method_defined?(:timeout=)
+      end
+
+      let(:segments) { vectored ? ['a', 'b'] : ['ab'] }
+
+      before do
+        allow(object).to receive(:alive?).and_return(true)
+        object.connect
+      end
+
+      let(:write_method) { vectored ? :write : :write_nonblock }
+
+      it 'writes the segments with a single write' do
+        expect_any_instance_of(::Socket).to receive(write_method).once.with(
+          *segments).and_return(2)
+        expect(object.write('a', 'b')).to eq(2)
+      end
+    end
+  end
+
+  describe '#close' do
+    before do
+      allow(object).to receive(:alive?).and_return(true)
+      object.connect
+    end
+
+    it 'closes the socket' do
+      expect_any_instance_of(::Socket).to receive(:close)
+      object.close
+    end
   end
 
 end